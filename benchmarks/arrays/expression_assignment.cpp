@@ -0,0 +1,76 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// A = a * B + C * D for double and complex arrays of rank 3 :
+// element by element evaluation (foreach) vs the flat loop, with 1, 2, 4, ... OpenMP threads.
+// Usage : expression_assignment [number of elements]
+#define TRIQS_ARRAYS_PARALLEL_ASSIGNMENT_THRESHOLD 100000
+#include <triqs/arrays.hpp>
+#include <chrono>
+#include <iostream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace triqs::arrays;
+using dcomplex = std::complex<double>;
+
+template <typename F> double timeit(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+}
+
+template <typename T> void bench(long n) {
+  long n1 = n / 1000;
+  T a     = 2;
+  array<T, 3> A(n1, 10, 100), B(n1, 10, 100), C(n1, 10, 100), D(n1, 10, 100);
+  long i = 0;
+  for (auto &x : B) x = std::cos(++i);
+  C = B * 2 + 1;
+  D = -B;
+
+  double t_foreach = timeit([&] { foreach (A, [&](long i, long j, long k) { A(i, j, k) = a * B(i, j, k) + C(i, j, k) * D(i, j, k); }); });
+  std::cout << "foreach : " << t_foreach << "\nthreads  flat loop  speedup" << std::endl;
+
+#ifdef _OPENMP
+  int max_threads = omp_get_max_threads();
+#else
+  int max_threads = 1;
+#endif
+  for (int n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads);
+#endif
+    double t_flat = timeit([&] { A = a * B + C * D; });
+    std::cout << n_threads << "        " << t_flat << "      " << t_foreach / t_flat << std::endl;
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(max_threads);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+  long n = (argc > 1 ? std::stol(argv[1]) : 10000000);
+  std::cout << "double" << std::endl;
+  bench<double>(n);
+  std::cout << "complex" << std::endl;
+  bench<dcomplex>(n);
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// Product and inverse of N x N matrices, N <= small_matrix::max_dim :
+// fixed-size kernels (used by A * B and inverse(A)) vs direct blas/lapack calls.
+// Usage : small_matrix [number of repetitions]
+#include <triqs/arrays.hpp>
+#include <triqs/arrays/linalg/det_and_inverse.hpp>
+#include <triqs/arrays/blas_lapack/gemm.hpp>
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace triqs::arrays;
+using dcomplex = std::complex<double>;
+
+template <typename F> double timeit(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+}
+
+template <typename T> void bench(int n, long n_rep) {
+  std::mt19937 rng(n);
+  std::uniform_real_distribution<double> dist(-1, 1);
+  matrix<T> A(n, n), B(n, n), C(n, n);
+  for (auto &x : A) x = dist(rng);
+  for (auto &x : B) x = dist(rng);
+  for (int i = 0; i < n; ++i) A(i, i) += n; // well conditioned
+
+  double t_gemm_kernel = timeit([&] {
+    for (long r = 0; r < n_rep; ++r) small_matrix::gemm(A, B, C);
+  });
+  double t_gemm_blas = timeit([&] {
+    for (long r = 0; r < n_rep; ++r) blas::gemm(1.0, A, B, 0.0, C);
+  });
+
+  double t_inv_kernel = timeit([&] {
+    for (long r = 0; r < n_rep; ++r) {
+      C = A;
+      C = inverse(C);
+    }
+  });
+  vector<int> ipiv(n);
+  double t_inv_lapack = timeit([&] {
+    for (long r = 0; r < n_rep; ++r) {
+      C = A;
+      lapack::getrf(C, ipiv);
+      lapack::getri(C, ipiv);
+    }
+  });
+
+  std::cout << n << "    " << t_gemm_blas / t_gemm_kernel << "      " << t_inv_lapack / t_inv_kernel << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  long n_rep = (argc > 1 ? std::stol(argv[1]) : 100000);
+  for (auto [name, f] : {std::make_pair("double", bench<double>), std::make_pair("complex", bench<dcomplex>)}) {
+    std::cout << name << "\nN    speedup gemm    speedup inverse" << std::endl;
+    for (int n = 2; n <= small_matrix::max_dim; ++n) f(n, n_rep);
+  }
+}
@@ -0,0 +1,67 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// Dyson equation G = (iw + mu - eps_k - Sigma)^-1 on a (iw, k) mesh, for several matrix sizes :
+// invert_in_place(gf) (batched) vs a loop over the mesh points of v = inverse(v).
+// Usage : gf_inverse [n_k] [n_iw]
+#include <triqs/gfs.hpp>
+#include <chrono>
+#include <iostream>
+
+using namespace triqs::gfs;
+using namespace triqs::lattice;
+using triqs::arrays::matrix_view;
+
+template <typename F> double timeit(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+}
+
+int main(int argc, char *argv[]) {
+
+  int n_k  = (argc > 1 ? std::stoi(argv[1]) : 16);
+  int n_iw = (argc > 2 ? std::stoi(argv[2]) : 64);
+  auto bz  = brillouin_zone{bravais_lattice{{{1, 0}, {0, 1}}}};
+
+  std::cout << "n      loop over mesh   batched   speedup" << std::endl;
+  for (int n : {1, 2, 4, 8, 16, 32}) {
+    auto G = gf<cartesian_product<imfreq, brillouin_zone>>{{{10, Fermion, n_iw}, {bz, n_k}}, {n, n}};
+    for (auto [w, k] : G.mesh()) {
+      G[w, k] = w - 2 * (cos(k(0)) + cos(k(1)));
+      for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j) G[w, k](i, j) += 0.1 / (1 + i + j);
+    }
+
+    auto G_loop = G;
+    double t_loop = timeit([&] {
+      for (auto [w, k] : G.mesh()) {
+        matrix_view<dcomplex> v = G_loop[w, k];
+        v                       = triqs::arrays::inverse(v);
+      }
+    });
+
+    auto G_batch   = G;
+    double t_batch = timeit([&] { invert_in_place(G_batch); });
+
+    if (max_element(abs(G_batch.data() - G_loop.data())) > 1e-8) std::cerr << "Error : results differ" << std::endl;
+    std::cout << n << "      " << t_loop << "      " << t_batch << "      " << t_loop / t_batch << std::endl;
+  }
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// Write and read throughput of a large complex array, G(k, iw) like, for several h5::write_policy.
+// Usage : write_policy [n_k] [n_iw]
+#include <triqs/arrays.hpp>
+#include <triqs/h5.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sys/stat.h>
+
+using namespace triqs;
+using namespace triqs::arrays;
+using dcomplex = std::complex<double>;
+
+template <typename F> double timeit(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+}
+
+int main(int argc, char *argv[]) {
+
+  int n_k  = (argc > 1 ? std::stoi(argv[1]) : 1024);
+  int n_iw = (argc > 2 ? std::stoi(argv[2]) : 1024);
+
+  array<dcomplex, 3> G(n_k, n_iw, 2);
+  for (int k = 0; k < n_k; ++k)
+    for (int n = 0; n < n_iw; ++n) {
+      double w = M_PI * (2 * n + 1) / 10;
+      for (int s = 0; s < 2; ++s) G(k, n, s) = 1 / (1_j * w - std::cos(2 * M_PI * k / n_k) - 0.1 * s);
+    }
+  double mb = G.size() * sizeof(dcomplex) / 1e6;
+
+  std::vector<std::pair<std::string, h5::write_policy>> policies = {{"default (deflate 8, 1 chunk)", {}},
+                                                                    {"no compression", h5::write_policy::no_compression()},
+                                                                    {"deflate 1, shuffle, 1 MB chunks", h5::write_policy::compressed(1)},
+                                                                    {"deflate 4, shuffle, 1 MB chunks", h5::write_policy::compressed(4)}};
+
+  std::cout << mb << " MB\npolicy                            write (MB/s)  read (MB/s)  file (MB)" << std::endl;
+  for (auto const &[name, p] : policies) {
+    double t_write = timeit([&, &p = p] {
+      h5::file f{"bench_write_policy.h5", 'w'};
+      f.set_write_policy(p);
+      h5_write(f, "G", G);
+    });
+
+    array<dcomplex, 3> R;
+    double t_read = timeit([&] {
+      h5::file f{"bench_write_policy.h5", 'r'};
+      h5_read(f, "G", R);
+    });
+    if (max_element(abs(R - G)) > 0) std::cerr << "Error : read a different array" << std::endl;
+
+    struct stat st;
+    stat("bench_write_policy.h5", &st);
+    std::cout << name << "      " << mb / t_write << "      " << mb / t_read << "      " << st.st_size / 1e6 << std::endl;
+  }
+  std::remove("bench_write_policy.h5");
+}
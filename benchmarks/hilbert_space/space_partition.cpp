@@ -0,0 +1,93 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// Automatic partitioning of the Fock space of a Kanamori Hamiltonian with n_orb orbitals,
+// as done by atom_diag : Phase I (H), Phase II (all c^+, c), and the mappings of c^+.
+// Usage : space_partition [max number of orbitals]
+#include <triqs/hilbert_space/fundamental_operator_set.hpp>
+#include <triqs/hilbert_space/hilbert_space.hpp>
+#include <triqs/hilbert_space/state.hpp>
+#include <triqs/hilbert_space/imperative_operator.hpp>
+#include <triqs/hilbert_space/space_partition.hpp>
+#include <triqs/operators/many_body_operator.hpp>
+#include <chrono>
+#include <iostream>
+
+using namespace triqs::hilbert_space;
+using namespace triqs::operators;
+
+template <typename F> double timeit(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+}
+
+many_body_operator kanamori(int n_orb, double U, double J) {
+  many_body_operator H;
+  for (int o = 0; o < n_orb; ++o) H += U * n("up", o) * n("dn", o);
+  for (int o1 = 0; o1 < n_orb; ++o1)
+    for (int o2 = 0; o2 < n_orb; ++o2) {
+      if (o1 == o2) continue;
+      H += (U - 2 * J) * n("up", o1) * n("dn", o2);
+      if (o2 < o1) H += (U - 3 * J) * (n("up", o1) * n("up", o2) + n("dn", o1) * n("dn", o2));
+      H += -J * c_dag("up", o1) * c_dag("dn", o1) * c("up", o2) * c("dn", o2);
+      H += -J * c_dag("up", o1) * c_dag("dn", o2) * c("up", o2) * c("dn", o1);
+      H += 0.1 * (c_dag("up", o1) * c("up", o2) + c_dag("dn", o1) * c("dn", o2)); // hopping
+    }
+  return H;
+}
+
+int main(int argc, char *argv[]) {
+
+  int max_n_orb = (argc > 1 ? std::stoi(argv[1]) : 7);
+  using state_t    = state<hilbert_space, double, true>;
+  using imp_op_t   = imperative_operator<hilbert_space, double, false>;
+  using sp_t       = space_partition<state_t, imp_op_t>;
+
+  std::cout << "n_orb  dim      n_subspaces  phase I (s)  phase II (s)  mappings (s)\n";
+
+  for (int n_orb = 3; n_orb <= max_n_orb; ++n_orb) {
+    fundamental_operator_set fops;
+    for (int o = 0; o < n_orb; ++o) {
+      fops.insert("up", o);
+      fops.insert("dn", o);
+    }
+    hilbert_space hs(fops);
+    state_t st(hs);
+    imp_op_t H(kanamori(n_orb, 3.0, 0.3), fops);
+
+    std::unique_ptr<sp_t> SP;
+    double t1 = timeit([&] { SP = std::make_unique<sp_t>(st, H, false); });
+
+    std::vector<imp_op_t> cdag, c;
+    for (auto const &x : fops) {
+      cdag.emplace_back(many_body_operator::make_canonical(true, x.index), fops);
+      c.emplace_back(many_body_operator::make_canonical(false, x.index), fops);
+    }
+    double t2 = timeit([&] {
+      for (int k = 0; k < cdag.size(); ++k) SP->merge_subspaces(cdag[k], c[k], true);
+    });
+    double t3 = timeit([&] {
+      for (auto const &op : cdag) SP->find_mappings(op);
+    });
+
+    std::cout << n_orb << "      " << hs.size() << "    " << SP->n_subspaces() << "    " << t1 << "    " << t2 << "    " << t3 << std::endl;
+  }
+}
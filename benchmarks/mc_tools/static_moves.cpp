@@ -0,0 +1,96 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// Metropolis steps per second of mc_generic with cheap moves (spin flips of a 1d Ising chain) :
+// moves registered with add_move (type erased) vs a static_move_set.
+// Usage : static_moves [number of cycles]
+#include <triqs/mc_tools.hpp>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace triqs::mc_tools;
+
+struct chain {
+  std::vector<int> s = std::vector<int>(64, 1);
+  double boltzmann[9]; // exp(-beta * de) for de = -8, -6, ..., 8 (index (de + 8) / 2)
+  chain(double beta = 0.3) {
+    for (int k = 0; k < 9; ++k) boltzmann[k] = std::exp(-beta * (2 * k - 8));
+  }
+};
+
+// Flip NFlip neighbouring spins
+template <int NFlip> struct flip {
+  chain *c;
+  random_generator *rng;
+  int i = 0;
+  double attempt() {
+    int n = c->s.size();
+    i     = (*rng)(n);
+    int l = (i + n - 1) % n, r = (i + NFlip) % n;
+    int de = 2 * c->s[i] * c->s[l] + 2 * c->s[(i + NFlip - 1) % n] * c->s[r];
+    return c->boltzmann[(de + 8) / 2];
+  }
+  double accept() {
+    for (int k = 0; k < NFlip; ++k) c->s[(i + k) % c->s.size()] *= -1;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct magnetization {
+  chain *c;
+  double m = 0;
+  void accumulate(double) {
+    for (auto x : c->s) m += x;
+  }
+  void collect_results(triqs::mpi::communicator) {}
+};
+
+template <typename F> double timeit(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+}
+
+int main(int argc, char *argv[]) {
+  long n_cycles = (argc > 1 ? std::stol(argv[1]) : 100000);
+  int length    = 100;
+  double steps  = double(n_cycles) * length;
+
+  chain c1, c2;
+  mc_generic<double> mc1("mt19937", 1, 0), mc2("mt19937", 1, 0);
+
+  mc1.add_move(flip<1>{&c1, &mc1.get_rng()}, "flip1", 1.0);
+  mc1.add_move(flip<2>{&c1, &mc1.get_rng()}, "flip2", 0.5);
+  mc1.add_move(flip<3>{&c1, &mc1.get_rng()}, "flip3", 0.25);
+  mc1.add_move(flip<4>{&c1, &mc1.get_rng()}, "flip4", 0.25);
+  mc1.add_measure(magnetization{&c1}, "m");
+  double t_erased = timeit([&] { mc1.accumulate(n_cycles, length, [] { return false; }); });
+
+  auto &rng2 = mc2.get_rng();
+  mc2.set_static_moves(make_static_move_set<double>(rng2, {"flip1", "flip2", "flip3", "flip4"}, {1.0, 0.5, 0.25, 0.25}, flip<1>{&c2, &rng2},
+                                                    flip<2>{&c2, &rng2}, flip<3>{&c2, &rng2}, flip<4>{&c2, &rng2}));
+  mc2.add_measure(magnetization{&c2}, "m");
+  double t_static = timeit([&] { mc2.accumulate(n_cycles, length, [] { return false; }); });
+
+  std::cout << "steps/s   add_move : " << steps / t_erased << "   static_move_set : " << steps / t_static << "   speedup : " << t_erased / t_static
+            << std::endl;
+}
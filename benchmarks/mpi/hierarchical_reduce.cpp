@@ -0,0 +1,63 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// All reduce of a block_gf measurement over all processes : flat (one collective on the world communicator)
+// vs hierarchical (within each node, then between the node leaders).
+// On a single machine, the processes are grouped in emulated nodes of procs_per_node processes.
+// Usage : mpirun -np 8 hierarchical_reduce [procs_per_node] [n_repeat]
+#include <triqs/gfs.hpp>
+#include <chrono>
+#include <iostream>
+
+using namespace triqs::gfs;
+using namespace triqs::mpi;
+
+template <typename F> double timeit(communicator c, int n_repeat, F &&f) {
+  c.barrier();
+  auto t0 = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < n_repeat; ++i) f();
+  c.barrier();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count() / n_repeat;
+}
+
+int main(int argc, char *argv[]) {
+
+  environment env(argc, argv);
+  communicator world;
+  int procs_per_node = (argc > 1 ? std::stoi(argv[1]) : 2);
+  int n_repeat       = (argc > 2 ? std::stoi(argv[2]) : 10);
+
+  auto topo = node_topology{world, world.split(world.rank() / procs_per_node, world.rank())};
+
+  if (world.rank() == 0) {
+    std::cout << world.size() << " processes, " << procs_per_node << " per node" << std::endl;
+    std::cout << "n_iw      size (MB)   flat   hierarchical" << std::endl;
+  }
+  for (int n_iw : {100, 1000, 10000, 100000}) {
+    auto g  = gf<imfreq>{{10, Fermion, n_iw}, {4, 4}};
+    g()     = 1;
+    auto bg = make_block_gf({g, g});
+
+    double t_flat = timeit(world, n_repeat, [&] { mpi_reduce_in_place_packed(bg.data(), world, 0, true); });
+    double t_hier = timeit(world, n_repeat, [&] { mpi_hierarchical_all_reduce(bg, topo); });
+
+    if (world.rank() == 0) std::cout << n_iw << "      " << 2 * g.data().size() * sizeof(dcomplex) / 1e6 << "      " << t_flat << "      " << t_hier << std::endl;
+  }
+}
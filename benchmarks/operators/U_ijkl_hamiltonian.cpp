@@ -0,0 +1,96 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by I. Krivenko
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// Build H = 1/2 sum_{ijkl,s,s'} U_ijkl c^+_{is} c^+_{js'} c_{ls'} c_{ks} with a full U tensor
+// with many_body_operator and packed_operator, and compute [H, c^+_{0,up}].
+// Usage : U_ijkl_hamiltonian [max number of orbitals]
+#include <triqs/operators/packed_operator.hpp>
+#include <triqs/arrays.hpp>
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace triqs::operators;
+using triqs::hilbert_space::fundamental_operator_set;
+
+template <typename F> double timeit(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+}
+
+int main(int argc, char *argv[]) {
+
+  int max_n_orb = (argc > 1 ? std::stoi(argv[1]) : 7);
+  std::vector<std::string> spins{"up", "dn"};
+
+  std::cout << "n_orb  n_terms   many_body_operator  packed_operator  speedup   [H,c+] many_body  [H,c+] packed  speedup\n";
+
+  for (int n_orb = 1; n_orb <= max_n_orb; n_orb += 2) {
+
+    std::mt19937 rng(n_orb);
+    std::uniform_real_distribution<double> dist(-1, 1);
+    triqs::arrays::array<double, 4> U(n_orb, n_orb, n_orb, n_orb);
+    for (auto &u : U) u = dist(rng);
+
+    fundamental_operator_set fops;
+    for (auto const &s : spins)
+      for (int o = 0; o < n_orb; ++o) fops.insert(s, o);
+    auto fops_ptr = std::make_shared<fundamental_operator_set const>(fops);
+
+    many_body_operator_real H;
+    double t_mbo = timeit([&] {
+      for (auto const &s1 : spins)
+        for (auto const &s2 : spins)
+          for (int i = 0; i < n_orb; ++i)
+            for (int j = 0; j < n_orb; ++j)
+              for (int k = 0; k < n_orb; ++k)
+                for (int l = 0; l < n_orb; ++l)
+                  H += 0.5 * U(i, j, k, l) * c_dag<double>(s1, i) * c_dag<double>(s2, j) * c<double>(s2, l) * c<double>(s1, k);
+    });
+
+    packed_operator_real pH(fops_ptr);
+    double t_packed = timeit([&] {
+      for (auto const &s1 : spins)
+        for (auto const &s2 : spins)
+          for (int i = 0; i < n_orb; ++i)
+            for (int j = 0; j < n_orb; ++j)
+              for (int k = 0; k < n_orb; ++k)
+                for (int l = 0; l < n_orb; ++l)
+                  pH += 0.5 * U(i, j, k, l) * packed_c_dag<double>(fops_ptr, s1, i) * packed_c_dag<double>(fops_ptr, s2, j)
+                     * packed_c<double>(fops_ptr, s2, l) * packed_c<double>(fops_ptr, s1, k);
+    });
+
+    many_body_operator_real comm;
+    auto cdag = c_dag<double>("up", 0);
+    double t_comm_mbo = timeit([&] { comm = H * cdag - cdag * H; });
+
+    packed_operator_real pcomm;
+    auto pcdag = packed_c_dag<double>(fops_ptr, "up", 0);
+    double t_comm_packed = timeit([&] { pcomm = pH * pcdag - pcdag * pH; });
+
+    // check
+    assert_operators_are_close(pH.to_many_body_operator(), H, 1e-10);
+    assert_operators_are_close(pcomm.to_many_body_operator(), comm, 1e-10);
+
+    std::cout << n_orb << "      " << H.get_monomials().size() << "      " << t_mbo << "      " << t_packed << "      " << t_mbo / t_packed
+              << "      " << t_comm_mbo << "      " << t_comm_packed << "      " << t_comm_mbo / t_comm_packed << std::endl;
+  }
+}
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by I. Krivenko
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// H^2 for a Hamiltonian with a full U_ijkl tensor, with 1, 2, 4, ... OpenMP threads.
+// Usage : operator_product [number of orbitals]
+#include <triqs/operators/packed_operator.hpp>
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace triqs::operators;
+using triqs::hilbert_space::fundamental_operator_set;
+
+template <typename F> double timeit(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+}
+
+int main(int argc, char *argv[]) {
+
+  int n_orb = (argc > 1 ? std::stoi(argv[1]) : 3);
+  std::vector<std::string> spins{"up", "dn"};
+
+  std::mt19937 rng(n_orb);
+  std::uniform_real_distribution<double> dist(-1, 1);
+
+  fundamental_operator_set fops;
+  for (auto const &s : spins)
+    for (int o = 0; o < n_orb; ++o) fops.insert(s, o);
+  auto fops_ptr = std::make_shared<fundamental_operator_set const>(fops);
+
+  many_body_operator_real H;
+  for (auto const &s1 : spins)
+    for (auto const &s2 : spins)
+      for (int i = 0; i < n_orb; ++i)
+        for (int j = 0; j < n_orb; ++j) {
+          if (s1 == s2) H += dist(rng) * c_dag<double>(s1, i) * c<double>(s2, j);
+          for (int k = 0; k < n_orb; ++k)
+            for (int l = 0; l < n_orb; ++l) H += dist(rng) * c_dag<double>(s1, i) * c_dag<double>(s2, j) * c<double>(s2, l) * c<double>(s1, k);
+        }
+  auto pH = packed_operator_real(H, fops_ptr);
+
+  std::cout << "n_orb = " << n_orb << ", " << H.get_monomials().size() << " terms" << std::endl;
+  std::cout << "threads  many_body_operator  packed_operator" << std::endl;
+
+#ifdef _OPENMP
+  int max_threads = omp_get_max_threads();
+#else
+  int max_threads = 1;
+#endif
+  for (int n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+#ifdef _OPENMP
+    omp_set_num_threads(n_threads);
+#endif
+    many_body_operator_real H2;
+    packed_operator_real pH2;
+    double t_mbo    = timeit([&] { H2 = H * H; });
+    double t_packed = timeit([&] { pH2 = pH * pH; });
+    assert_operators_are_close(pH2.to_many_body_operator(), H2, 1e-10);
+    std::cout << n_threads << "        " << t_mbo << "            " << t_packed << std::endl;
+  }
+}
@@ -100,6 +100,10 @@ for c_py, c_cpp, in (('Real','false'),('Complex','true')):
                    getter = cfunction("int get_full_hilbert_space_dim ()"),
                    doc = "Dimension of the full Hilbert space")
 
+    c.add_property(name = "retained_hilbert_space_dim",
+                   getter = cfunction("int get_retained_hilbert_space_dim ()"),
+                   doc = "Number of eigenstates, i.e. the size of the state vectors in the eigenbasis (smaller than full_hilbert_space_dim for a truncated diagonalization)")
+
     c.add_property(name = "n_subspaces",
                    getter = cfunction("int n_subspaces ()"),
                    doc = "Number of invariant subspaces")
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/arrays/linalg/batched_inverse.hpp>
+#include <random>
+
+using namespace triqs::arrays;
+using dcomplex = std::complex<double>;
+
+std::mt19937 rng(1);
+
+template <typename T> array<T, 3> random_batch(int n_batch, int n) {
+  std::uniform_real_distribution<double> dist(-1, 1);
+  array<T, 3> r(n_batch, n, n);
+  for (auto &x : r) {
+    if constexpr (std::is_same<T, double>::value)
+      x = dist(rng);
+    else
+      x = dcomplex(dist(rng), dist(rng));
+  }
+  return r;
+}
+
+// compare with inverse, matrix by matrix
+template <typename T> void check(int n_batch, int n) {
+  auto a     = random_batch<T>(n_batch, n);
+  auto a_inv = a;
+  inverse_in_place_batched(a_inv);
+  for (int i = 0; i < n_batch; ++i) {
+    matrix<T> m = a(i, range(), range());
+    EXPECT_ARRAY_NEAR(a_inv(i, range(), range()), matrix<T>(inverse(m)), 1e-10);
+  }
+}
+
+TEST(BatchedInverse, Double) {
+  for (int n : {1, 3, 8, 9, 17}) check<double>(50, n);
+}
+
+TEST(BatchedInverse, Complex) {
+  for (int n : {1, 2, 7, 12}) check<dcomplex>(50, n);
+  // large enough to be split among threads, if any
+  check<dcomplex>(2000, 4);
+  check<dcomplex>(200, 10);
+}
+
+TEST(BatchedInverse, View) {
+  for (int n : {4, 10}) {
+    // a strided view : every other matrix
+    auto a = random_batch<dcomplex>(20, n);
+    auto v = a(range(0, 20, 2), range(), range());
+    array<dcomplex, 3> a_ref = a;
+    inverse_in_place_batched(v);
+    for (int i = 0; i < 20; ++i) {
+      matrix<dcomplex> m = a_ref(i, range(), range());
+      if (i % 2 == 0)
+        EXPECT_ARRAY_NEAR(a(i, range(), range()), matrix<dcomplex>(inverse(m)), 1e-10);
+      else
+        EXPECT_ARRAY_NEAR(a(i, range(), range()), m, 1e-15);
+    }
+  }
+}
+
+TEST(BatchedInverse, Singular) {
+  for (int n : {3, 12}) {
+    auto a                = random_batch<double>(5000, n);
+    a(4321, n - 1, range()) = 0;
+    EXPECT_THROW(inverse_in_place_batched(a), triqs::runtime_error);
+  }
+  auto a = random_batch<double>(3, 2);
+  EXPECT_THROW(inverse_in_place_batched(a(range(), range(), range(0, 1))), triqs::runtime_error);
+}
+
+MAKE_MAIN;
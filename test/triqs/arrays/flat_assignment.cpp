@@ -0,0 +1,102 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+// small threshold, to test the parallel assignment if OpenMP is on
+#define TRIQS_ARRAYS_PARALLEL_ASSIGNMENT_THRESHOLD 100
+#include <triqs/test_tools/arrays.hpp>
+
+using namespace triqs::arrays;
+using dcomplex = std::complex<double>;
+
+template <typename A> void fill(A &&a, double x) {
+  long i = 0;
+  for (auto &y : a) y = std::cos(x * (++i));
+}
+
+TEST(FlatAssignment, Expressions) {
+  array<dcomplex, 3> A(10, 20, 30), B(10, 20, 30), C(10, 20, 30), D(10, 20, 30), R(10, 20, 30);
+  fill(B, 1);
+  fill(C, 2);
+  fill(D, 3);
+  dcomplex a = {1, 2};
+
+  EXPECT_TRUE(flat_access<decltype(a * B + C * D)>::value);
+  EXPECT_TRUE(flat_access<decltype(-B / 2 + abs(C))>::value);
+
+  A = a * B + C * D;
+  foreach (R, [&](int i, int j, int k) { R(i, j, k) = a * B(i, j, k) + C(i, j, k) * D(i, j, k); });
+  EXPECT_ARRAY_NEAR(A, R, 1e-14);
+
+  A += -B / 2 + abs(C);
+  foreach (R, [&](int i, int j, int k) { R(i, j, k) += -B(i, j, k) / 2.0 + std::abs(C(i, j, k)); });
+  EXPECT_ARRAY_NEAR(A, R, 1e-14);
+
+  // scalar and array rhs
+  A *= 2;
+  A -= B;
+  R = 2 * R - B;
+  EXPECT_ARRAY_NEAR(A, R, 1e-14);
+
+  // lhs in the rhs
+  A = A * A + 1;
+  R = R * R + 1;
+  EXPECT_ARRAY_NEAR(A, R, 1e-14);
+}
+
+TEST(FlatAssignment, Layouts) {
+  array<double, 2> A(50, 40), B(50, 40), C(50, 40, FORTRAN_LAYOUT), R(50, 40);
+  fill(B, 1);
+  fill(C, 2);
+
+  // different memory layouts : no flat loop
+  EXPECT_FALSE(is_compact(C(range(0, 50, 2), range()).indexmap()));
+  A = B + 2 * C;
+  for (int i = 0; i < 50; ++i)
+    for (int j = 0; j < 40; ++j) R(i, j) = B(i, j) + 2 * C(i, j);
+  EXPECT_ARRAY_NEAR(A, R, 1e-14);
+
+  // strided views
+  auto V = A(range(0, 50, 2), range());
+  V      = B(range(1, 50, 2), range()) * 3;
+  for (int i = 0; i < 25; ++i)
+    for (int j = 0; j < 40; ++j) R(2 * i, j) = 3 * B(2 * i + 1, j);
+  EXPECT_ARRAY_NEAR(A, R, 1e-14);
+
+  // compact views with partial overlap : same as the ordered loop
+  array<double, 1> x(1000), x_ref(1000);
+  fill(x, 1);
+  x_ref = x;
+  x(range(1, 1000)) += 2 * x(range(0, 999));
+  for (int i = 1; i < 1000; ++i) x_ref(i) += 2 * x_ref(i - 1);
+  EXPECT_ARRAY_NEAR(x, x_ref, 1e-14);
+}
+
+TEST(FlatAssignment, Matrix) {
+  matrix<double> M(30, 30), N(30, 30);
+  fill(N, 1);
+  M = N;
+  M *= 3;
+  M /= 2;
+  EXPECT_ARRAY_NEAR(M, matrix<double>(1.5 * N), 1e-14);
+  M() = 2.0;
+  EXPECT_ARRAY_NEAR(M, matrix<double>(2 * make_unit_matrix<double>(30)), 1e-15);
+}
+
+MAKE_MAIN;
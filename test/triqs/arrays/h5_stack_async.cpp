@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/arrays.hpp>
+#include <triqs/arrays/h5/array_stack.hpp>
+
+using namespace triqs;
+using namespace triqs::arrays;
+
+// number of elements in the stack dataset in the file
+hsize_t file_size(h5::group g, std::string const &name) {
+  h5::dataset ds     = g.open_dataset(name);
+  h5::dataspace d_sp = H5Dget_space(ds);
+  hsize_t dims[4];
+  H5Sget_simple_extent_dims(d_sp, dims, nullptr);
+  return dims[0];
+}
+
+TEST(H5StackAsync, Stack) {
+  const int N = 1003, bufsize = 10;
+  {
+    h5::file file("h5_stack_async.h5", 'w');
+    h5::group top(file);
+    array_stack<array<dcomplex, 2>> SA(top, "A", {2, 3}, bufsize, true);
+    array_stack<double> SC(top, "C", bufsize, true);
+
+    hbool_t threadsafe;
+    H5is_library_threadsafe(&threadsafe);
+    EXPECT_EQ(SA.is_async(), bool(threadsafe));
+
+    array<dcomplex, 2> A(2, 3);
+    for (int u = 0; u < N; ++u) {
+      A() = u;
+      A(1, 2) += 1_j * u;
+      SA << A;
+      SC << 0.5 * u;
+      if (u == 500) {
+        SA.sync(); // all the elements pushed so far are in the file
+        EXPECT_EQ(file_size(top, "A"), 501);
+      }
+    }
+    SA.sync();
+    EXPECT_EQ(SA.size(), N);
+    EXPECT_EQ(file_size(top, "A"), N);
+  } // SC is written at destruction
+
+  h5::file file("h5_stack_async.h5", 'r');
+  h5::group top(file);
+  array<dcomplex, 3> A;
+  array<double, 1> C;
+  h5_read(top, "A", A);
+  h5_read(top, "C", C);
+  ASSERT_EQ(first_dim(A), N);
+  ASSERT_EQ(first_dim(C), N);
+  for (int u = 0; u < N; ++u) {
+    EXPECT_COMPLEX_NEAR(A(u, 0, 0), u, 1e-15);
+    EXPECT_COMPLEX_NEAR(A(u, 1, 2), u + 1_j * u, 1e-15);
+    EXPECT_EQ(C(u), 0.5 * u);
+  }
+}
+
+MAKE_MAIN;
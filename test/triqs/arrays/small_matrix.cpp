@@ -0,0 +1,110 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/arrays/linalg/small_matrix.hpp>
+#include <random>
+
+using namespace triqs::arrays;
+using dcomplex = std::complex<double>;
+
+std::mt19937 rng(1);
+
+template <typename T> matrix<T> random_matrix(int n, int m) {
+  std::uniform_real_distribution<double> dist(-1, 1);
+  matrix<T> r(n, m);
+  for (auto &x : r) {
+    if constexpr (std::is_same<T, double>::value)
+      x = dist(rng);
+    else
+      x = dcomplex(dist(rng), dist(rng));
+  }
+  return r;
+}
+
+// the reference determinant from lapack getrf
+template <typename T> T det_lapack(matrix<T> a) {
+  vector<int> ipiv(first_dim(a));
+  lapack::getrf(a, ipiv);
+  T d = 1;
+  for (int i = 0; i < first_dim(a); ++i) d *= (ipiv(i) != i + 1 ? -a(i, i) : a(i, i));
+  return d;
+}
+
+template <typename T> void check(int n) {
+  auto A = random_matrix<T>(n, n), B = random_matrix<T>(n, n);
+
+  // product, compared with the generic gemm
+  matrix<T> C_ref(n, n);
+  blas::gemm_generic(T(1), A, B, T(0), C_ref);
+  EXPECT_ARRAY_NEAR(A * B, C_ref, 1e-13);
+
+  // on views with non unit strides : transposed, and a slice of a bigger matrix
+  auto big = random_matrix<T>(2 * n, 2 * n);
+  auto V   = big(range(0, 2 * n, 2), range(1, 2 * n, 2));
+  matrix<T> V_copy = V;
+  blas::gemm_generic(T(1), transpose(A), matrix<T>(V), T(0), C_ref);
+  EXPECT_ARRAY_NEAR(transpose(A) * V, C_ref, 1e-13);
+  EXPECT_ARRAY_NEAR(V * V, V_copy * V_copy, 1e-13);
+
+  // inverse and det
+  matrix<T> Ainv = inverse(A);
+  EXPECT_ARRAY_NEAR(Ainv * A, make_unit_matrix<T>(n), 1e-12);
+  EXPECT_COMPLEX_NEAR(determinant(A), det_lapack(A), 1e-12);
+
+  // in place, on a strided view
+  V = inverse(V);
+  EXPECT_ARRAY_NEAR(V * V_copy, make_unit_matrix<T>(n), 1e-12);
+
+  // singular matrix
+  auto S            = A;
+  S(n - 1, range()) = 0;
+  EXPECT_THROW(matrix<T>(inverse(S)), triqs::runtime_error);
+  EXPECT_COMPLEX_NEAR(determinant(S), 0, 1e-14);
+}
+
+TEST(SmallMatrix, Double) {
+  for (int n = 1; n <= small_matrix::max_dim + 2; ++n) check<double>(n);
+}
+
+TEST(SmallMatrix, Complex) {
+  for (int n = 1; n <= small_matrix::max_dim + 2; ++n) check<dcomplex>(n);
+}
+
+TEST(SmallMatrix, Kernels) {
+  EXPECT_TRUE(small_matrix::applicable<dcomplex>(8));
+  EXPECT_FALSE(small_matrix::applicable<dcomplex>(9));
+  EXPECT_FALSE(small_matrix::applicable<int>(2));
+
+  // kernel called directly
+  auto A = random_matrix<dcomplex>(4, 4);
+  matrix<dcomplex> A_inv = A;
+  auto d                 = small_matrix::inverse_in_place(A_inv);
+  EXPECT_COMPLEX_NEAR(d, det_lapack(A), 1e-12);
+  EXPECT_ARRAY_NEAR(A_inv, matrix<dcomplex>(inverse(matrix<dcomplex>(A))), 1e-12);
+
+  // not square : falls back to blas
+  auto R = random_matrix<double>(3, 4);
+  matrix<double> C(3, 3);
+  EXPECT_FALSE(small_matrix::gemm(R, transpose(R), C));
+  EXPECT_ARRAY_NEAR(R * transpose(R), transpose(R * transpose(R)), 1e-14);
+}
+
+MAKE_MAIN;
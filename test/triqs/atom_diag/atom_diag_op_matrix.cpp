@@ -6,6 +6,8 @@
 
 #include <triqs/atom_diag/atom_diag.hpp>
 #include <triqs/hilbert_space/fundamental_operator_set.hpp> // gf_struct_t
+#include <triqs/hilbert_space/imperative_operator.hpp>
+#include <triqs/hilbert_space/state.hpp>
 using gf_struct_t = triqs::hilbert_space::gf_struct_t;
 
 using namespace triqs::arrays;
@@ -91,4 +93,54 @@ TEST(atom_diag, op_matrix) {
   }
 }
 
+// -----------------------------------------------------------------------------
+// Regression test : get_op_mat on a model with blocks larger than 1x1,
+// against the dense matrix of the operator in the Fock basis, transformed to the eigenbasis
+TEST(atom_diag, op_matrix_blocks) {
+
+  gf_struct_t gf_struct{{"up", {0, 1}}, {"dn", {0, 1}}};
+  fundamental_operator_set fops(gf_struct);
+
+  double U = 2.0, t = 0.4, eps = 0.3;
+  many_body_operator_real H;
+  for (int o : {0, 1}) H += U * n("up", o) * n("dn", o) + eps * o * (n("up", o) + n("dn", o));
+  for (auto s : {"up", "dn"}) H += -t * (c_dag(s, 0) * c(s, 1) + c_dag(s, 1) * c(s, 0));
+
+  auto ad = triqs::atom_diag::atom_diag<false>(H, fops);
+  int max_dim = 0;
+  for (int b : range(ad.n_subspaces())) max_dim = std::max(max_dim, ad.get_subspace_dim(b));
+  EXPECT_GT(max_dim, 1);
+
+  triqs::hilbert_space::hilbert_space hs(fops);
+  auto fock_states = ad.get_fock_states();
+  auto umat        = ad.get_unitary_matrices();
+
+  std::vector<many_body_operator_real> ops = {n("up", 0), c_dag("up", 0) * c("up", 1), c_dag("dn", 1), c("up", 0) * n("dn", 1),
+                                              c_dag("up", 1) * c_dag("dn", 0) * c("dn", 1) * c("up", 0)};
+  for (auto const &op : ops) {
+    auto op_mat = ad.get_op_mat(op);
+    imperative_operator<triqs::hilbert_space::hilbert_space, double> imp_op(op, fops);
+    state<triqs::hilbert_space::hilbert_space, double, true> st(hs);
+
+    for (int b : range(ad.n_subspaces())) {
+      // the dense matrix of op from the Fock states of b, projected on the Fock states of each subspace bp
+      for (int bp : range(ad.n_subspaces())) {
+        matrix<double> m_fock(fock_states[bp].size(), fock_states[b].size());
+        m_fock() = 0;
+        for (int j : range(fock_states[b].size())) {
+          st.clear();
+          st(hs.get_state_index(fock_states[b][j])) = 1;
+          auto res = imp_op(st);
+          for (int i : range(fock_states[bp].size())) m_fock(i, j) = res(hs.get_state_index(fock_states[bp][i]));
+        }
+        matrix<double> ref = dagger(umat[bp]) * m_fock * umat[b];
+        if (bp == op_mat.connection(b))
+          EXPECT_ARRAY_NEAR(op_mat.block_mat[b], ref, 1e-12);
+        else
+          EXPECT_NEAR(max_element(abs(ref)), 0, 1e-12);
+      }
+    }
+  }
+}
+
 MAKE_MAIN;
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/atom_diag/atom_diag.hpp>
+#include <triqs/atom_diag/gf.hpp>
+
+using namespace triqs::arrays;
+using namespace triqs::gfs;
+using namespace triqs::hilbert_space;
+using namespace triqs::atom_diag;
+using namespace triqs::operators;
+
+// Two orbitals with a hopping and a chemical potential : poles of both signs, off-diagonal elements
+auto make_atom() {
+  fundamental_operator_set fops;
+  for (int o : {0, 1}) {
+    fops.insert("up", o);
+    fops.insert("dn", o);
+  }
+  many_body_operator_real h;
+  for (auto s : {"up", "dn"}) h += -0.3 * (c_dag(s, 0) * c(s, 1) + c_dag(s, 1) * c(s, 0)) - 0.8 * n(s, 0) + 0.2 * n(s, 1);
+  h += 2.0 * (n("up", 0) * n("dn", 0) + n("up", 1) * n("dn", 1)) + 0.5 * n("up", 0) * n("dn", 1);
+  return triqs::atom_diag::atom_diag<false>(h, fops);
+}
+
+// The G from the Lehmann representation, point by point
+template <typename M, typename F> block_gf<M> g_direct(gf_lehmann_t<false> const &lehmann, gf_struct_t const &gf_struct, gf_mesh<M> const &mesh, F f) {
+  auto g = block_gf{mesh, gf_struct};
+  for (int bl : range(g.size()))
+    for (auto const &x : mesh)
+      for (int n1 : range(2))
+        for (int n2 : range(2)) {
+          dcomplex r = 0;
+          for (auto const &[pole, residue] : lehmann[bl](n1, n2)) r += f(x, pole, residue);
+          g[bl][x](n1, n2) = r;
+        }
+  return g;
+}
+
+TEST(AtomicGf, Kernels) {
+  auto ad               = make_atom();
+  double beta           = 20;
+  gf_struct_t gf_struct = {{"dn", {0, 1}}, {"up", {0, 1}}};
+  auto lehmann          = atomic_g_lehmann(ad, beta, gf_struct);
+
+  // more than 64 points : the exponentials are recomputed exactly along the mesh
+  gf_mesh<imtime> tau_mesh{beta, Fermion, 1001};
+  auto g_tau = atomic_g_tau<false>(lehmann, gf_struct, tau_mesh);
+  auto g_tau_ref = g_direct(lehmann, gf_struct, tau_mesh, [beta](double tau, double pole, double residue) {
+    return -residue * (pole > 0 ? std::exp(-tau * pole) / (1 + std::exp(-beta * pole)) : std::exp((beta - tau) * pole) / (std::exp(beta * pole) + 1));
+  });
+  EXPECT_BLOCK_GF_NEAR(g_tau_ref, g_tau);
+  EXPECT_BLOCK_GF_NEAR(g_tau_ref, atomic_g_tau(ad, beta, gf_struct, 1001));
+
+  gf_mesh<imfreq> iw_mesh{beta, Fermion, 100};
+  auto g_iw_ref = g_direct(lehmann, gf_struct, iw_mesh, [](dcomplex iw, double pole, double residue) { return residue / (iw - pole); });
+  EXPECT_BLOCK_GF_NEAR(g_iw_ref, atomic_g_iw<false>(lehmann, gf_struct, iw_mesh));
+
+  gf_mesh<refreq> w_mesh{-4, 4, 501};
+  double eta    = 0.05;
+  auto g_w_ref  = g_direct(lehmann, gf_struct, w_mesh, [eta](double w, double pole, double residue) { return residue / (w + 1_j * eta - pole); });
+  EXPECT_BLOCK_GF_NEAR(g_w_ref, atomic_g_w<false>(lehmann, gf_struct, w_mesh, eta));
+  EXPECT_BLOCK_GF_NEAR(g_w_ref, atomic_g_w(ad, beta, gf_struct, {-4, 4}, 501, eta));
+}
+
+MAKE_MAIN;
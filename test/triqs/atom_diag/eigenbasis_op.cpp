@@ -0,0 +1,118 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/atom_diag/atom_diag.hpp>
+#include <triqs/atom_diag/functions.hpp>
+
+using namespace triqs::arrays;
+using namespace triqs::hilbert_space;
+using namespace triqs::atom_diag;
+using namespace triqs::operators;
+
+// Two orbitals with a hopping : the eigenbasis differs from the Fock basis
+auto make_atom() {
+  fundamental_operator_set fops;
+  for (int o : {0, 1}) {
+    fops.insert("up", o);
+    fops.insert("dn", o);
+  }
+  many_body_operator_real h;
+  for (auto s : {"up", "dn"}) h += -0.3 * (c_dag(s, 0) * c(s, 1) + c_dag(s, 1) * c(s, 0)) - 0.5 * n(s, 0) + 0.2 * n(s, 1);
+  h += 2.0 * (n("up", 0) * n("dn", 0) + n("up", 1) * n("dn", 1)) + 0.5 * n("up", 0) * n("dn", 1);
+  return atom_diag<false>(h, fops);
+}
+
+// The matrix of op in the full Hilbert space, in the eigenbasis
+matrix<double> dense(eigenbasis_op_t<false> const &op, atom_diag<false> const &ad) {
+  int d = ad.get_full_hilbert_space_dim();
+  matrix<double> m(d, d);
+  m() = 0;
+  for (int B = 0; B < op.n_blocks(); ++B)
+    for (auto const &b : op.blocks[B]) m(ad.index_range_of_subspace(b.target), ad.index_range_of_subspace(B)) += b.mat;
+  return m;
+}
+
+TEST(EigenbasisOp, Products) {
+  auto ad = make_atom();
+  // the matrix of a product is the product of the matrices
+  auto o1 = c_dag("up", 0) + 0.5 * c_dag("dn", 1);
+  auto o2 = c("up", 1) - 2.0 * c("dn", 0) * n("up", 1);
+  auto m1 = dense(make_eigenbasis_op(o1, ad), ad);
+  auto m2 = dense(make_eigenbasis_op(o2, ad), ad);
+  EXPECT_ARRAY_NEAR(dense(make_eigenbasis_op(o1 * o2, ad), ad), m1 * m2, 1.e-12);
+
+  // the Hamiltonian is diagonal, with the eigenvalues (shifted by the ground state energy)
+  int d = ad.get_full_hilbert_space_dim();
+  matrix<double> e(d, d);
+  e() = 0;
+  for (int B = 0; B < ad.n_subspaces(); ++B)
+    for (int i = 0; i < ad.get_subspace_dim(B); ++i) {
+      int k   = ad.flatten_subspace_index(B, i);
+      e(k, k) = ad.get_eigenvalue(B, i) + ad.get_gs_energy();
+    }
+  EXPECT_ARRAY_NEAR(dense(make_eigenbasis_op(ad.get_h_atomic(), ad), ad), e, 1.e-12);
+
+  // the same as get_op_mat for an operator connecting each subspace to a single one
+  auto n0   = n("up", 0);
+  auto op1  = make_eigenbasis_op(n0, ad);
+  auto op2  = ad.get_op_mat(n0);
+  for (int B = 0; B < ad.n_subspaces(); ++B) {
+    if (op1.blocks[B].empty()) {
+      EXPECT_EQ(op2.connection(B), -1);
+      continue;
+    }
+    ASSERT_EQ(op1.blocks[B].size(), 1);
+    EXPECT_EQ(op1.blocks[B][0].target, op2.connection(B));
+    EXPECT_ARRAY_NEAR(op1.blocks[B][0].mat, op2.block_mat[B], 1.e-12);
+  }
+}
+
+TEST(EigenbasisOp, TraceAndAct) {
+  auto ad     = make_atom();
+  double beta = 3;
+  auto dm     = atomic_density_matrix(ad, beta);
+  auto o      = n("up", 0) * n("dn", 1) + 0.7 * (c_dag("up", 0) * c("up", 1) + c_dag("up", 1) * c("up", 0)) + 0.3 * c_dag("dn", 0);
+  auto op     = make_eigenbasis_op(o, ad);
+
+  // act
+  int d = ad.get_full_hilbert_space_dim();
+  vector<double> st(d);
+  for (int i = 0; i < d; ++i) st(i) = std::cos(i);
+  auto m = dense(op, ad);
+  EXPECT_ARRAY_NEAR(act(op, st, ad), m * st, 1.e-12);
+  EXPECT_ARRAY_NEAR(act(o, st, ad), m * st, 1.e-12);
+
+  // trace, against the diagonal of the dense matrix : the density matrix is diagonal in the eigenbasis
+  double tr = 0;
+  for (int B = 0; B < ad.n_subspaces(); ++B)
+    for (int i = 0; i < ad.get_subspace_dim(B); ++i) tr += dm[B](i, i) * m(ad.flatten_subspace_index(B, i), ad.flatten_subspace_index(B, i));
+  EXPECT_NEAR(trace_rho_op(dm, op, ad), tr, 1.e-12);
+  EXPECT_NEAR(trace_rho_op(dm, o, ad), tr, 1.e-12);
+
+  // quantum numbers
+  auto N = n("up", 0) + n("up", 1) + n("dn", 0) + n("dn", 1);
+  auto q = quantum_number_eigenvalues(make_eigenbasis_op(N, ad), ad);
+  EXPECT_EQ(q, quantum_number_eigenvalues(N, ad));
+  EXPECT_EQ(q, quantum_number_eigenvalues_checked(N, ad));
+  EXPECT_THROW(quantum_number_eigenvalues_checked(n("up", 0), ad), triqs::runtime_error);
+}
+
+MAKE_MAIN;
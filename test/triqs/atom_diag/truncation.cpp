@@ -0,0 +1,159 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/atom_diag/atom_diag.hpp>
+#include <triqs/atom_diag/functions.hpp>
+#include <triqs/atom_diag/impl/lanczos.hpp>
+#include <triqs/arrays/linalg/eigenelements.hpp>
+
+using namespace triqs::arrays;
+using namespace triqs::hilbert_space;
+using namespace triqs::atom_diag;
+using namespace triqs::operators;
+
+using atom_diag_r = triqs::atom_diag::atom_diag<false>;
+
+// 4 orbitals : Kanamori interaction and hoppings. The invariant subspaces (N, Sz) have up to 36 states, with degeneracies
+fundamental_operator_set make_fops() {
+  fundamental_operator_set fops;
+  for (int o : range(4)) {
+    fops.insert("up", o);
+    fops.insert("dn", o);
+  }
+  return fops;
+}
+
+template <typename O = many_body_operator_real> O make_hamiltonian(typename O::scalar_t t = 0.2) {
+  double U = 2.0, J = 0.3, mu = 3.0;
+  O h;
+  using triqs::utility::conj;
+  for (auto s : {"up", "dn"})
+    for (int o1 : range(4)) {
+      h += -mu * n(s, o1);
+      for (int o2 : range(o1)) h += -t * c_dag(s, o1) * c(s, o2) - conj(t) * c_dag(s, o2) * c(s, o1);
+    }
+  for (int o : range(4)) h += U * n("up", o) * n("dn", o);
+  for (int o1 : range(4))
+    for (int o2 : range(4)) {
+      if (o1 == o2) continue;
+      h += (U - 2 * J) * n("up", o1) * n("dn", o2);
+      if (o2 < o1) h += (U - 3 * J) * (n("up", o1) * n("up", o2) + n("dn", o1) * n("dn", o2));
+      h += -J * c_dag("up", o1) * c_dag("dn", o1) * c("up", o2) * c("dn", o2);
+      h += -J * c_dag("up", o1) * c_dag("dn", o2) * c("up", o2) * c("dn", o1);
+    }
+  return h;
+}
+
+// The eigenvalues of the truncated diagonalization are the lowest ones of the full one
+template <typename AD> void check_energies(AD const &full, AD const &trunc, int n_lowest, double e_max) {
+  ASSERT_EQ(full.n_subspaces(), trunc.n_subspaces());
+  EXPECT_NEAR(full.get_gs_energy(), trunc.get_gs_energy(), 1.e-10);
+  int n_total = 0;
+  for (int sp : range(full.n_subspaces())) {
+    auto const &e = full.get_eigensystems()[sp].eigenvalues;
+    int n         = 1;
+    while (n < e.size() and (e(n) <= e(0) + 1.e-8 or (e(n) <= e_max and (n < n_lowest or e(n) <= e(n_lowest - 1) + 1.e-8)))) ++n;
+    ASSERT_EQ(trunc.get_subspace_dim(sp), n);
+    for (int i : range(n)) EXPECT_NEAR(e(i), trunc.get_eigenvalue(sp, i), 1.e-9);
+    n_total += n;
+  }
+  EXPECT_EQ(trunc.get_vacuum_state().size(), n_total);
+}
+
+// The c matrices between the retained states are the blocks of the full ones, up to a unitary transformation
+// in each degenerate eigenspace : compare their singular values
+void check_c_matrices(atom_diag_r const &full, atom_diag_r const &trunc) {
+  auto singular_values = [](matrix<double> const &a) {
+    matrix<double> at = a.transpose(), m = at * a;
+    return linalg::eigenvalues(m);
+  };
+  for (int n : range(full.get_fops().size()))
+    for (int sp : range(full.n_subspaces())) {
+      int sp2 = full.c_connection(n, sp);
+      ASSERT_EQ(sp2, trunc.c_connection(n, sp));
+      if (sp2 == -1) continue;
+      matrix<double> block = full.c_matrix(n, sp)(range(0, trunc.get_subspace_dim(sp2)), range(0, trunc.get_subspace_dim(sp)));
+      EXPECT_ARRAY_NEAR(singular_values(block), singular_values(trunc.c_matrix(n, sp)), 1.e-9);
+    }
+}
+
+TEST(Truncation, Lanczos) {
+  auto fops = make_fops();
+  auto h    = make_hamiltonian();
+  auto full = atom_diag_r(h, fops);
+
+  // energy cutoff, the subspaces of more than 10 states with Lanczos
+  double beta = 10, cutoff = 3.5;
+  auto trunc  = atom_diag_r(h, fops, truncation_t{0, cutoff, 10});
+  check_energies(full, trunc, INT_MAX, cutoff);
+  EXPECT_EQ(trunc.get_full_hilbert_space_dim(), full.get_full_hilbert_space_dim());
+  EXPECT_EQ(full.get_retained_hilbert_space_dim(), full.get_full_hilbert_space_dim());
+  EXPECT_LT(trunc.get_retained_hilbert_space_dim(), trunc.get_full_hilbert_space_dim());
+  EXPECT_EQ(trunc.get_vacuum_state().size(), trunc.get_retained_hilbert_space_dim());
+  EXPECT_EQ(act(c_dag("up", 0), trunc.get_vacuum_state(), trunc).size(), trunc.get_retained_hilbert_space_dim());
+
+  // the truncated states have a Boltzmann weight < exp(-beta * cutoff)
+  EXPECT_NEAR(partition_function(full, beta), partition_function(trunc, beta), 1.e-12);
+  check_c_matrices(full, trunc);
+
+  // at most 2 states per subspace (and their degenerate partners)
+  check_energies(full, atom_diag_r(h, fops, truncation_t{2, std::numeric_limits<double>::infinity(), 10}), 2, std::numeric_limits<double>::infinity());
+
+  // LAPACK for all the subspaces
+  check_energies(full, atom_diag_r(h, fops, truncation_t{3, 1.0, 1000}), 3, 1.0);
+}
+
+// No infinite loop when the Lanczos runs do not converge
+TEST(Truncation, LanczosNoConvergence) {
+  sparse_matrix<double> m;
+  for (int i : range(50)) {
+    m.push_back(i, i);
+    if (i > 0) m.push_back(i - 1, 0.5);
+    if (i < 49) m.push_back(i + 1, 0.5);
+    m.end_col();
+  }
+  lanczos_solver<double> ok(m, 10);
+  ok.run(3, std::numeric_limits<double>::infinity());
+  EXPECT_EQ(ok.eigenelements(3, std::numeric_limits<double>::infinity()).first.size(), 3);
+
+  lanczos_solver<double> never(m, 10, 0); // tol = 0 : nothing ever converges
+  EXPECT_THROW(never.run(3, std::numeric_limits<double>::infinity()), triqs::runtime_error);
+  lanczos_solver<double> short_runs(m, 1, 0, 2);
+  EXPECT_THROW(short_runs.run(3, std::numeric_limits<double>::infinity()), triqs::runtime_error);
+}
+
+TEST(Truncation, Complex) {
+  auto fops = make_fops();
+  auto h    = make_hamiltonian<many_body_operator_complex>(0.2 * std::exp(0.3_j));
+  auto full = triqs::atom_diag::atom_diag<true>(h, fops);
+  check_energies(full, triqs::atom_diag::atom_diag<true>(h, fops, truncation_t{3, 3.0, 10}), 3, 3.0);
+}
+
+TEST(Truncation, Off) {
+  // no truncation : identical to the full diagonalization
+  auto fops = make_fops();
+  auto h    = make_hamiltonian();
+  auto full = atom_diag_r(h, fops), trunc = atom_diag_r(h, fops, truncation_t{});
+  check_energies(full, trunc, INT_MAX, std::numeric_limits<double>::infinity());
+  for (int sp : range(full.n_subspaces())) EXPECT_ARRAY_NEAR(full.get_eigensystems()[sp].unitary_matrix, trunc.get_eigensystems()[sp].unitary_matrix);
+}
+
+MAKE_MAIN;
@@ -66,4 +66,31 @@ TEST(CtHyb, gf_inverse3) {
   EXPECT_GF_NEAR(G_iw, G_iw_inv);
 }
 
+TEST(CtHyb, gf_inverse_batched) {
+  double beta = 10.0;
+  int n_iw    = 20;
+  auto bz     = brillouin_zone{bravais_lattice{{{1, 0}, {0, 1}}}};
+
+  // small (fixed-size kernels) and large (lapack) matrices
+  for (int n : {3, 12}) {
+    auto G = gf<cartesian_product<imfreq, brillouin_zone>>{{{beta, Fermion, n_iw}, {bz, 4}}, {n, n}};
+    for (auto [w, k] : G.mesh()) {
+      G[w, k] = w + 0.1 * (cos(k(0)) + 2 * cos(k(1)));
+      for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j) G[w, k](i, j) += 1. / (1 + i + 2 * j);
+    }
+    auto G_inv = inverse(G);
+    for (auto [w, k] : G.mesh()) {
+      matrix<dcomplex> m = G[w, k];
+      EXPECT_ARRAY_NEAR(matrix<dcomplex>(G_inv[w, k]), matrix<dcomplex>(inverse(m)), 1e-12);
+    }
+
+    // in place, on a block_gf
+    auto B = make_block_gf({G, G_inv});
+    invert_in_place(B);
+    EXPECT_GF_NEAR(B[0], G_inv);
+    EXPECT_GF_NEAR(B[1], G, 1e-10);
+  }
+}
+
 MAKE_MAIN;
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/gfs.hpp>
+
+namespace h5 = triqs::h5;
+using namespace triqs;
+using namespace triqs::arrays;
+using namespace triqs::gfs;
+using namespace triqs::lattice;
+
+clef::placeholder<0> i_;
+clef::placeholder<1> j_;
+clef::placeholder<2> k_;
+
+TEST(H5ReadSlice, Array) {
+  array<dcomplex, 3> A(10, 20, 3);
+  A(i_, j_, k_) << i_ + 100 * j_ + 1_j * k_;
+  array<double, 2> D(10, 20);
+  D(i_, j_) << i_ - j_;
+  {
+    h5::file f{"read_slice.h5", 'w'};
+    h5_write(f, "A", A);
+    h5_write(f, "D", D);
+  }
+  h5::file f{"read_slice.h5", 'r'};
+
+  array<dcomplex, 3> B;
+  h5_read_slice(f, "A", B, {range(2, 5), range(0, 20, 3), range()});
+  EXPECT_ARRAY_EQ(B, A(range(2, 5), range(0, 20, 3), range()));
+
+  h5_read_slice(f, "A", B, {range(7, 8)}); // the last dimensions are complete
+  EXPECT_ARRAY_EQ(B, A(range(7, 8), range(), range()));
+
+  // into a view of the right shape, in Fortran order
+  array<dcomplex, 3> C(4, 5, 3, FORTRAN_LAYOUT);
+  h5_read_slice(f, "A", C(range(1, 3), range(), range()), {range(0, 10, 5), range(10, 15)});
+  EXPECT_ARRAY_EQ(C(range(1, 3), range(), range()), A(range(0, 10, 5), range(10, 15), range()));
+  EXPECT_THROW(h5_read_slice(f, "A", C(range(0, 3), range(), range()), {range(0, 10, 5), range(10, 15)}), triqs::runtime_error);
+
+  // real in the file, complex array
+  array<dcomplex, 2> E;
+  h5_read_slice(f, "D", E, {range(1, 6), range(0, 3)});
+  EXPECT_ARRAY_EQ(E, D(range(1, 6), range(0, 3)));
+
+  EXPECT_THROW(h5_read_slice(f, "A", B, {range(5, 11)}), triqs::runtime_error);
+  EXPECT_THROW(h5_read_slice(f, "A", B, {range(), range(), range(), range()}), triqs::runtime_error);
+}
+
+TEST(H5ReadSlice, Gf) {
+  auto bz = brillouin_zone{bravais_lattice{{{1, 0}, {0, 1}}}};
+  auto G  = gf<cartesian_product<brillouin_zone, imfreq>>{{{bz, 8}, {10, Fermion, 16}}, {2, 2}};
+  for (auto [k, w] : G.mesh()) G[k, w] = 1 / (w - 2 * (cos(k(0)) + cos(k(1))));
+  {
+    h5::file f{"read_slice_gf.h5", 'w'};
+    h5_write(f, "G", G);
+  }
+  h5::file f{"read_slice_gf.h5", 'r'};
+
+  // a few k points, all frequencies
+  array<dcomplex, 4> d;
+  h5_read_data_slice(f, "G", d, {range(3, 5)});
+  EXPECT_ARRAY_EQ(d, G.data()(range(3, 5), ellipsis()));
+
+  // all k points, a few frequencies
+  h5_read_data_slice(f, "G", d, {range(), range(16, 18)});
+  EXPECT_ARRAY_EQ(d, G.data()(range(), range(16, 18), range(), range()));
+}
+
+MAKE_MAIN;
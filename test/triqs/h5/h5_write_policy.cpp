@@ -0,0 +1,138 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/arrays.hpp>
+#include <triqs/arrays/h5/array_stack.hpp>
+
+namespace h5 = triqs::h5;
+using namespace triqs;
+using namespace triqs::arrays;
+
+clef::placeholder<0> i_;
+clef::placeholder<1> j_;
+
+// Inspect the dataset creation properties of a dataset in the file
+struct dataset_props {
+  H5D_layout_t layout;
+  std::vector<hsize_t> chunk;
+  std::vector<H5Z_filter_t> filters;
+};
+
+dataset_props props(h5::group g, std::string const &name) {
+  h5::dataset ds      = g.open_dataset(name);
+  h5::proplist cparms = H5Dget_create_plist(ds);
+  dataset_props r;
+  r.layout = H5Pget_layout(cparms);
+  if (r.layout == H5D_CHUNKED) {
+    r.chunk.resize(H5Sget_simple_extent_ndims(h5::dataspace{H5Dget_space(ds)}));
+    H5Pget_chunk(cparms, r.chunk.size(), r.chunk.data());
+  }
+  for (int i = 0; i < H5Pget_nfilters(cparms); ++i) {
+    unsigned flags;
+    size_t n = 0;
+    r.filters.push_back(H5Pget_filter2(cparms, i, &flags, &n, nullptr, 0, nullptr, nullptr));
+  }
+  return r;
+}
+
+TEST(H5WritePolicy, ChunkDimensions) {
+  h5::write_policy p;
+  EXPECT_EQ(h5::chunk_dimensions(p, {100, 0, 2}, 8), (std::vector<hsize_t>{100, 1, 2}));
+
+  p.chunk_bytes = 1 << 20; // 2^17 doubles
+  EXPECT_EQ(h5::chunk_dimensions(p, {100, 50, 2}, 8), (std::vector<hsize_t>{100, 50, 2}));
+  EXPECT_EQ(h5::chunk_dimensions(p, {10000, 1000, 2}, 8), (std::vector<hsize_t>{65, 1000, 2}));
+  EXPECT_EQ(h5::chunk_dimensions(p, {10, 10, 1 << 20}, 8), (std::vector<hsize_t>{1, 1, 1 << 17}));
+}
+
+TEST(H5WritePolicy, Array) {
+  array<dcomplex, 2> A(200, 300);
+  A(i_, j_) << i_ + 1_j * j_;
+
+  {
+    h5::file f{"write_policy.h5", 'w'};
+    h5::group top{f};
+    h5_write(top, "A_default", A);
+
+    f.set_write_policy(h5::write_policy::no_compression());
+    h5_write(f, "A", A);
+
+    auto g = top.create_group("compressed");
+    g.set_write_policy({1, true, 64 * 1024});
+    h5_write(g.create_group("sub"), "A", A); // inherited by the subgroups
+
+    g.set_write_policy({10, false, 0});
+    EXPECT_THROW(h5_write(g, "A", A), triqs::runtime_error);
+  }
+
+  h5::file f{"write_policy.h5", 'r'};
+  h5::group top{f};
+
+  auto p = props(top, "A_default"); // one chunk, deflate
+  EXPECT_EQ(p.layout, H5D_CHUNKED);
+  EXPECT_EQ(p.chunk, (std::vector<hsize_t>{200, 300, 2}));
+  EXPECT_EQ(p.filters, (std::vector<H5Z_filter_t>{H5Z_FILTER_DEFLATE}));
+
+  EXPECT_EQ(props(top, "A").layout, H5D_CONTIGUOUS);
+
+  p = props(top, "compressed/sub/A"); // 8192 doubles per chunk
+  EXPECT_EQ(p.chunk, (std::vector<hsize_t>{13, 300, 2}));
+  EXPECT_EQ(p.filters, (std::vector<H5Z_filter_t>{H5Z_FILTER_SHUFFLE, H5Z_FILTER_DEFLATE}));
+
+  for (auto name : {"A_default", "A", "compressed/sub/A"}) {
+    array<dcomplex, 2> B;
+    h5_read(top, name, B);
+    EXPECT_ARRAY_EQ(A, B);
+  }
+}
+
+TEST(H5WritePolicy, ArrayStack) {
+  {
+    h5::file f{"write_policy_stack.h5", 'w'};
+    h5::group top{f};
+    array_stack<array<double, 1>> S1(top, "S1", {100}, 10);
+    top.set_write_policy(h5::write_policy::no_compression());
+    array_stack<array<double, 1>> S2(top, "S2", {100}, 10);
+    top.set_write_policy({0, false, 1600});
+    array_stack<array<double, 1>> S3(top, "S3", {100}, 10);
+    for (int u = 0; u < 25; ++u) {
+      S1() = u;
+      S2() = u;
+      S3() = u;
+      ++S1, ++S2, ++S3;
+    }
+  }
+
+  h5::file f{"write_policy_stack.h5", 'r'};
+  h5::group top{f};
+  EXPECT_EQ(props(top, "S1").chunk, (std::vector<hsize_t>{1, 100}));
+  EXPECT_EQ(props(top, "S1").filters, (std::vector<H5Z_filter_t>{H5Z_FILTER_DEFLATE}));
+  EXPECT_EQ(props(top, "S2").chunk, (std::vector<hsize_t>{1, 100})); // an extendible dataset is always chunked
+  EXPECT_TRUE(props(top, "S2").filters.empty());
+  EXPECT_EQ(props(top, "S3").chunk, (std::vector<hsize_t>{2, 100}));
+
+  array<double, 2> R;
+  h5_read(top, "S3", R);
+  EXPECT_EQ(first_dim(R), 25);
+  EXPECT_EQ(R(24, 3), 24);
+}
+
+MAKE_MAIN;
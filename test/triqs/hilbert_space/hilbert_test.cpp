@@ -94,6 +94,60 @@ TEST(hilbert_space, state) {
   check_state(st, {{3, 5.0}, {0, 3.0}});
 }
 
+TEST(hilbert_space, state_map_storage) {
+  fundamental_operator_set fop;
+  for (int i = 0; i < 10; ++i) fop.insert("up", i);
+
+  using triqs::hilbert_space::hilbert_space;
+  hilbert_space h_full(fop);
+  using state_t = state<hilbert_space, double, true>;
+
+  // many amplitudes : the table grows
+  state_t st1(h_full), st2(h_full);
+  std::map<int, double> ref;
+  for (int i = 0; i < 1024; i += 3) {
+    st1(i) = i;
+    st2(i) = (i % 2 == 0 ? 1 : -1);
+    ref[i] = i + st2(i);
+  }
+  state_t const &cst = st1;
+  EXPECT_EQ(9, cst(9));
+  EXPECT_EQ(0, cst(10)); // not stored
+
+  double d = 0;
+  for (int i = 0; i < 1024; i += 3) d += i * (i % 2 == 0 ? 1 : -1);
+  EXPECT_EQ(d, dot_product(st1, st2));
+
+  st1 += st2;
+  check_state(st1, ref);
+
+  // the vanishing amplitudes are pruned
+  st1 -= st1;
+  int n = 0;
+  foreach (st1, [&n](int, double) { ++n; })
+    ;
+  EXPECT_EQ(0, n);
+
+  // reuse the memory
+  st2.clear();
+  check_state(st2, {});
+  st2(7) = 1.0;
+  check_state(st2, {{7, 1.0}});
+  st2.reserve(100);
+  check_state(st2, {{7, 1.0}});
+
+  // act reuses the target state
+  using triqs::operators::c;
+  using triqs::operators::c_dag;
+  auto opH = imperative_operator<hilbert_space>(3 * c_dag("up", 1) * c("up", 1) + c("up", 1) * c("up", 2), fop);
+  opH.act(st2, st1);
+  check_state(st1, {{1, -1.0}, {7, 3.0}});
+  st2.clear();
+  st2(2) = 1.0;
+  opH.act(st2, st1);
+  check_state(st1, {{2, 3.0}});
+}
+
 TEST(hilbert_space, imperative_operator) {
   fundamental_operator_set fop;
   for (int i = 0; i < 5; ++i) fop.insert("up", i);
@@ -190,6 +244,59 @@ TEST(hilbert_space, QuarticOperators) {
   check_state(imperative_operator<hilbert_space>(quartic_op, fops)(st1), {{6, 1.0}}); // new state
 }
 
+// Sign of the monomials with more than 16 fundamental operators
+TEST(hilbert_space, ParityManyOperators) {
+  int n_fops = 18;
+  fundamental_operator_set fops;
+  for (int i = 0; i < n_fops; ++i) fops.insert(i);
+
+  using triqs::hilbert_space::hilbert_space;
+  hilbert_space hs(fops);
+
+  using op_t = triqs::operators::many_body_operator_real;
+  auto c     = [](int i) { return triqs::operators::c<double>(i); };
+  auto c_dag = [](int i) { return triqs::operators::c_dag<double>(i); };
+  std::vector<op_t> ops = {c_dag(17) * c(0), c_dag(0) * c(17), c_dag(16) * c(1),  c_dag(2) * c(17) + c_dag(17) * c(2),
+                           c(17) * c(16),    c_dag(1) * c_dag(17) * c(16) * c(3), c_dag(17) * c_dag(5) * c(0) * c(16)};
+
+  // Reference : the monomials of op act on the Fock state fs one operator after the other (from the right).
+  // c or c_dag of index k gives the sign (-1)^(number of occupied states of index < k).
+  auto apply_op = [&fops](op_t const &op, fock_state_t fs) {
+    std::map<int, double> r;
+    for (auto const &[m, coeff] : op) {
+      fock_state_t f = fs;
+      double x       = coeff;
+      for (auto it = m.rbegin(); it != m.rend(); ++it) {
+        fock_state_t b = fock_state_t(1) << fops[it->indices];
+        if (bool(f & b) == it->dagger) {
+          x = 0;
+          break;
+        }
+        if (__builtin_popcountll(f & (b - 1)) % 2) x = -x;
+        f ^= b;
+      }
+      if (x != 0) r[f] += x;
+    }
+    return r;
+  };
+
+  state<hilbert_space, double, true> st(hs), res(hs);
+  for (auto const &op : ops) {
+    imperative_operator<hilbert_space, double> imp_op(op, fops);
+    for (fock_state_t fs = 5; fs < hs.size(); fs += 997) {
+      auto ref = apply_op(op, fs);
+      st.clear();
+      st(hs.get_state_index(fs)) = 1;
+      imp_op.act(st, res);
+      check_state(res, ref);
+
+      std::map<int, double> tr;
+      imp_op.foreach_transition(fs, [&tr](fock_state_t f, double x) { tr[f] += x; });
+      EXPECT_EQ(tr, ref);
+    }
+  }
+}
+
 TEST(hilbert_space, StateProjection) {
   fundamental_operator_set fop;
   for (int i = 0; i < 3; ++i) fop.insert("s", i);
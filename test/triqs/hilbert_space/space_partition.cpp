@@ -375,3 +375,84 @@ TEST(space_partition, Phase2) {
     }
   }
 }
+
+// An operator without foreach_transition : space_partition applies it to states
+struct op_on_states {
+  imp_op_t op;
+  state_t operator()(state_t const &st) const { return op(st); }
+};
+
+// Check the Fock state bitmask algorithm (in parallel on large spaces) against the one on states
+TEST(space_partition, FockBitmasks) {
+
+  // 6 bands Kanamori, with some hopping : 4096 states
+  fundamental_operator_set fops6;
+  for (int o = 0; o < 6; ++o) {
+    fops6.insert("up", o);
+    fops6.insert("dn", o);
+  }
+  many_body_operator H6;
+  for (int o1 = 0; o1 < 6; ++o1) {
+    H6 += U * n("up", o1) * n("dn", o1);
+    for (int o2 = 0; o2 < 6; ++o2) {
+      if (o1 == o2) continue;
+      H6 += (U - 2 * J) * n("up", o1) * n("dn", o2);
+      H6 += -J * c_dag("up", o1) * c_dag("dn", o1) * c("up", o2) * c("dn", o2);
+      H6 += -J * c_dag("up", o1) * c_dag("dn", o2) * c("up", o2) * c("dn", o1);
+    }
+  }
+  H6 += 0.5 * (c_dag("up", 0) * c("up", 1) + c_dag("up", 1) * c("up", 0));
+
+  hilbert_space hs(fops6);
+  state_t st(hs);
+  space_partition<state_t, imp_op_t> SP1(st, imp_op_t(H6, fops6));
+  space_partition<state_t, op_on_states> SP2(st, op_on_states{imp_op_t(H6, fops6)});
+
+  auto check_melem = [](auto const &m1, auto const &m2) {
+    ASSERT_EQ(m1.size(), m2.size());
+    for (int k = 0; k < m1.size(); ++k) {
+      EXPECT_EQ(m1[k].first, m2[k].first);
+      EXPECT_NEAR(m1[k].second, m2[k].second, 1e-14);
+    }
+    EXPECT_TRUE(std::is_sorted(m1.begin(), m1.end(), [](auto const &a, auto const &b) { return a.first < b.first; }));
+  };
+  check_melem(SP1.get_matrix_elements(), SP2.get_matrix_elements());
+
+  for (auto const &x : fops6) {
+    auto cd = many_body_operator::make_canonical(true, x.index), c = many_body_operator::make_canonical(false, x.index);
+    auto r1 = SP1.merge_subspaces(imp_op_t(cd, fops6), imp_op_t(c, fops6));
+    auto r2 = SP2.merge_subspaces(op_on_states{imp_op_t(cd, fops6)}, op_on_states{imp_op_t(c, fops6)});
+    check_melem(r1.first, r2.first);
+    check_melem(r1.second, r2.second);
+  }
+
+  ASSERT_EQ(SP1.n_subspaces(), SP2.n_subspaces());
+  for (int i = 0; i < hs.size(); ++i) EXPECT_EQ(SP1.lookup_basis_state(i), SP2.lookup_basis_state(i));
+
+  auto cd0 = c_dag("up", 0);
+  EXPECT_EQ(SP1.find_mappings(imp_op_t(cd0, fops6)), SP2.find_mappings(op_on_states{imp_op_t(cd0, fops6)}));
+}
+
+// The matrix elements, a flat array, can be used as the std::map of the previous versions
+TEST(space_partition, MatrixElementMap) {
+  hilbert_space hs(fops);
+  state_t st(hs);
+  space_partition<state_t, imp_op_t> SP(st, imp_op_t(H, fops));
+  auto const &melem = SP.get_matrix_elements();
+  ASSERT_GT(melem.size(), 0);
+
+  for (auto const &[k, x] : melem) {
+    auto it = melem.find(k);
+    ASSERT_TRUE(it != melem.end());
+    EXPECT_EQ(it->second, x);
+    EXPECT_EQ(melem.count(k), 1);
+  }
+  EXPECT_EQ(melem.count({hs.size(), 0}), 0);
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+  std::map<std::pair<uint32_t, uint32_t>, double> m = melem;
+#pragma GCC diagnostic pop
+  EXPECT_EQ(m.size(), melem.size());
+  EXPECT_EQ(m.begin()->second, melem.begin()->second);
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+#include <cmath>
+
+using namespace triqs;
+using namespace triqs::mc_tools;
+
+// Three moves : cheap and always accepted, cheap and rarely accepted, expensive and always accepted
+struct move_fast {
+  double attempt() { return 1; }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+struct move_rare {
+  double attempt() { return 0.05; }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+struct move_slow {
+  double x = 0;
+  double attempt() {
+    for (int i = 0; i < 2000; ++i) x = std::sin(x + i); // burn some time
+    return 1;
+  }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+struct measure_nothing {
+  void accumulate(double) {}
+  void collect_results(mpi::communicator) {}
+};
+
+TEST(AdaptiveMoves, Warmup) {
+  mc_generic<double> mc("mt19937", 3, 0);
+  mc.add_move(move_fast{}, "fast");
+  mc.add_move(move_rare{}, "rare");
+  mc.add_move(move_slow{}, "slow");
+  mc.add_measure(measure_nothing{}, "nothing");
+
+  auto p0 = mc.get_proposition_probabilities();
+  for (auto const &[name, p] : p0) EXPECT_NEAR(p, 1.0 / 3, 1.e-14);
+
+  double min_fraction = 0.2;
+  mc.set_adaptive_move_probabilities(true, min_fraction);
+  mc.warmup(100, 100, [] { return false; });
+
+  auto p1 = mc.get_proposition_probabilities();
+  double tot = 0;
+  for (auto const &[name, p] : p1) {
+    tot += p;
+    EXPECT_GT(p, 0.9 * min_fraction / 3); // lower bound, up to the normalization
+  }
+  EXPECT_NEAR(tot, 1, 1.e-12);
+  EXPECT_GT(p1["fast"], 0.5);
+  EXPECT_LT(p1["rare"], 1.0 / 3);
+  EXPECT_LT(p1["slow"], 1.0 / 3);
+
+  // frozen during the accumulation
+  mc.accumulate(100, 100, [] { return false; });
+  auto p2 = mc.get_proposition_probabilities();
+  for (auto const &[name, p] : p1) EXPECT_EQ(p2[name], p);
+}
+
+TEST(AdaptiveMoves, Off) {
+  mc_generic<double> mc("mt19937", 3, 0);
+  mc.add_move(move_fast{}, "fast", 2.0);
+  mc.add_move(move_rare{}, "rare", 1.0);
+  mc.add_measure(measure_nothing{}, "nothing");
+  mc.warmup_and_accumulate(50, 50, 10, [] { return false; });
+  auto p = mc.get_proposition_probabilities();
+  EXPECT_NEAR(p["fast"], 2.0 / 3, 1.e-14);
+  EXPECT_NEAR(p["rare"], 1.0 / 3, 1.e-14);
+}
+
+MAKE_MAIN;
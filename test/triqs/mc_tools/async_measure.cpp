@@ -0,0 +1,132 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+#include <cmath>
+
+using namespace triqs;
+using namespace triqs::mc_tools;
+
+// A configuration of n "spins" in [0,1[, and a move changing one of them
+struct configuration {
+  std::vector<double> x = std::vector<double>(50, 0.5);
+};
+
+struct move_change {
+  configuration *config;
+  random_generator *rng;
+  size_t i = 0;
+  double y = 0;
+  double attempt() {
+    i = (*rng)(config->x.size());
+    y = (*rng)();
+    return std::exp(-std::abs(y - 0.5) + std::abs(config->x[i] - 0.5));
+  }
+  double accept() {
+    config->x[i] = y;
+    return 1;
+  }
+  void reject() {}
+};
+
+// An expensive measure : the correlation of all pairs
+struct measure_corr {
+  configuration const *config;
+  double *result;
+  double sum = 0;
+  long n     = 0;
+  std::vector<double> snapshot() const { return config->x; }
+  void accumulate(std::vector<double> const &x, double sign) {
+    for (size_t i = 0; i < x.size(); ++i)
+      for (size_t j = 0; j < x.size(); ++j) sum += sign * std::cos(x[i] - x[j]);
+    ++n;
+  }
+  void collect_results(mpi::communicator) { *result = sum / n; }
+  friend void h5_write(h5::group g, std::string const &name, measure_corr const &m) { h5_write(g, name, m.sum); }
+  friend void h5_read(h5::group g, std::string const &name, measure_corr &m) { h5_read(g, name, m.sum); }
+};
+
+// A measure failing after some snapshots
+struct measure_fail {
+  long n = 0;
+  int snapshot() const { return 0; }
+  void accumulate(int, double) {
+    if (++n == 5) TRIQS_RUNTIME_ERROR << "measure_fail";
+  }
+  void collect_results(mpi::communicator) {}
+};
+
+// Runs with a given number of threads and capacity, returns the results of the two measures
+std::pair<double, double> run(int n_threads, size_t capacity) {
+  configuration config;
+  mc_generic<double> mc("mt19937", 17, 0);
+  mc.set_measure_threads(n_threads);
+  mc.add_move(move_change{&config, &mc.get_rng()}, "change");
+  double r1 = 0, r2 = 0;
+  mc.add_async_measure(measure_corr{&config, &r1}, "corr1", capacity);
+  mc.add_async_measure(measure_corr{&config, &r2}, "corr2", capacity);
+  mc.warmup_and_accumulate(10, 500, 20, [] { return false; });
+  mc.collect_results(mpi::communicator{});
+  return {r1, r2};
+}
+
+TEST(AsyncMeasure, Deterministic) {
+  auto r0 = run(0, 64); // synchronous
+  EXPECT_GT(r0.first, 0);
+  EXPECT_EQ(r0.first, r0.second);
+  for (auto [n_threads, capacity] : std::vector<std::pair<int, size_t>>{{1, 64}, {3, 64}, {2, 1}}) {
+    auto r = run(n_threads, capacity);
+    EXPECT_EQ(r.first, r0.first);
+    EXPECT_EQ(r.second, r0.second);
+  }
+}
+
+TEST(AsyncMeasure, CompleteAfterRun) {
+  configuration config;
+  mc_generic<double> mc("mt19937", 17, 0);
+  mc.set_measure_threads(2);
+  mc.add_move(move_change{&config, &mc.get_rng()}, "change");
+  double r = 0;
+  mc.add_async_measure(measure_corr{&config, &r}, "corr", 4);
+  EXPECT_THROW(mc.set_measure_threads(1), triqs::runtime_error);
+  mc.accumulate(100, 10, [] { return false; });
+
+  // h5 : the accumulated sum of the 100 snapshots
+  {
+    h5::file f("async_measure.h5", 'w');
+    h5_write(f, "mc", mc);
+  }
+  h5::file f("async_measure.h5", 'r');
+  double sum = 0;
+  h5_read(h5::group(f).open_group("mc").open_group("measures"), "corr", sum);
+  mc.collect_results(mpi::communicator{});
+  EXPECT_NEAR(sum / 100, r, 1.e-12);
+}
+
+TEST(AsyncMeasure, Error) {
+  configuration config;
+  mc_generic<double> mc("mt19937", 17, 0);
+  mc.add_move(move_change{&config, &mc.get_rng()}, "change");
+  mc.add_async_measure(measure_fail{}, "fail", 2);
+  EXPECT_THROW(mc.accumulate(100, 10, [] { return false; }), triqs::runtime_error);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+#include <cstdio>
+
+using namespace triqs;
+using triqs::mc_tools::random_generator;
+
+// A random walk on a line. The measure accumulates the positions.
+struct configuration {
+  long x = 0;
+};
+
+struct move_step {
+  configuration *config;
+  random_generator &rng;
+  long dx = 0;
+  double attempt() {
+    dx = (rng(2) == 0 ? -1 : 1);
+    return (std::abs(config->x + dx) > 10 ? 0.3 : 1.0);
+  }
+  double accept() {
+    config->x += dx;
+    return 1;
+  }
+  void reject() {}
+};
+
+// A jump of 3 sites, accepted less often than a step
+struct move_jump {
+  configuration *config;
+  random_generator &rng;
+  long dx = 0;
+  double attempt() {
+    dx = (rng(2) == 0 ? -3 : 3);
+    return (std::abs(config->x + dx) > 4 ? 0.1 : 0.5);
+  }
+  double accept() {
+    config->x += dx;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct measure_x {
+  configuration *config;
+  std::vector<long> xs;
+  void accumulate(double) { xs.push_back(config->x); }
+  void collect_results(mpi::communicator) {}
+  friend void h5_write(h5::group g, std::string const &name, measure_x const &m) { h5_write(g, name, m.xs); }
+  friend void h5_read(h5::group g, std::string const &name, measure_x &m) { h5_read(g, name, m.xs); }
+};
+
+// The result of a run : the measured positions, the final configuration and the next random numbers
+struct result_t {
+  std::vector<long> xs;
+  long x;
+  std::vector<double> next_random;
+  std::map<std::string, double> proposition_probabilities;
+};
+
+// Run n_warmup + n_acc cycles, stopping after n_stop cycles (counted from the start of this call) if n_stop > 0
+// With adaptive, two moves whose proposition probabilities are adapted in the warmup (acceptance rates only).
+result_t run(int n_warmup, int n_acc, int n_stop, std::string const &checkpoint, int *status = nullptr, bool adaptive = false) {
+  configuration config;
+  mc_tools::mc_generic<double> mc("mt19937", 2341, 0);
+  mc.add_move(move_step{&config, mc.get_rng()}, "step");
+  if (adaptive) {
+    mc.add_move(move_jump{&config, mc.get_rng()}, "jump");
+    mc.set_adaptive_move_probabilities(true, 0.1);
+    mc.set_move_timing_period(0); // reproducible
+  }
+  mc.add_measure(measure_x{&config, {}}, "x");
+
+  if (!checkpoint.empty()) {
+    mc.set_checkpoint(checkpoint, 3600, [&config](h5::group g) { h5_write(g, "x", config.x); },
+                      [&config](h5::group g) { h5_read(g, "x", config.x); });
+    mc.load_checkpoint();
+  }
+  int n      = 0;
+  auto stop  = [&n, n_stop]() { return (n_stop > 0) and (++n >= n_stop); };
+  int st     = mc.warmup_and_accumulate(n_warmup, n_acc, 7, stop);
+  if (status) *status = st;
+
+  // read the measure back from the h5 interface of mc_generic
+  h5::file f("checkpoint_result.h5", 'w');
+  h5_write(f, "mc", mc);
+  result_t r;
+  h5_read(h5::group(f).open_group("mc").open_group("measures"), "x", r.xs);
+  r.x = config.x;
+  for (int i = 0; i < 10; ++i) r.next_random.push_back(mc.get_rng()());
+  r.proposition_probabilities = mc.get_proposition_probabilities();
+  return r;
+}
+
+TEST(Checkpoint, RandomGenerator) {
+  for (auto name : mc_tools::random_generator_names_list()) {
+    random_generator r1(name, 123);
+    for (int i = 0; i < 1500; ++i) r1();
+    {
+      h5::file f("checkpoint_rng.h5", 'w');
+      h5_write(f, "rng", r1);
+    }
+    random_generator r2("", 9); // another generator
+    h5::file f("checkpoint_rng.h5", 'r');
+    h5_read(f, "rng", r2);
+    EXPECT_EQ(r2.name(), name);
+    for (int i = 0; i < 3000; ++i) EXPECT_EQ(r1(), r2()) << name;
+  }
+
+  // our Mersenne twister
+  random_generator r1("", 123);
+  for (int i = 0; i < 700; ++i) r1();
+  {
+    h5::file f("checkpoint_rng.h5", 'w');
+    h5_write(f, "rng", r1);
+  }
+  random_generator r2("mt19937", 9);
+  h5::file f("checkpoint_rng.h5", 'r');
+  h5_read(f, "rng", r2);
+  for (int i = 0; i < 3000; ++i) EXPECT_EQ(r1(), r2());
+}
+
+TEST(Checkpoint, Restart) {
+  auto ref = run(20, 100, 0, "");
+  EXPECT_EQ(ref.xs.size(), 100);
+
+  // stopped during the warmup, then during the accumulation
+  for (int n_stop : {5, 50}) {
+    std::remove("checkpoint_mc.h5");
+    int status = 0;
+    run(20, 100, n_stop, "checkpoint_mc.h5", &status);
+    EXPECT_EQ(status, 1);
+
+    auto res = run(20, 100, 0, "checkpoint_mc.h5");
+    EXPECT_EQ(res.xs, ref.xs);
+    EXPECT_EQ(res.x, ref.x);
+    EXPECT_EQ(res.next_random, ref.next_random);
+  }
+
+  // restarted after the end of the warmup : the warmup is not done again
+  std::remove("checkpoint_mc.h5");
+  run(20, 100, 20, "checkpoint_mc.h5");
+  auto res = run(20, 100, 0, "checkpoint_mc.h5");
+  EXPECT_EQ(res.xs, ref.xs);
+
+  // the temporary file has been renamed
+  EXPECT_FALSE(std::ifstream("checkpoint_mc.h5.tmp"));
+}
+
+TEST(Checkpoint, RestartAdaptive) {
+  auto ref = run(20, 100, 0, "", nullptr, true);
+  EXPECT_EQ(ref.xs.size(), 100);
+  EXPECT_GT(ref.proposition_probabilities["step"], 0.5); // adapted
+
+  // stopped during the warmup (between two adaptations), then during the accumulation
+  for (int n_stop : {5, 50}) {
+    std::remove("checkpoint_mc.h5");
+    run(20, 100, n_stop, "checkpoint_mc.h5", nullptr, true);
+    auto res = run(20, 100, 0, "checkpoint_mc.h5", nullptr, true);
+    EXPECT_EQ(res.xs, ref.xs);
+    EXPECT_EQ(res.x, ref.x);
+    EXPECT_EQ(res.next_random, ref.next_random);
+    EXPECT_EQ(res.proposition_probabilities, ref.proposition_probabilities);
+  }
+}
+
+MAKE_MAIN;
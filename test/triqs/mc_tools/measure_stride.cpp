@@ -0,0 +1,98 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+#include <cmath>
+
+using namespace triqs;
+using namespace triqs::mc_tools;
+
+// An AR(1) process x -> a x + sqrt(1 - a^2) noise : autocorrelation exp(-t / tau) with a = exp(-1 / tau)
+struct move_ar1 {
+  double *x;
+  double a;
+  random_generator *rng;
+  double y = 0;
+  double attempt() {
+    y = a * (*x) + std::sqrt(1 - a * a) * ((*rng)() - 0.5) * std::sqrt(12.0);
+    return 1;
+  }
+  double accept() {
+    *x = y;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct measure_count {
+  long *n;
+  void accumulate(double) { ++*n; }
+  void collect_results(mpi::communicator) {}
+};
+
+TEST(MeasureStride, Autocorrelation) {
+  double x = 0;
+  long n   = 0;
+  mc_generic<double> mc("mt19937", 8, 0);
+  mc.add_move(move_ar1{&x, std::exp(-1 / 10.0), &mc.get_rng()}, "ar1");
+  mc.add_measure(measure_count{&n}, "count");
+  mc.set_autocorrelation_observable([&x] { return x; }, 2);
+  EXPECT_EQ(mc.get_autocorrelation_time(), -1);
+  mc.warmup_and_accumulate(20000, 10000, 1, [] { return false; });
+
+  // tau = 10, and the estimator gives ~ 1 + 2 * sum_t>0 exp(-t/tau) / 2 ~ tau + 1/2
+  EXPECT_GT(mc.get_autocorrelation_time(), 7);
+  EXPECT_LT(mc.get_autocorrelation_time(), 14);
+  auto stride = mc.get_measure_stride();
+  EXPECT_EQ(stride, std::max(uint64_t(2 * mc.get_autocorrelation_time()), uint64_t(1)));
+  EXPECT_EQ(n, 10000 / stride);
+}
+
+TEST(MeasureStride, Uncorrelated) {
+  double x = 0;
+  long n   = 0;
+  mc_generic<double> mc("mt19937", 8, 0);
+  mc.add_move(move_ar1{&x, 0, &mc.get_rng()}, "ar1");
+  mc.add_measure(measure_count{&n}, "count");
+  mc.set_autocorrelation_observable([&x] { return x; });
+  mc.warmup_and_accumulate(2000, 100, 1, [] { return false; });
+  EXPECT_EQ(mc.get_measure_stride(), 1);
+  EXPECT_EQ(n, 100);
+}
+
+TEST(MeasureStride, Manual) {
+  double x = 0;
+  long n   = 0;
+  mc_generic<double> mc("mt19937", 8, 0);
+  mc.add_move(move_ar1{&x, 0.5, &mc.get_rng()}, "ar1");
+  mc.add_measure(measure_count{&n}, "count");
+  EXPECT_THROW(mc.set_measure_stride(0), triqs::runtime_error);
+  mc.set_measure_stride(7);
+  mc.warmup_and_accumulate(10, 100, 1, [] { return false; });
+  EXPECT_EQ(n, 14);
+
+  // a constant observable : not estimated, the stride is kept
+  mc.set_autocorrelation_observable([] { return 1.0; });
+  mc.warmup(1000, 1, [] { return false; });
+  EXPECT_EQ(mc.get_measure_stride(), 7);
+}
+
+MAKE_MAIN;
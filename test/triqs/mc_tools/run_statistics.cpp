@@ -0,0 +1,153 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+#include <cmath>
+
+using namespace triqs;
+using namespace triqs::mc_tools;
+
+struct move_cheap {
+  double attempt() { return 0.5; }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+struct move_slow {
+  double x = 0;
+  double attempt() {
+    for (int i = 0; i < 2000; ++i) x = std::sin(x + i); // burn some time
+    return 1;
+  }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+struct measure_nothing {
+  void accumulate(double) {}
+  void collect_results(mpi::communicator) {}
+};
+
+TEST(RunStatistics, Moves) {
+  mpi::communicator world;
+  mc_generic<double> mc("mt19937", 5, 0);
+  mc.add_move(move_cheap{}, "cheap");
+  move_set<double> ms(mc.get_rng());
+  ms.add(move_slow{}, "slow", 1.0);
+  mc.add_move(std::move(ms), "set \"inner\"");
+  mc.add_measure(measure_nothing{}, "nothing");
+  mc.set_move_timing_period(4);
+  mc.warmup_and_accumulate(100, 200, 10, [] { return false; });
+
+  auto st = mc.get_run_statistics(world);
+  EXPECT_EQ(st.n_processes, world.size());
+  EXPECT_EQ(st.n_cycles, 300 * world.size());
+  EXPECT_EQ(st.n_measures, 200 * world.size());
+  EXPECT_GE(st.warmup_time_max * world.size(), st.warmup_time);
+
+  // the move set is followed by its moves
+  ASSERT_EQ(st.moves.size(), 3);
+  EXPECT_EQ(st.moves[0].name, "cheap");
+  EXPECT_EQ(st.moves[1].name, "set \"inner\"");
+  EXPECT_EQ(st.moves[2].name, "set \"inner\"/slow");
+  EXPECT_EQ(st.moves[0].n_proposed + st.moves[1].n_proposed, 3000 * world.size());
+  EXPECT_EQ(st.moves[1].n_proposed, st.moves[2].n_proposed);
+  EXPECT_EQ(st.moves[2].n_accepted, st.moves[2].n_proposed);
+  EXPECT_GT(st.moves[0].n_accepted, 0);
+  EXPECT_LT(st.moves[0].acceptance_rate(), 1);
+
+  // the sampled times : the slow move dominates, and is within the total time
+  EXPECT_GT(st.moves[2].time_attempt, 10 * st.moves[0].time_attempt);
+  EXPECT_LT(st.moves[2].time_attempt, 2 * (st.warmup_time + st.accumulation_time));
+  EXPECT_GT(st.moves[2].time_accept, 0);
+  EXPECT_EQ(st.moves[2].time_reject, 0);
+
+  ASSERT_EQ(st.measures.size(), 1);
+  EXPECT_EQ(st.measures[0].name, "nothing");
+  EXPECT_EQ(st.measures[0].count, 200 * world.size());
+
+  // JSON export
+  auto js = st.to_json();
+  EXPECT_NE(js.find("\"name\": \"set \\\"inner\\\"\""), std::string::npos);
+  EXPECT_NE(js.find("\"n_measures\": " + std::to_string(st.n_measures)), std::string::npos);
+
+  // HDF5 export
+  {
+    h5::file f("run_statistics.h5", 'w');
+    h5_write(f, "stats", st);
+  }
+  h5::file f("run_statistics.h5", 'r');
+  h5::group gr = h5::group(f).open_group("stats");
+  uint64_t n;
+  h5_read(gr.open_group("moves").open_group("set \"inner\"").open_group("slow"), "n_proposed", n);
+  EXPECT_EQ(n, st.moves[2].n_proposed);
+}
+
+TEST(RunStatistics, NestedMoveSets) {
+  // moves of the same name in different move sets, at several levels
+  mc_generic<double> mc("mt19937", 5, 0);
+  auto make_set = [&mc](bool nested) {
+    move_set<double> ms(mc.get_rng());
+    ms.add(move_cheap{}, "cheap", 1.0);
+    if (nested) {
+      move_set<double> inner(mc.get_rng());
+      inner.add(move_cheap{}, "cheap", 1.0);
+      ms.add(std::move(inner), "inner", 1.0);
+    }
+    return ms;
+  };
+  mc.add_move(make_set(false), "a");
+  mc.add_move(make_set(true), "b");
+  mc.add_measure(measure_nothing{}, "nothing");
+  mc.accumulate(100, 10, [] { return false; });
+  auto st = mc.get_run_statistics(mpi::communicator{});
+
+  std::vector<std::string> names;
+  for (auto const &m : st.moves) names.push_back(m.name);
+  EXPECT_EQ(names, (std::vector<std::string>{"a", "a/cheap", "b", "b/cheap", "b/inner", "b/inner/cheap"}));
+
+  {
+    h5::file f("run_statistics_nested.h5", 'w');
+    h5_write(f, "stats", st);
+  }
+  h5::file f("run_statistics_nested.h5", 'r');
+  h5::group gmo = h5::group(f).open_group("stats").open_group("moves");
+  for (auto const &m : st.moves) {
+    uint64_t n;
+    h5_read(gmo.open_group(m.name), "n_proposed", n);
+    EXPECT_EQ(n, m.n_proposed) << m.name;
+  }
+  EXPECT_EQ(st.moves[0].n_proposed + st.moves[2].n_proposed, 1000);
+  EXPECT_EQ(st.moves[4].n_proposed, st.moves[5].n_proposed);
+}
+
+TEST(RunStatistics, NoTiming) {
+  mc_generic<double> mc("mt19937", 5, 0);
+  mc.add_move(move_cheap{}, "cheap");
+  mc.add_measure(measure_nothing{}, "nothing");
+  mc.set_move_timing_period(0);
+  mc.accumulate(100, 10, [] { return false; });
+  auto st = mc.get_run_statistics(mpi::communicator{});
+  EXPECT_EQ(st.moves[0].time_attempt, 0);
+  EXPECT_EQ(st.moves[0].time_accept, 0);
+}
+
+MAKE_MAIN;
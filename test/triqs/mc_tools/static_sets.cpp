@@ -0,0 +1,138 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+
+using namespace triqs;
+using namespace triqs::mc_tools;
+
+TEST(StaticSets, AliasTable) {
+  std::vector<double> w = {1, 0, 2, 5, 0.5};
+  alias_table t(w);
+  random_generator rng("mt19937", 23);
+  std::vector<double> count(w.size(), 0);
+  int n = 200000;
+  for (int i = 0; i < n; ++i) count[t(rng())] += 1;
+  for (size_t i = 0; i < w.size(); ++i) EXPECT_NEAR(count[i] / n, w[i] / 8.5, 0.005);
+  EXPECT_EQ(count[1], 0);
+
+  EXPECT_THROW(alias_table({0, 0}), triqs::runtime_error);
+  EXPECT_THROW(alias_table({1, -1}), triqs::runtime_error);
+}
+
+// A walker on a line, with two moves and two measures
+struct configuration {
+  long x = 0;
+};
+
+struct move_step {
+  configuration *config;
+  long dx;
+  double attempt() { return (std::abs(config->x + dx) > 5 ? 0.5 : 1.0); }
+  double accept() {
+    config->x += dx;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct move_reflect {
+  configuration *config;
+  double attempt() { return 1; }
+  double accept() {
+    config->x = -config->x;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct measure_x {
+  configuration *config;
+  double sum = 0;
+  long n     = 0;
+  void accumulate(double) {
+    sum += config->x;
+    ++n;
+  }
+  void collect_results(mpi::communicator) {}
+  friend void h5_write(h5::group g, std::string const &name, measure_x const &m) { h5_write(g, name, m.sum); }
+  friend void h5_read(h5::group g, std::string const &name, measure_x &m) { h5_read(g, name, m.sum); }
+};
+
+struct measure_x2 {
+  configuration *config;
+  double *result;
+  double sum = 0;
+  long n     = 0;
+  void accumulate(double) {
+    sum += config->x * config->x;
+    ++n;
+  }
+  void collect_results(mpi::communicator) { *result = sum / n; }
+};
+
+TEST(StaticSets, McGeneric) {
+  configuration config;
+  mc_generic<double> mc("mt19937", 91, 0);
+  mc.set_static_moves(make_static_move_set<double>(mc.get_rng(), {"left", "right", "reflect"}, {1, 1, 0.5}, move_step{&config, -1},
+                                                   move_step{&config, 1}, move_reflect{&config}));
+  double x2 = 0;
+  auto m    = make_static_measure_set<double>({"x", "x2"}, measure_x{&config}, measure_x2{&config, &x2});
+  mc.add_measure(std::move(m), "measures");
+  int status = mc.warmup_and_accumulate(100, 10000, 10, [] { return false; });
+  EXPECT_EQ(status, 0);
+  mc.collect_results(mpi::communicator{});
+
+  // the walker is symmetric, and spends some time out of [-5,5]
+  EXPECT_GT(x2, 5);
+  auto rates = mc.get_acceptance_rates();
+  EXPECT_EQ(rates.size(), 3);
+  EXPECT_EQ(rates["reflect"], 1);
+  EXPECT_GT(rates["left"], 0.5);
+  EXPECT_LT(rates["left"], 1);
+
+  // the moves can not be mixed with add_move
+  EXPECT_THROW(mc.add_move(move_reflect{&config}, "r"), triqs::runtime_error);
+
+  // h5 : only the measure with a h5 interface is written
+  {
+    h5::file f("static_sets.h5", 'w');
+    h5_write(f, "mc", mc);
+  }
+  h5::file f("static_sets.h5", 'r');
+  h5::group gr = h5::group(f).open_group("mc").open_group("measures").open_group("measures");
+  EXPECT_TRUE(gr.has_key("x"));
+  EXPECT_FALSE(gr.has_key("x2"));
+}
+
+TEST(StaticSets, ProposalFrequencies) {
+  configuration config;
+  random_generator rng("mt19937", 4);
+  auto ms = make_static_move_set<double>(rng, {"a", "b"}, {1, 3}, move_reflect{&config}, move_reflect{&config});
+  for (int i = 0; i < 40000; ++i) {
+    ms.attempt();
+    ms.accept();
+  }
+  EXPECT_NEAR(ms.get_n_proposed()[1] / 40000.0, 0.75, 0.01);
+  EXPECT_EQ(ms.get_n_accepted()[0], ms.get_n_proposed()[0]);
+}
+
+MAKE_MAIN;
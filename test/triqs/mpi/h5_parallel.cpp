@@ -0,0 +1,88 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/gfs.hpp>
+
+// Only with a parallel hdf5 (cmake -DUSE_PARALLEL_HDF5=ON)
+
+using namespace triqs;
+using namespace triqs::arrays;
+using namespace triqs::gfs;
+
+mpi::communicator world;
+clef::placeholder<0> i_;
+clef::placeholder<1> j_;
+clef::placeholder<2> w_;
+
+TEST(H5Parallel, Array) {
+  // the full array, and the part of this process
+  array<dcomplex, 2> A(11, 3);
+  A(i_, j_) << i_ + 1_j * j_;
+  auto [f, l] = mpi::slice_range(0, 10, world.size(), world.rank());
+  array<dcomplex, 2> A_local = A(range(f, l + 1), range());
+
+  // the same, with nothing on the first process
+  array<dcomplex, 2> B_local = A_local;
+  if (world.rank() == 0) B_local.resize(0, 3);
+
+  {
+    h5::file file("h5_parallel.h5", 'w', world);
+    h5::group top(file);
+    h5_write_distributed(top, "A", A_local, world);
+    h5_write_distributed(top, "B", B_local, world);
+  }
+
+  world.barrier();
+  if (world.rank() == 0) {
+    h5::file file("h5_parallel.h5", 'r');
+    array<dcomplex, 2> B;
+    h5_read(file, "A", B);
+    EXPECT_ARRAY_EQ(B, A);
+    h5_read(file, "B", B);
+    EXPECT_ARRAY_EQ(B, A(range(l + 1, 11), range()));
+  }
+}
+
+TEST(H5Parallel, Gf) {
+  auto G = gf<refreq>{{-5, 5, 11}, {2, 2}};
+  G(w_) << 1 / (w_ + 0.1_j);
+
+  // each process holds its part of the mesh and of the data only
+  gf<refreq> G_local;
+  G_local = mpi_scatter(G, world);
+  auto [f, l] = mpi::slice_range(0, 10, world.size(), world.rank());
+  EXPECT_EQ(G_local.mesh().size(), l - f + 1);
+
+  {
+    h5::file file("h5_parallel_gf.h5", 'w', world);
+    h5_write_distributed(h5::group(file), "G", G_local, world);
+  }
+
+  world.barrier();
+  if (world.rank() == 0) {
+    h5::file file("h5_parallel_gf.h5", 'r');
+    gf<refreq> G2;
+    h5_read(file, "G", G2);
+    EXPECT_GF_NEAR(G2, G);
+  }
+}
+
+MAKE_MAIN;
@@ -77,6 +77,26 @@ TEST_F(MpiGf, ReduceView) { // all reduction of gf_view
 
 //----------------------------------------------
 
+TEST(MpiGfLinearMesh, ScatterGather) {
+  auto g = gf<refreq>{{-5, 5, 11}, {1, 1}};
+  placeholder<0> w_;
+  g(w_) << 1 / (w_ + 0.1_j);
+
+  gf<refreq> g2;
+  g2          = mpi_scatter(g, world);
+  auto [f, l] = mpi::slice_range(0, 10, world.size(), world.rank());
+  EXPECT_EQ(g2.mesh().size(), l - f + 1);
+  for (auto w : g2.mesh()) EXPECT_CLOSE(g2[w](0, 0), g[w.index() + f](0, 0));
+  g2.data() *= 2;
+
+  gf<refreq> g3;
+  g3 = mpi_all_gather(g2, world);
+  EXPECT_EQ(g3.mesh(), g.mesh());
+  EXPECT_ARRAY_NEAR(g3.data(), 2 * g.data());
+}
+
+//----------------------------------------------
+
 //TEST_F(MpiGf, ScatterGather) {
 //// scatter-gather test with ="
 //auto g2     = g1;
@@ -136,6 +156,56 @@ TEST_F(MpiGf, ReduceBlockView) {
 
 //----------------------------------------------
 
+TEST_F(MpiGf, ReduceBlockDifferentBlocks) {
+  // blocks of different sizes and values, reduced with a single collective
+  auto g2 = gf<imfreq>{{beta, Fermion, Nfreq}, {2, 2}};
+  g2(w_) << (1 + world.rank()) / (w_ - 2);
+  block_gf<imfreq> bgf = make_block_gf({g1, g2});
+  double r             = world.size() * (world.size() + 1) / 2.0;
+
+  block_gf<imfreq> bgf2 = mpi_all_reduce(bgf);
+  EXPECT_ARRAY_NEAR(bgf2[0].data(), world.size() * g1.data());
+  EXPECT_ARRAY_NEAR(bgf2[1].data(), r / (1 + world.rank()) * g2.data());
+
+  // in place, on the view
+  bgf() = mpi_reduce(bgf);
+  if (world.rank() == 0) EXPECT_ARRAY_NEAR(bgf[1].data(), r * g2.data());
+
+  // the view must have the same block shapes
+  auto bgf3 = make_block_gf({g1, g1});
+  EXPECT_THROW(bgf3() = mpi_reduce(bgf2), triqs::runtime_error);
+}
+
+//----------------------------------------------
+
+TEST_F(MpiGf, ReduceBlock2) {
+  auto g2 = gf<imfreq>{{beta, Fermion, Nfreq}, {2, 2}};
+  g2(w_) << (1 + world.rank()) / (w_ - 2);
+  auto bgf = make_block2_gf({"a", "b"}, {"x", "y", "z"}, std::vector<std::vector<gf<imfreq>>>{{g1, g2, g1}, {g2, g1, g2}});
+  double r = world.size() * (world.size() + 1) / 2.0;
+
+  block2_gf<imfreq> bgf2 = mpi_all_reduce(bgf);
+  EXPECT_ARRAY_NEAR(bgf2(0, 0).data(), world.size() * g1.data());
+  EXPECT_ARRAY_NEAR(bgf2(1, 2).data(), r / (1 + world.rank()) * g2.data());
+
+  bgf2() = mpi_reduce(bgf);
+  if (world.rank() == 0) EXPECT_ARRAY_NEAR(bgf2(0, 1).data(), r / (1 + world.rank()) * g2.data());
+}
+
+//----------------------------------------------
+
+TEST_F(MpiGf, ReduceVectorOfGf) {
+  std::vector<gf<imfreq>> v{g1, g1, g1};
+  auto v2 = mpi_all_reduce(v, world);
+  EXPECT_EQ(v2.size(), 3);
+  EXPECT_ARRAY_NEAR(v2[2].data(), world.size() * g1.data());
+
+  mpi_reduce_in_place(v, world, 0, true);
+  EXPECT_ARRAY_NEAR(v[1].data(), world.size() * g1.data());
+}
+
+//----------------------------------------------
+
 //TEST_F(MpiGf, final) {
 //auto g10 = gf<imfreq>{{beta, Fermion, Nfreq}, {1, 1}};
 //g10(w_) << 1 / (w_ + 1);
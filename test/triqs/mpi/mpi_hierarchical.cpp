@@ -0,0 +1,99 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/gfs.hpp>
+#include <memory>
+
+using namespace triqs;
+using namespace triqs::arrays;
+using namespace triqs::gfs;
+using namespace triqs::mpi;
+
+
+mpi::communicator world;
+clef::placeholder<0> i_;
+clef::placeholder<1> j_;
+clef::placeholder<2> w_;
+
+// The processes of the machine (a single node), or split in two groups as if there were two nodes
+class MpiHierarchical : public ::testing::TestWithParam<bool> {
+  protected:
+  std::unique_ptr<node_topology> t;
+  void SetUp() override {
+    if (GetParam())
+      t = std::make_unique<node_topology>(world, world.split(world.rank() % 2, world.rank()));
+    else
+      t = std::make_unique<node_topology>(world);
+  }
+};
+
+TEST_P(MpiHierarchical, Array) {
+  array<double, 2> A(5, 3), A0(5, 3);
+  A(i_, j_) << i_ + 10 * j_ + world.rank();
+  A0(i_, j_) << i_ + 10 * j_;
+  double r = world.size() * (world.size() - 1) / 2.0;
+
+  for (int root = 0; root < world.size(); ++root) {
+    auto B = A;
+    mpi_hierarchical_reduce(B, *t, root);
+    if (world.rank() == root) EXPECT_ARRAY_NEAR(B, world.size() * A0 + r);
+  }
+
+  auto B = A;
+  mpi_hierarchical_all_reduce(B(range(1, 3), range()), *t);
+  EXPECT_ARRAY_NEAR(B(range(1, 3), range()), world.size() * A0(range(1, 3), range()) + r);
+  EXPECT_ARRAY_NEAR(B(0, range()), A(0, range()));
+
+  EXPECT_THROW(mpi_hierarchical_reduce(B(range(), 0), *t), triqs::runtime_error);
+}
+
+TEST_P(MpiHierarchical, Gf) {
+  auto g = gf<imfreq>{{10, Fermion, 8}, {2, 2}};
+  g(w_) << 1 / (w_ + 1);
+  auto g0 = g;
+
+  mpi_hierarchical_all_reduce(g, *t);
+  EXPECT_ARRAY_NEAR(g.data(), world.size() * g0.data());
+
+  // block_gf, blocks of different sizes
+  auto g1 = gf<imfreq>{{10, Fermion, 8}, {1, 1}};
+  g1(w_) << 1 / (w_ - 1);
+  auto bg   = make_block_gf({g0, g1});
+  int root = world.size() - 1;
+  mpi_hierarchical_reduce(bg, *t, root);
+  if (world.rank() == root) {
+    EXPECT_ARRAY_NEAR(bg[0].data(), world.size() * g0.data());
+    EXPECT_ARRAY_NEAR(bg[1].data(), world.size() * g1.data());
+  }
+
+  auto bg2 = make_block2_gf({"a"}, {"x", "y"}, std::vector<std::vector<gf<imfreq>>>{{g0, g1}});
+  mpi_hierarchical_all_reduce(bg2, *t);
+  EXPECT_ARRAY_NEAR(bg2(0, 1).data(), world.size() * g1.data());
+
+  // vector of gf
+  auto v = std::vector<gf<imfreq>>{g0, g1};
+  mpi_reduce_in_place_packed(v, *t, 0, true);
+  EXPECT_ARRAY_NEAR(v[1].data(), world.size() * g1.data());
+}
+
+INSTANTIATE_TEST_CASE_P(Nodes, MpiHierarchical, ::testing::Values(false, true));
+
+MAKE_MAIN;
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/gfs.hpp>
+
+using namespace triqs;
+using namespace triqs::arrays;
+using namespace triqs::gfs;
+using namespace triqs::mpi;
+
+mpi::communicator world;
+clef::placeholder<0> i_;
+clef::placeholder<1> j_;
+clef::placeholder<2> w_;
+
+TEST(MpiIReduce, Array) {
+  array<double, 2> A(5, 3), A0(5, 3);
+  A(i_, j_) << i_ + 10 * j_ + world.rank();
+  A0(i_, j_) << i_ + 10 * j_;
+  double r = world.size() * (world.size() - 1) / 2.0;
+
+  auto B   = A;
+  auto req = mpi_ireduce(B, world);
+  // ... some work here
+  req.wait();
+  if (world.rank() == 0) EXPECT_ARRAY_NEAR(B, world.size() * A0 + r);
+  if (world.rank() != 0) EXPECT_ARRAY_NEAR(B, A); // untouched
+
+  // all reduce, on a view, polling with test
+  B         = A;
+  auto req2 = mpi_iallreduce(B(range(1, 3), range()), world);
+  while (!req2.test()) {}
+  EXPECT_ARRAY_NEAR(B(range(1, 3), range()), world.size() * A0(range(1, 3), range()) + r);
+  EXPECT_ARRAY_NEAR(B(0, range()), A(0, range()));
+
+  // non contiguous view
+  EXPECT_THROW(mpi_ireduce(B(range(), 0), world), triqs::runtime_error);
+}
+
+TEST(MpiIReduce, Chunks) {
+  mpi::max_count = 4;
+  array<dcomplex, 1> A(11), A0(11);
+  A(i_) << i_ * (1 + world.rank());
+  A0(i_) << i_;
+  {
+    auto req = mpi_iallreduce(A, world);
+  } // the destructor waits for completion
+  EXPECT_ARRAY_NEAR(A, world.size() * (world.size() + 1) / 2 * A0);
+  mpi::max_count = std::numeric_limits<int>::max();
+}
+
+TEST(MpiIReduce, CompletionError) {
+  auto throwing = []() { TRIQS_RUNTIME_ERROR << "completion"; };
+
+  // rethrown by wait and test, once
+  mpi::request r1({}, throwing);
+  EXPECT_THROW(r1.wait(), triqs::runtime_error);
+  EXPECT_NO_THROW(r1.wait());
+  mpi::request r2({}, throwing);
+  EXPECT_THROW(r2.test(), triqs::runtime_error);
+
+  // only reported by the destructor
+  EXPECT_NO_THROW({ mpi::request r3({}, throwing); });
+}
+
+TEST(MpiIReduce, Gf) {
+  auto g = gf<imfreq>{{10, Fermion, 8}, {2, 2}};
+  g(w_) << 1 / (w_ + 1);
+  auto g0 = g;
+
+  auto req = mpi_iallreduce(g, world);
+  req.wait();
+  EXPECT_ARRAY_NEAR(g.data(), world.size() * g0.data());
+
+  // block_gf, blocks of different sizes, in one collective
+  auto g1 = gf<imfreq>{{10, Fermion, 8}, {1, 1}};
+  g1(w_) << 1 / (w_ - 1);
+  auto bg = make_block_gf({g0, g1});
+
+  mpi::request r1 = mpi_ireduce(bg, world);
+  r1.wait();
+  if (world.rank() == 0) {
+    EXPECT_ARRAY_NEAR(bg[0].data(), world.size() * g0.data());
+    EXPECT_ARRAY_NEAR(bg[1].data(), world.size() * g1.data());
+  }
+
+  auto bg2 = make_block2_gf({"a"}, {"x", "y"}, std::vector<std::vector<gf<imfreq>>>{{g0, g1}});
+  auto r2  = mpi_iallreduce(bg2, world);
+  r2.wait();
+  EXPECT_ARRAY_NEAR(bg2(0, 1).data(), world.size() * g1.data());
+}
+
+MAKE_MAIN;
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/arrays.hpp>
+#include <triqs/mpi/vector.hpp>
+
+using namespace triqs;
+using namespace triqs::arrays;
+using namespace triqs::mpi;
+
+// Messages larger than mpi::max_count elements are split in chunks, or sent point-to-point.
+// Instead of arrays of more than 2^31 elements, we lower max_count to a few elements.
+
+mpi::communicator world;
+clef::placeholder<0> i_;
+clef::placeholder<1> j_;
+
+class MpiLargeCount : public ::testing::TestWithParam<long> {
+  protected:
+  void SetUp() override { mpi::max_count = GetParam(); }
+  void TearDown() override { mpi::max_count = std::numeric_limits<int>::max(); }
+};
+
+TEST_P(MpiLargeCount, Array) {
+  using arr_t = array<std::complex<double>, 2>;
+  arr_t A(11, 3), B, AA;
+  A(i_, j_) << i_ + 10 * j_;
+  auto se = mpi::slice_range(0, 10, world.size(), world.rank());
+
+  B = mpi_scatter(A, world);
+  EXPECT_ARRAY_EQ(B, A(range(se.first, se.second + 1), range()));
+
+  AA = mpi_gather(B, world);
+  if (world.rank() == 0) EXPECT_ARRAY_NEAR(AA, A);
+
+  AA = mpi_all_gather(B, world);
+  EXPECT_ARRAY_NEAR(AA, A);
+
+  arr_t C(11, 3);
+  if (world.rank() == 0) C = A;
+  mpi_broadcast(C, world);
+  EXPECT_ARRAY_NEAR(C, A);
+
+  arr_t r1 = mpi_reduce(A, world);
+  if (world.rank() == 0) EXPECT_ARRAY_NEAR(r1, world.size() * A);
+
+  arr_t r2 = mpi_all_reduce(A, world);
+  EXPECT_ARRAY_NEAR(r2, world.size() * A);
+
+  C = mpi_all_reduce(C, world); // in place
+  EXPECT_ARRAY_NEAR(C, world.size() * A);
+}
+
+TEST_P(MpiLargeCount, Vector) {
+  std::vector<long> v(13);
+  for (int i = 0; i < 13; ++i) v[i] = i + 1;
+
+  auto b = mpi_scatter(v, world);
+  EXPECT_EQ(b.size(), mpi::slice_length(12, world.size(), world.rank()));
+  EXPECT_EQ(mpi_all_gather(b, world), v);
+
+  auto r = mpi_all_reduce(v, world);
+  for (int i = 0; i < 13; ++i) EXPECT_EQ(r[i], world.size() * (i + 1));
+
+  mpi_reduce_in_place(v, world);
+  if (world.rank() == 0) EXPECT_EQ(v, r);
+
+  mpi_broadcast(v, world);
+  EXPECT_EQ(v, r);
+}
+
+INSTANTIATE_TEST_CASE_P(MaxCount, MpiLargeCount, ::testing::Values(std::numeric_limits<int>::max(), 1, 4));
+
+MAKE_MAIN;
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/arrays.hpp>
+
+using namespace triqs;
+using namespace triqs::arrays;
+
+mpi::communicator world;
+clef::placeholder<0> i_;
+clef::placeholder<1> j_;
+
+TEST(NodeShared, Array) {
+  auto node = world.split_shared();
+  int root  = world.size() - 1;
+
+  array<dcomplex, 2> A0(5, 3);
+  A0(i_, j_) << i_ + 10 * j_;
+
+  {
+    auto A = make_node_shared_array<dcomplex, 2>({5, 3}, node);
+    EXPECT_EQ(A.shape(), A0.shape());
+
+    if (world.rank() == root) A = A0;
+    mpi_broadcast_node_shared(A, world, node, root);
+    EXPECT_ARRAY_NEAR(A, A0);
+
+    // the memory is shared on the node
+    node.barrier();
+    if (node.rank() == node.size() - 1) A(0, 0) = -1;
+    node.barrier();
+    EXPECT_EQ(A(0, 0), dcomplex(-1));
+
+    // views, copies
+    array_view<dcomplex, 1> V = A(1, range());
+    EXPECT_ARRAY_NEAR(V, A0(1, range()));
+    array<dcomplex, 2> B = A; // a private copy
+    node.barrier();
+    B(1, 1) = 100;
+    EXPECT_EQ(A(1, 1), A0(1, 1));
+  } // the window is released here, on all processes
+}
+
+TEST(NodeShared, SeveralGroups) {
+  // two groups of processes on this node, as if they were two nodes : the data is sent to both
+  auto group = world.split(world.rank() % 2);
+  array<double, 1> A0(7);
+  A0(i_) << 2 * i_;
+  auto A = make_node_shared_array<double, 1>({7}, group);
+  if (world.rank() == 0) A = A0;
+  mpi_broadcast_node_shared(A, world, group);
+  EXPECT_ARRAY_NEAR(A, A0);
+}
+
+TEST(NodeShared, Empty) {
+  auto node = world.split_shared();
+  auto A    = make_node_shared_array<double, 1>({0}, node);
+  EXPECT_EQ(A.size(), 0);
+}
+
+MAKE_MAIN;
@@ -49,6 +49,68 @@ TEST(MPI, vector_reduce) {
 
 // -----------------------------------
 
+TEST(MPI, vector_of_arrays_reduce) {
+
+  mpi::communicator world;
+
+  // arrays of different sizes, reduced in a single collective
+  std::vector<array<double, 2>> A{array<double, 2>(2, 3), array<double, 2>(4, 1)};
+  for (auto &a : A) {
+    clef::placeholder<0> i_;
+    clef::placeholder<1> j_;
+    a(i_, j_) << i_ + 10 * j_ + world.rank();
+  }
+  double r = world.size() * (world.size() - 1) / 2.0;
+
+  auto B = mpi_all_reduce(A, world);
+  for (int k = 0; k < 2; ++k) EXPECT_ARRAY_NEAR(B[k], world.size() * (A[k] - world.rank()) + r);
+
+  auto C = A;
+  mpi_reduce_in_place(C, world);
+  if (world.rank() == 0)
+    for (int k = 0; k < 2; ++k) EXPECT_ARRAY_NEAR(C[k], B[k]);
+}
+
+// -----------------------------------
+
+TEST(MPI, packed_reduce_layouts) {
+
+  mpi::communicator world;
+
+  // contiguous data are copied at once, the others element by element : the two must agree on the order
+  array<double, 2> a(3, 4), b(3, 4, FORTRAN_LAYOUT);
+  clef::placeholder<0> i_;
+  clef::placeholder<1> j_;
+  a(i_, j_) << i_ + 10 * j_ + world.rank();
+  b(i_, j_) << 2 * i_ - j_ + world.rank();
+  auto a_v = a(range(0, 3, 2), range());
+
+  packed_reduce<double> p;
+  p.pack(a);
+  p.pack(b);
+  p.pack(a_v);
+  EXPECT_EQ(p.size(), 12 + 12 + 8);
+
+  array<double, 2> ra(3, 4, FORTRAN_LAYOUT), rb(3, 4), rv(3, 4);
+  rv() = 0;
+  auto rv_v = rv(range(0, 3, 2), range());
+  if (p.reduce(world, 0, true)) {
+    p.unpack(ra);
+    p.unpack(rb);
+    p.unpack(rv_v);
+  }
+  double r = world.size() * (world.size() - 1) / 2.0;
+  EXPECT_ARRAY_NEAR(ra, world.size() * (a - world.rank()) + r);
+  EXPECT_ARRAY_NEAR(rb, world.size() * (b - world.rank()) + r);
+  EXPECT_ARRAY_NEAR(rv_v, world.size() * (a_v - world.rank()) + r);
+  EXPECT_EQ(rv(1, 0), 0);
+
+  array<double, 1> too_large(1);
+  EXPECT_THROW(p.unpack(too_large), std::out_of_range);
+}
+
+// -----------------------------------
+
 TEST(MPI, vector_gather_scatter) {
 
   mpi::communicator world;
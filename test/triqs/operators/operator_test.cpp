@@ -236,4 +236,62 @@ TEST(Operator, RealOrComplex) {
   EXPECT_EQ(fundamental_operator_set::reduction_t(fs), fundamental_operator_set::reduction_t(fs2));
 }
 
+TEST(Operator, ParallelProduct) {
+  // quadratic + quartic operator, large enough for the product to be split over threads
+  many_body_operator_real H;
+  for (int i = 0; i < 6; ++i)
+    for (int j = 0; j < 6; ++j) {
+      H += 0.1 * (i + 2 * j) * c_dag<double>(i) * c<double>(j);
+      for (int k = 0; k < 6; ++k)
+        for (int l = 0; l < 6; ++l) H += 0.01 * std::cos(i + 2 * j * j + 3 * k * l + 5 * l) * c_dag<double>(i) * c_dag<double>(j) * c<double>(l) * c<double>(k);
+    }
+  EXPECT_GT(H.get_monomials().size() * H.get_monomials().size(), detail::parallel_product_threshold);
+
+#ifdef _OPENMP
+  int n_threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  auto H2_ref = H * H;
+  omp_set_num_threads(std::max(n_threads, 3));
+  auto H2 = H * H;
+  omp_set_num_threads(n_threads);
+  assert_operators_are_close(H2, H2_ref, 1e-12);
+#endif
+
+  // check against the product computed term by term
+  many_body_operator_real H2_terms;
+  for (auto const &x : H) {
+    many_body_operator_real m = x;
+    for (auto const &y : H) H2_terms += m * many_body_operator_real(y);
+  }
+  assert_operators_are_close(H * H, H2_terms, 1e-12);
+
+  // monomials longer than the stack buffer
+  auto X = c_dag<double>(0) * c_dag<double>(1) * c_dag<double>(2) * c_dag<double>(3) * c_dag<double>(4);
+  auto P = dagger(X) * X; // projector on the empty state
+  many_body_operator_real P_ref(1.0);
+  for (int i = 0; i < 5; ++i) P_ref *= 1.0 - n<double>(i);
+  assert_operators_are_close(P, P_ref, 1e-14);
+  assert_operators_are_close(P * P, P, 1e-14);
+}
+
+TEST(Operator, ParallelProductError) {
+  // an exception in a thread is rethrown after the parallel region
+  std::map<int, double> a, b, res;
+  for (int i = 0; i < 200; ++i) a[i] = b[i] = 1;
+  auto make_worker = [] {
+    return [](auto const &x, auto const &y, std::map<int, double> &acc) {
+      if (x.first == 150) TRIQS_RUNTIME_ERROR << "product error";
+      acc[x.first + y.first] += x.second * y.second;
+    };
+  };
+#ifdef _OPENMP
+  int n_threads = omp_get_max_threads();
+  omp_set_num_threads(std::max(n_threads, 3));
+#endif
+  EXPECT_THROW(detail::product_in_chunks(a, b, res, make_worker), triqs::runtime_error);
+#ifdef _OPENMP
+  omp_set_num_threads(n_threads);
+#endif
+}
+
 MAKE_MAIN;
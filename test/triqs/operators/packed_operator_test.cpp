@@ -0,0 +1,136 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by I. Krivenko
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include <triqs/utility/first_include.hpp>
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/operators/packed_operator.hpp>
+#include <string>
+#include <vector>
+
+using namespace triqs::operators;
+using namespace triqs;
+using triqs::hilbert_space::fundamental_operator_set;
+
+// indices (0..3) and ('up'|'dn', 0..1) mixed in one set
+auto make_fops() {
+  fundamental_operator_set fops;
+  for (int i = 0; i < 4; ++i) fops.insert(i);
+  for (auto s : {"up", "dn"})
+    for (int o = 0; o < 2; ++o) fops.insert(s, o);
+  return std::make_shared<fundamental_operator_set const>(fops);
+}
+
+TEST(PackedOperator, Encoding) {
+  // byte order is the canonical order
+  for (int n = 0; n < 127; ++n) {
+    EXPECT_EQ(packed_monomial_t::linear_index(packed_monomial_t::encode(true, n)), n);
+    EXPECT_EQ(packed_monomial_t::linear_index(packed_monomial_t::encode(false, n)), n);
+    EXPECT_LT(packed_monomial_t::encode(true, n), packed_monomial_t::encode(false, n));
+    EXPECT_EQ(packed_monomial_t::encode(true, n) + packed_monomial_t::encode(false, n), 256);
+    if (n > 0) {
+      EXPECT_LT(packed_monomial_t::encode(true, n - 1), packed_monomial_t::encode(true, n));
+      EXPECT_GT(packed_monomial_t::encode(false, n - 1), packed_monomial_t::encode(false, n));
+    }
+  }
+}
+
+TEST(PackedOperator, Real) {
+  auto fops = make_fops();
+  auto C    = [&](int i) { return packed_c<double>(fops, i); };
+  auto Cd   = [&](int i) { return packed_c_dag<double>(fops, i); };
+
+  // anticommutators & commutators
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j) {
+      EXPECT_PRINT((i == j ? "1" : "0"), Cd(i) * C(j) + C(j) * Cd(i));
+      assert_operators_are_close((Cd(i) * C(j) - C(j) * Cd(i)).to_many_body_operator(),
+                                 c_dag<double>(i) * c<double>(j) - c<double>(j) * c_dag<double>(i), 1e-14);
+    }
+
+  // Algebra
+  auto x = C(0), y = Cd(1);
+  EXPECT_PRINT("1*c(0)", x);
+  EXPECT_PRINT("-1*c(0)", -x);
+  EXPECT_PRINT("2 + 1*c(0)", x + 2.0);
+  EXPECT_PRINT("2 + -1*c(0)", 2.0 - x);
+  EXPECT_PRINT("3*c_dag(1)", 3.0 * y);
+  EXPECT_PRINT("2*c_dag(1)*c(0)", (x + y) * (x - y));
+  EXPECT_PRINT("0", x * x);
+
+  // N^3
+  auto N  = packed_n<double>(fops, "up", 0) + packed_n<double>(fops, "dn", 0);
+  auto N3 = N * N * N;
+  EXPECT_PRINT("1*c_dag('dn',0)*c('dn',0) + 1*c_dag('up',0)*c('up',0)", N);
+  EXPECT_PRINT("1*c_dag('dn',0)*c('dn',0) + 1*c_dag('up',0)*c('up',0) + 6*c_dag('dn',0)*c_dag('up',0)*c('up',0)*c('dn',0)", N3);
+
+  // Dagger
+  auto X = Cd(1) * Cd(2) * C(3) * C(0);
+  EXPECT_PRINT("1*c_dag(1)*c_dag(2)*c(3)*c(0)", X);
+  EXPECT_PRINT("1*c_dag(0)*c_dag(3)*c(2)*c(1)", dagger(X));
+
+  // Monomials longer than the packed width
+  auto Y = Cd(0) * Cd(1) * Cd(2) * Cd(3) * packed_c_dag<double>(fops, "up", 0);
+  EXPECT_THROW(Y * dagger(Y), triqs::runtime_error);
+}
+
+TEST(PackedOperator, Complex) {
+  auto fops = make_fops();
+  auto X    = (1 + 2_j) * packed_c_dag<dcomplex>(fops, 1) * packed_c_dag<dcomplex>(fops, 2) * packed_c<dcomplex>(fops, 3)
+     * packed_c<dcomplex>(fops, 0);
+  EXPECT_PRINT("(1,2)*c_dag(1)*c_dag(2)*c(3)*c(0)", X);
+  EXPECT_PRINT("(1,-2)*c_dag(0)*c_dag(3)*c(2)*c(1)", dagger(X));
+}
+
+TEST(PackedOperator, Conversion) {
+  auto fops = make_fops();
+
+  // a quadratic + quartic operator with random-looking coefficients
+  many_body_operator_real H;
+  std::vector<many_body_operator_real> cd, cc;
+  for (int i = 0; i < 4; ++i) {
+    cd.push_back(c_dag<double>(i));
+    cc.push_back(c<double>(i));
+  }
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j) {
+      H += 0.1 * (i + 2 * j) * cd[i] * cc[j];
+      for (int k = 0; k < 4; ++k)
+        for (int l = 0; l < 4; ++l) H += 0.01 * (i - j + 3 * k * l) * cd[i] * cd[j] * cc[l] * cc[k];
+    }
+
+  auto pH = packed_operator_real(H, fops);
+  EXPECT_EQ(pH.size(), H.get_monomials().size());
+  assert_operators_are_close(pH.to_many_body_operator(), H, 1e-14);
+
+  // Products and commutators agree with many_body_operator
+  auto pcd0 = packed_c_dag<double>(fops, 0);
+  assert_operators_are_close((pH * pcd0 - pcd0 * pH).to_many_body_operator(), H * cd[0] - cd[0] * H, 1e-12);
+  assert_operators_are_close((pH * pH).to_many_body_operator(), H * H, 1e-12);
+  assert_operators_are_close(dagger(pH).to_many_body_operator(), dagger(H), 1e-14);
+
+  // Index not in the set
+  EXPECT_THROW(packed_operator_real(c<double>(7), fops), triqs::runtime_error);
+
+  // Operators on different sets can not be combined
+  auto fops2 = std::make_shared<fundamental_operator_set const>(fundamental_operator_set{std::vector<int>{4}});
+  EXPECT_THROW(pH + packed_c<double>(fops2, 0, 0), triqs::runtime_error);
+}
+
+MAKE_MAIN;
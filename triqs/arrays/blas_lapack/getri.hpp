@@ -34,23 +34,34 @@ namespace triqs::arrays::lapack {
   inline size_t r_round(double x) { return std::round(x) + 1; }
   inline size_t r_round(std::complex<double> x) { return std::round(std::real(x)) + 1; }
   /**
-  * Calls getri on a matrix or view
+  * Calls getri on a matrix or view, with a workspace
   * Takes care of making temporary copies if necessary
+  * work is resized to the optimal size if it is too small, so it can be reused for several calls.
   */
   template <typename MT>
-  typename std::enable_if<is_blas_lapack_type<typename MT::value_type>::value, int>::type getri(MT &A, arrays::vector<int> &ipiv) {
-    //getri (MT & A, arrays::vector<int> & ipiv, arrays::vector<typename MT::value_type> & work ) {
+  typename std::enable_if<is_blas_lapack_type<typename MT::value_type>::value, int>::type getri(MT &A, arrays::vector<int> &ipiv,
+                                                                                                arrays::vector<typename MT::value_type> &work) {
     reflexive_qcache<MT> Ca(A);
     auto dm = std::min(first_dim(Ca()), second_dim(Ca()));
     if (ipiv.size() < dm) TRIQS_RUNTIME_ERROR << "getri : error in ipiv size : found " << ipiv.size() << " while it should be at least" << dm;
     int info;
-    typename MT::value_type work1[2];
-    // first call to get the optimal lwork
-    f77::getri(get_n_rows(Ca()), Ca().data_start(), get_ld(Ca()), ipiv.data_start(), work1, -1, info);
-    int lwork = r_round(work1[0]);
-    //std::cerr << " Optimisation lwork "<< lwork<< std::endl;
-    arrays::vector<typename MT::value_type> work(lwork);
-    f77::getri(get_n_rows(Ca()), Ca().data_start(), get_ld(Ca()), ipiv.data_start(), work.data_start(), lwork, info);
+    if (work.size() < std::max<size_t>(dm, 1)) {
+      typename MT::value_type work1[2];
+      // first call to get the optimal lwork
+      f77::getri(get_n_rows(Ca()), Ca().data_start(), get_ld(Ca()), ipiv.data_start(), work1, -1, info);
+      work.resize(std::max<size_t>(r_round(work1[0]), dm));
+    }
+    f77::getri(get_n_rows(Ca()), Ca().data_start(), get_ld(Ca()), ipiv.data_start(), work.data_start(), work.size(), info);
     return info;
   }
+
+  /**
+  * Calls getri on a matrix or view
+  * Takes care of making temporary copies if necessary
+  */
+  template <typename MT>
+  typename std::enable_if<is_blas_lapack_type<typename MT::value_type>::value, int>::type getri(MT &A, arrays::vector<int> &ipiv) {
+    arrays::vector<typename MT::value_type> work;
+    return getri(A, ipiv, work);
+  }
 } // namespace triqs::arrays::lapack
@@ -21,6 +21,7 @@
 #ifndef TRIQS_ARRAYS_EXPRESSION_ARRAY_ALGEBRA_H
 #define TRIQS_ARRAYS_EXPRESSION_ARRAY_ALGEBRA_H
 #include "./tools.hpp"
+#include "../impl/flat_access.hpp"
 namespace triqs {
   namespace arrays {
 
@@ -96,6 +97,32 @@ namespace triqs {
       template <typename T> void operator-=(T &&x) = delete; // can not -= into an expression template !
     };
 
+    // Flat evaluation of the expressions (cf impl/flat_access.hpp)
+    template <typename S> struct flat_access<_scalar_wrap<S, false>> {
+      static constexpr bool value = true;
+      template <typename LHS> static bool compatible(_scalar_wrap<S, false> const &, LHS const &) { return true; }
+      static S get(_scalar_wrap<S, false> const &x, long) { return x.s; }
+    };
+
+    template <typename Tag, typename L, typename R> struct flat_access<array_expr<Tag, L, R>> {
+      using fL                    = flat_access<std::decay_t<L>>;
+      using fR                    = flat_access<std::decay_t<R>>;
+      static constexpr bool value = fL::value and fR::value;
+      template <typename LHS> static bool compatible(array_expr<Tag, L, R> const &x, LHS const &lhs) {
+        return fL::compatible(x.l, lhs) and fR::compatible(x.r, lhs);
+      }
+      static typename array_expr<Tag, L, R>::value_type get(array_expr<Tag, L, R> const &x, long i) {
+        return utility::operation<Tag>()(fL::get(x.l, i), fR::get(x.r, i));
+      }
+    };
+
+    template <typename L> struct flat_access<array_unary_m_expr<L>> {
+      using fL                    = flat_access<std::decay_t<L>>;
+      static constexpr bool value = fL::value;
+      template <typename LHS> static bool compatible(array_unary_m_expr<L> const &x, LHS const &lhs) { return fL::compatible(x.l, lhs); }
+      static typename array_unary_m_expr<L>::value_type get(array_unary_m_expr<L> const &x, long i) { return -fL::get(x.l, i); }
+    };
+
     // Now we can define all the C++ operators ...
 #define DEFINE_OPERATOR(TAG, OP, TRAIT1, TRAIT2)                                                                                                     \
   template <typename A1, typename A2>                                                                                                                \
@@ -40,7 +40,7 @@ namespace triqs {
     template <typename A, typename B> typename _matmul_rvalue<A, B>::type operator*(A const &a, B const &b) {
       if (second_dim(a) != first_dim(b)) TRIQS_RUNTIME_ERROR << "Matrix product : dimension mismatch in A*B " << a << " " << b;
       auto R = typename _matmul_rvalue<A, B>::type(first_dim(a), second_dim(b));
-      blas::gemm(1.0, a, b, 0.0, R);
+      if (!small_matrix::gemm(a, b, R)) blas::gemm(1.0, a, b, 0.0, R);
       return R;
     }
 
@@ -21,6 +21,7 @@
 #ifndef TRIQS_ARRAYS_EXPRESSION_MAP_H
 #define TRIQS_ARRAYS_EXPRESSION_MAP_H
 #include "../impl/common.hpp"
+#include "../impl/flat_access.hpp"
 #include <functional>
 //#include "../../utility/function_arg_ret_type.hpp"
 
@@ -98,6 +99,26 @@ namespace triqs {
     //template<typename F, int arity, bool b, typename A> struct ImmutableMatrix<map_impl_result<F,arity,b,A>> : ImmutableMatrix<A>{};
     //template<typename F, int arity, bool b, typename A> struct ImmutableVector<map_impl_result<F,arity,b,A>> : ImmutableVector<A>{};
 
+    // Flat evaluation (cf impl/flat_access.hpp)
+    template <typename F, bool b, typename A> struct flat_access<map_impl_result<F, 1, b, A>> {
+      using fA                    = flat_access<std::decay_t<A>>;
+      static constexpr bool value = fA::value;
+      template <typename LHS> static bool compatible(map_impl_result<F, 1, b, A> const &x, LHS const &lhs) { return fA::compatible(x.a, lhs); }
+      static typename map_impl_result<F, 1, b, A>::value_type get(map_impl_result<F, 1, b, A> const &x, long i) { return x.f(fA::get(x.a, i)); }
+    };
+
+    template <typename F, bool b, typename A, typename B> struct flat_access<map_impl_result<F, 2, b, A, B>> {
+      using fA                    = flat_access<std::decay_t<A>>;
+      using fB                    = flat_access<std::decay_t<B>>;
+      static constexpr bool value = fA::value and fB::value;
+      template <typename LHS> static bool compatible(map_impl_result<F, 2, b, A, B> const &x, LHS const &lhs) {
+        return fA::compatible(x.a, lhs) and fB::compatible(x.b, lhs);
+      }
+      static typename map_impl_result<F, 2, b, A, B>::value_type get(map_impl_result<F, 2, b, A, B> const &x, long i) {
+        return x.f(fA::get(x.a, i), fB::get(x.b, i));
+      }
+    };
+
     // NB The bool is to make constructor not ambiguous
     // clang on os X with lib++ has a pb otherwise (not clear what the pb is)
     template <class F, int arity> class map_impl {
@@ -24,6 +24,11 @@
 #include <triqs/h5.hpp>
 #include "./simple_read_write.hpp"
 #include <triqs/h5/base.hpp>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
 
 namespace triqs {
   namespace arrays {
@@ -51,8 +56,18 @@ namespace triqs {
       h5::dataset d_set;
       array<T, dim + 1> buffer;
 
+      // async mode : the full buffer is swapped with spare, which a background thread writes to the file
+      bool async;
+      array<T, dim + 1> spare;
+      size_t spare_step = 0; // number of elements in spare to be written. 0 : the writer is idle
+      bool stop         = false;
+      std::exception_ptr writer_error;
+      std::mutex mut;
+      std::condition_variable cv;
+      std::thread writer;
+
       public:
-      array_stack_impl(h5::group g, std::string const &name, mini_vector<size_t, dim> const &base_element_shape, size_t bufsize) {
+      array_stack_impl(h5::group g, std::string const &name, mini_vector<size_t, dim> const &base_element_shape, size_t bufsize, bool async_ = false) {
         mini_vector<hsize_t, RANK> dim_chunk;
         bufsize_ = bufsize;
         step     = 0;
@@ -70,16 +85,52 @@ namespace triqs {
         for (size_t i = 0; i <= dim; ++i) { s[i] = buffer_dim[i]; }
         buffer.resize(s);
         h5::dataspace mspace1 = H5Screate_simple(RANK, dims.ptr(), maxdims.ptr());
-        h5::proplist cparms   = H5Pcreate(H5P_DATASET_CREATE);
-        //auto err = H5Pset_chunk(cparms, RANK, dim_chunk.ptr());
-        H5Pset_deflate(cparms, 8);
-        H5Pset_chunk(cparms, RANK, dim_chunk.ptr());
+        // chunks of one element of the stack by default, or of up to bufsize elements with a target chunk size
+        auto const &policy = g.get_write_policy();
+        if (policy.chunk_bytes > 0) dim_chunk[0] = bufsize_;
+        std::vector<hsize_t> chunk_max(dim_chunk.ptr(), dim_chunk.ptr() + RANK);
+        h5::proplist cparms = h5::dataset_create_proplist(policy, chunk_max, sizeof(T) / (T_is_complex ? 2 : 1), true);
         d_set = g.create_dataset(name, h5::native_type_from_C(T()), mspace1, cparms);
         if (triqs::is_complex<T>::value) h5_write_attribute(d_set, "__complex__", "1");
+
+        // the HDF5 calls of the writer thread run concurrently with the ones of the caller : only with a thread-safe library
+        hbool_t threadsafe = false;
+        H5is_library_threadsafe(&threadsafe);
+        async = async_ and threadsafe;
+        if (async) {
+          spare.resize(s);
+          writer = std::thread([this] { writer_loop(); });
+        }
       }
 
-      ///
-      ~array_stack_impl() { flush(); }
+      array_stack_impl(array_stack_impl const &) = delete;
+      array_stack_impl &operator=(array_stack_impl const &) = delete;
+
+      /**
+       * Flush the buffer, wait until all the data is written in the file and stop the writer thread.
+       * A destructor can not throw : a write error is only reported on std::cerr.
+       * Call sync() before the destruction to get the write errors as exceptions.
+       */
+      ~array_stack_impl() {
+        try {
+          flush();
+        } catch (std::exception const &e) { report_lost_error(e.what()); }
+        if (async) {
+          {
+            std::lock_guard<std::mutex> lock(mut);
+            stop = true;
+          }
+          cv.notify_all();
+          writer.join(); // the writer writes the last buffer before stopping
+          if (writer_error) {
+            try {
+              std::rethrow_exception(writer_error);
+            } catch (std::exception const &e) { report_lost_error(e.what()); } catch (...) {
+              report_lost_error("unknown error");
+            }
+          }
+        }
+      }
 
 #ifdef TRIQS_DOXYGEN
       /// A view (for an array/matrix/vector base) or a reference (for a scalar base) to the top of the stack i.e. the next element to be assigned to
@@ -99,12 +150,38 @@ namespace triqs {
         if (step == bufsize_) flush();
       }
 
-      /// Flush the buffer to the disk. Automatically called at destruction.
+      /**
+       * Flush the buffer to the disk. Automatically called when the buffer is full, and at destruction.
+       * In async mode, the buffer is handed to the writer thread (after it has written the previous one) and the call returns.
+       */
       void flush() {
-        save_buffer();
+        if (step == 0) return;
+        if (!async) {
+          write_buffer(buffer, step);
+        } else {
+          std::unique_lock<std::mutex> lock(mut);
+          cv.wait(lock, [this] { return spare_step == 0; }); // at most one buffer is being written
+          rethrow_writer_error();
+          std::swap(buffer, spare);
+          spare_step = step;
+          lock.unlock();
+          cv.notify_all();
+        }
         step = 0;
       }
 
+      /// Flush the buffer and wait until all the data is written in the file. Rethrows the errors of the writer thread.
+      void sync() {
+        flush();
+        if (!async) return;
+        std::unique_lock<std::mutex> lock(mut);
+        cv.wait(lock, [this] { return spare_step == 0; });
+        rethrow_writer_error();
+      }
+
+      /// Are the writes done by a background thread. False if the HDF5 library is not thread-safe, even if async mode was requested.
+      bool is_async() const { return async; }
+
       /**
    * \brief Add a element onto the stack and advance it by one.
    * S << A is equivalent to S() = A; ++S;
@@ -118,24 +195,52 @@ namespace triqs {
       size_t size() const { return _size; }
 
       private:
-      void save_buffer() {
-        if (step == 0) return;
-        dims[0] += step;
-        buffer_dim[0] = step;
+      static void report_lost_error(const char *what) {
+        std::cerr << "TRIQS : array_stack : error while writing the data at destruction : " << what << std::endl;
+      }
+
+      void rethrow_writer_error() {
+        if (writer_error) std::rethrow_exception(std::exchange(writer_error, nullptr));
+      }
+
+      // The writer thread : writes spare when a buffer is handed over by flush
+      void writer_loop() {
+        std::unique_lock<std::mutex> lock(mut);
+        while (true) {
+          cv.wait(lock, [this] { return stop or spare_step != 0; });
+          if (spare_step == 0) return; // stop, and nothing left to write
+          lock.unlock();
+          try {
+            write_buffer(spare, spare_step);
+          } catch (...) {
+            lock.lock();
+            writer_error = std::current_exception();
+            lock.unlock();
+          }
+          lock.lock();
+          spare_step = 0;
+          cv.notify_all();
+        }
+      }
+
+      // Write the first n elements of buf at the end of the dataset
+      void write_buffer(array<T, dim + 1> &buf, size_t n) {
+        dims[0] += n;
+        buffer_dim[0] = n;
 
         herr_t err = H5Dset_extent(d_set, dims.ptr()); // resize the data_space
 
         h5::dataspace fspace1 = H5Dget_space(d_set);
-        h5::dataspace mspace  = h5_impl::data_space(buffer);
+        h5::dataspace mspace  = h5_impl::data_space(buf);
 
         err = H5Sselect_hyperslab(fspace1, H5S_SELECT_SET, offset.ptr(), NULL, buffer_dim.ptr(), NULL);
         if (err < 0) TRIQS_RUNTIME_ERROR << "Cannot set hyperslab";
         err = H5Sselect_hyperslab(mspace, H5S_SELECT_SET, zero.ptr(), NULL, buffer_dim.ptr(), NULL);
         if (err < 0) TRIQS_RUNTIME_ERROR << "Cannot set hyperslab";
 
-        err = H5Dwrite(d_set, h5::data_type_memory<T>(), mspace, fspace1, H5P_DEFAULT, h5_impl::__get_array_data_ptr(buffer));
+        err = H5Dwrite(d_set, h5::data_type_memory<T>(), mspace, fspace1, H5P_DEFAULT, h5_impl::__get_array_data_ptr(buf));
         if (err < 0) TRIQS_RUNTIME_ERROR << "Error writing the array_stack buffer";
-        offset[0] += step;
+        offset[0] += n;
       }
     };
 
@@ -151,9 +256,13 @@ namespace triqs {
    *  \param g The h5 group
    *  \param name The name of the hdf5 array in the file/group where the stack will be stored
    *  \param bufsize The size of the buffer
+   *  \param async If true, the full buffers are written by a background thread, while the next one is filled (cf flush, sync).
+   *               This requires a thread-safe HDF5 library : otherwise the writes are synchronous (cf is_async).
+   *               The write errors are rethrown by flush and sync : call sync before the destruction to get them.
    *  \exception The HDF5 exceptions will be caught and rethrown as TRIQS_RUNTIME_ERROR (with stackstrace, cf doc).
    */
-      array_stack(h5::group g, std::string const &name, size_t bufsize) : array_stack_impl<T, 0>{g, name, mini_vector<size_t, 0>{}, bufsize} {}
+      array_stack(h5::group g, std::string const &name, size_t bufsize, bool async = false)
+         : array_stack_impl<T, 0>{g, name, mini_vector<size_t, 0>{}, bufsize, async} {}
     };
 
     // Specialisation for The simple case, 1d
@@ -165,10 +274,13 @@ namespace triqs {
     *  \param name The name of the hdf5 array in the file/group where the stack will be stored
     *  \param base_element_shape The shape of the base array of the stack.
     *  \param bufsize The size of the buffer
+    *  \param async If true, the full buffers are written by a background thread, while the next one is filled (cf flush, sync).
+    *               This requires a thread-safe HDF5 library : otherwise the writes are synchronous (cf is_async).
+    *               The write errors are rethrown by flush and sync : call sync before the destruction to get them.
     *  \exception The HDF5 exceptions will be caught and rethrown as TRIQS_RUNTIME_ERROR (with stackstrace, cf doc).
     */
-      array_stack(h5::group g, std::string const &name, mini_vector<size_t, N> const &base_element_shape, size_t bufsize)
-         : array_stack_impl<T, N>{g, name, base_element_shape, bufsize} {}
+      array_stack(h5::group g, std::string const &name, mini_vector<size_t, N> const &base_element_shape, size_t bufsize, bool async = false)
+         : array_stack_impl<T, N>{g, name, base_element_shape, bufsize, async} {}
     };
   } // namespace arrays
 } // namespace triqs
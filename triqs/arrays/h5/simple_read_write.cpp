@@ -50,13 +50,10 @@ namespace triqs {
         bool is_complex       = triqs::is_complex<T>::value;
         h5::dataspace d_space = data_space_impl(info, is_complex);
 
-        h5::proplist cparms = H5Pcreate(H5P_DATASET_CREATE);
-        int n_dims          = info.R + (is_complex ? 1 : 0);
-        hsize_t chunk_dims[n_dims];
-        for (int i : range(info.R)) chunk_dims[i] = std::max(info.lengths[i], 1ul);
-        if (is_complex) chunk_dims[n_dims - 1] = 2;
-        H5Pset_chunk(cparms, n_dims, chunk_dims);
-        H5Pset_deflate(cparms, 8);
+        // compression and chunking according to the policy of the group
+        std::vector<hsize_t> dims(info.lengths, info.lengths + info.R);
+        if (is_complex) dims.push_back(2);
+        h5::proplist cparms = h5::dataset_create_proplist(g.get_write_policy(), dims, sizeof(T) / (is_complex ? 2 : 1));
 
         h5::dataset ds = g.create_dataset(name, h5::data_type_file<T>(), d_space, cparms);
 
@@ -74,6 +71,65 @@ namespace triqs {
       template void write_array_impl<double>(h5::group g, std::string const &name, const double *start, array_stride_info info);
       template void write_array_impl<dcomplex>(h5::group g, std::string const &name, const dcomplex *start, array_stride_info info);
 
+#ifdef H5_HAVE_PARALLEL
+      template <typename T>
+      void write_array_distributed_impl(h5::group g, std::string const &name, const T *start, array_stride_info info, mpi::communicator c) {
+        if (info.R == 0) TRIQS_RUNTIME_ERROR << "h5_write_distributed : the array must have at least one dimension";
+        bool is_complex = triqs::is_complex<T>::value;
+        int n_dims      = info.R + (is_complex ? 1 : 0);
+
+        // the global array : the parts of all processes along the first dimension
+        auto [counts, displs] = mpi::all_counts_and_displs(info.lengths[0], c);
+        hsize_t L[n_dims], offset[n_dims];
+        for (int u = 0; u < info.R; ++u) {
+          L[u]      = info.lengths[u];
+          offset[u] = 0;
+        }
+        L[0]      = displs[c.size()];
+        offset[0] = displs[c.rank()];
+        if (is_complex) {
+          L[n_dims - 1]      = 2;
+          offset[n_dims - 1] = 0;
+        }
+        h5::dataspace d_space = H5Screate_simple(n_dims, L, NULL);
+
+        // creating the dataset and its attributes is collective.
+        // Uncompressed : a contiguous dataset, without filters, in which each process writes its part directly.
+        // Compressed (needs hdf5 >= 1.10.2) : bounded chunks, never a single chunk for the whole array.
+        auto policy = g.get_write_policy();
+        if (policy.deflate_level == 0)
+          policy = h5::write_policy::no_compression();
+        else if (policy.chunk_bytes == 0)
+          policy.chunk_bytes = h5::write_policy::compressed().chunk_bytes;
+        h5::proplist cparms = h5::dataset_create_proplist(policy, std::vector<hsize_t>(L, L + n_dims), sizeof(T) / (is_complex ? 2 : 1));
+        h5::dataset ds      = g.create_dataset(name, h5::data_type_file<T>(), d_space, cparms);
+        if (is_complex) h5_write_attribute(ds, "__complex__", "1");
+
+        // each process selects its part (possibly empty), then all write collectively
+        h5::dataspace m_space = data_space_impl(info, is_complex);
+        hsize_t count[n_dims];
+        for (int u = 0; u < n_dims; ++u) count[u] = (u < info.R ? info.lengths[u] : 2);
+        if (info.lengths[0] > 0)
+          H5Sselect_hyperslab(d_space, H5S_SELECT_SET, offset, NULL, count, NULL);
+        else {
+          H5Sselect_none(d_space);
+          H5Sselect_none(m_space);
+        }
+        h5::proplist dxpl = H5Pcreate(H5P_DATASET_XFER);
+        H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+        auto err = H5Dwrite(ds, h5::data_type_memory<T>(), m_space, d_space, dxpl, h5::get_data_ptr(start));
+        if (err < 0) TRIQS_RUNTIME_ERROR << "Error writing the distributed dataset " << name << " in the group" << g.name();
+      }
+
+      template void write_array_distributed_impl<int>(h5::group g, std::string const &name, const int *start, array_stride_info info, mpi::communicator c);
+      template void write_array_distributed_impl<long>(h5::group g, std::string const &name, const long *start, array_stride_info info,
+                                                       mpi::communicator c);
+      template void write_array_distributed_impl<double>(h5::group g, std::string const &name, const double *start, array_stride_info info,
+                                                         mpi::communicator c);
+      template void write_array_distributed_impl<dcomplex>(h5::group g, std::string const &name, const dcomplex *start, array_stride_info info,
+                                                           mpi::communicator c);
+#endif
+
       // overload : special treatment for arrays of strings (one dimension only).
       void write_array(h5::group g, std::string const &name, vector_const_view<std::string> V) {
         std::vector<std::string> tmp(V.size());
@@ -121,6 +177,55 @@ namespace triqs {
       template void read_array_impl<double>(h5::group g, std::string const &name, double *start, array_stride_info info);
       template void read_array_impl<dcomplex>(h5::group g, std::string const &name, dcomplex *start, array_stride_info info);
 
+      /// --------------------------- READ a slice ---------------------------------------------
+
+      std::vector<range> resolve_slice(std::vector<size_t> const &dims, std::vector<range> slice) {
+        int R = dims.size();
+        if (int(slice.size()) > R) TRIQS_RUNTIME_ERROR << "h5_read_slice : " << slice.size() << " ranges for an array of rank " << R;
+        slice.resize(R);
+        for (int u = 0; u < R; ++u) {
+          long first = slice[u].first(), last = (slice[u].last() == -1 ? dims[u] : slice[u].last()), step = slice[u].step();
+          if (first < 0 or last > long(dims[u]) or first > last or step <= 0)
+            TRIQS_RUNTIME_ERROR << "h5_read_slice : " << slice[u] << " out of the dimension " << u << " of length " << dims[u];
+          slice[u] = range(first, last, step);
+        }
+        return slice;
+      }
+
+      template <typename T>
+      void read_array_slice_impl(h5::group g, std::string const &name, T *start, array_stride_info info, std::vector<range> const &slice) {
+        bool is_complex       = triqs::is_complex<T>::value;
+        h5::dataset ds        = g.open_dataset(name);
+        h5::dataspace f_space = H5Dget_space(ds);
+        h5::dataspace m_space = data_space_impl(info, is_complex);
+        if (H5Sget_simple_extent_npoints(m_space) == 0) return;
+
+        int n_dims = info.R + (is_complex ? 1 : 0);
+        hsize_t offset[n_dims], stride[n_dims], count[n_dims];
+        for (int u = 0; u < info.R; ++u) {
+          offset[u] = slice[u].first();
+          stride[u] = slice[u].step();
+          count[u]  = info.lengths[u];
+        }
+        if (is_complex) {
+          offset[n_dims - 1] = 0;
+          stride[n_dims - 1] = 1;
+          count[n_dims - 1]  = 2;
+        }
+        herr_t err = H5Sselect_hyperslab(f_space, H5S_SELECT_SET, offset, stride, count, NULL);
+        if (err < 0) TRIQS_RUNTIME_ERROR << "Cannot set hyperslab";
+
+        err = H5Dread(ds, h5::data_type_memory<T>(), m_space, f_space, H5P_DEFAULT, h5::get_data_ptr(start));
+        if (err < 0) TRIQS_RUNTIME_ERROR << "Error reading a slice of the dataset " << name << " in the group" << g.name();
+      }
+
+      template void read_array_slice_impl<int>(h5::group g, std::string const &name, int *start, array_stride_info info, std::vector<range> const &slice);
+      template void read_array_slice_impl<long>(h5::group g, std::string const &name, long *start, array_stride_info info, std::vector<range> const &slice);
+      template void read_array_slice_impl<double>(h5::group g, std::string const &name, double *start, array_stride_info info,
+                                                  std::vector<range> const &slice);
+      template void read_array_slice_impl<dcomplex>(h5::group g, std::string const &name, dcomplex *start, array_stride_info info,
+                                                    std::vector<range> const &slice);
+
       void read_array(h5::group g, std::string const &name, arrays::vector<std::string> &V) {
         std::vector<std::string> tmp;
         h5_read(g, name, tmp);
@@ -22,6 +22,9 @@
 #include <triqs/arrays/array.hpp>
 #include <triqs/arrays/vector.hpp>
 #include <triqs/h5.hpp>
+#ifdef H5_HAVE_PARALLEL
+#include <triqs/mpi/chunked.hpp>
+#endif
 #include "../cache.hpp"
 
 namespace triqs {
@@ -63,6 +66,11 @@ namespace triqs {
           write_array_impl(g, name, a.data_start(), array_stride_info{a});
       }
 
+#ifdef H5_HAVE_PARALLEL
+      template <typename T>
+      void write_array_distributed_impl(h5::group g, std::string const &name, const T *start, array_stride_info info, mpi::communicator c);
+#endif
+
       // overload : special treatment for arrays of strings (one dimension only).
       void write_array(h5::group g, std::string const &name, vector_const_view<std::string> V);
       void write_array(h5::group g, std::string const &name, array_const_view<std::string, 1> V);
@@ -102,6 +110,30 @@ namespace triqs {
       void read_array(h5::group g, std::string const &name, arrays::vector<std::string> &V);
       void read_array(h5::group f, std::string const &name, arrays::array<std::string, 1> &V);
 
+      /*********************************** READ a slice of an array ***************************************************/
+
+      // The ranges of slice, completed with range() up to R dimensions, with the bounds of the dataset of dimensions dims.
+      std::vector<range> resolve_slice(std::vector<size_t> const &dims, std::vector<range> slice);
+      template <typename T> void read_array_slice_impl(h5::group g, std::string const &name, T *start, array_stride_info info, std::vector<range> const &slice);
+
+      template <typename A> void read_array_slice(h5::group g, std::string const &name, A &a, std::vector<range> const &slice) {
+        constexpr bool is_complex = triqs::is_complex<typename A::value_type>::value;
+
+        if (is_complex && !is_dataset_complex(g, name)) { // if not complex in file, we load in real and assign
+          array<double, A::rank> tmp;
+          read_array_slice(g, name, tmp, slice);
+          a = tmp;
+          return;
+        }
+
+        auto sl = resolve_slice(get_array_lengths(a.rank, g, name, is_complex), slice);
+        mini_vector<size_t, A::rank> lengths;
+        for (int u = 0; u < A::rank; ++u) lengths[u] = (sl[u].last() - sl[u].first() + sl[u].step() - 1) / sl[u].step();
+        resize_or_check(a, lengths);
+        auto b = make_cache(a);
+        read_array_slice_impl(g, name, b.view().data_start(), array_stride_info{b.view()}, sl);
+      }
+
     } // namespace h5_impl
 
     // a trait to detect if A::value_type exists and is a scalar or a string
@@ -125,6 +157,18 @@ namespace triqs {
       h5_impl::read_array(g, name, A);
     }
 
+    /**
+     * Read a part of the array stored in g[name] : the elements in the ranges of slice (one range per dimension,
+     * completed with range() for the last dimensions), e.g. {range(10, 20), range(0, 100, 2)}.
+     * Only this part is read from the file (with a hyperslab selection). A is resized to the shape of the slice
+     * (or checked, for a view).
+     */
+    template <typename ArrayType>
+    std14::enable_if_t<is_amv_value_or_view_class<std::decay_t<ArrayType>>::value && is_scalar<typename std::decay_t<ArrayType>::value_type>::value>
+    h5_read_slice(h5::group g, std::string const &name, ArrayType &&A, std::vector<range> const &slice) {
+      h5_impl::read_array_slice(g, name, A, slice);
+    }
+
     /*
   * Write an array or a view into an hdf5 file
   * ArrayType The type of the array/matrix/vector, etc..
@@ -139,5 +183,22 @@ namespace triqs {
       h5_impl::write_array(g, name, array_const_view<typename ArrayType::value_type, ArrayType::rank>(A));
     }
 
+#ifdef H5_HAVE_PARALLEL
+    /**
+     * Write an array distributed over the processes of c into a file opened with MPI-IO (cf h5::file), collectively.
+     * A is the part of the array on this process : the array in the file is the concatenation of the A of all processes,
+     * in the order of the ranks, along the first dimension (as gathered by mpi_gather). The other dimensions must be the same.
+     * Each process writes its own part. Only with a parallel HDF5 library.
+     * The dataset is contiguous if the write policy of g has no compression, and else chunked in chunks of
+     * write_policy::chunk_bytes (1 MB if it is 0).
+     */
+    template <typename ArrayType>
+    std14::enable_if_t<is_amv_value_or_view_class<ArrayType>::value && is_scalar<typename ArrayType::value_type>::value>
+    h5_write_distributed(h5::group g, std::string const &name, ArrayType const &A, mpi::communicator c) {
+      auto b = make_const_cache(A).view();
+      h5_impl::write_array_distributed_impl(g, name, b.data_start(), h5_impl::array_stride_info{b}, c);
+    }
+#endif
+
   } // namespace arrays
 } // namespace triqs
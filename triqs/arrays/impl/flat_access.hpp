@@ -0,0 +1,103 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+// Assignments of at least this number of elements are split among the OpenMP threads (when the flat loop is possible).
+// Not defined by default : assignments are sequential.
+// #define TRIQS_ARRAYS_PARALLEL_ASSIGNMENT_THRESHOLD 100000
+
+namespace triqs {
+  namespace arrays {
+
+    namespace Tag {
+      struct indexmap_storage_pair;
+    }
+
+    /**
+  * Flat evaluation of an expression.
+  *
+  * If the lhs of an assignment and all the arrays in the rhs expression are compact in memory, with the same lengths
+  * and memory layout, the element at position i in the memory of the lhs is computed from the elements at position i
+  * in the memory of the arrays : the assignment is then a simple loop, that the compiler can vectorize.
+  *
+  * flat_access<X>::value is true iif X can be evaluated this way. Then
+  *   - compatible(x, lhs) checks at runtime that x can be evaluated at the memory positions of lhs,
+  *   - get(x, i) is the value of x at memory position i.
+  * It is specialized for the arrays, the expressions and the scalars in the expressions.
+  */
+    template <typename X, typename Enable = void> struct flat_access { static constexpr bool value = false; };
+
+    /// Is the data of the indexmap a contiguous block, without holes, in the order of its memory layout
+    template <typename IM> bool is_compact(IM const &im) {
+      auto const &ml = im.memory_layout();
+      std::ptrdiff_t s = 1;
+      for (int u = IM::rank - 1; u >= 0; --u) {
+        int k = ml[u];
+        if (im.lengths()[k] > 1 and im.strides()[k] != s) return false;
+        s *= im.lengths()[k];
+      }
+      return true;
+    }
+
+    // arrays, matrices, vectors and their views
+    template <typename X> struct flat_access<X, std::enable_if_t<std::is_base_of<Tag::indexmap_storage_pair, X>::value>> {
+      static constexpr bool value = true;
+
+      template <typename LHS> static bool compatible(X const &x, LHS const &lhs) {
+        if (x.indexmap().lengths() != lhs.indexmap().lengths() or x.indexmap().memory_layout() != lhs.indexmap().memory_layout()
+            or !is_compact(x.indexmap()))
+          return false;
+        // x may be lhs itself, but must not overlap with it partially (e.g. A(range(1,n)) = A(range(0,n-1)) + 1)
+        long n  = lhs.domain().number_of_elements();
+        auto px = reinterpret_cast<std::uintptr_t>(x.data_start()), pl = reinterpret_cast<std::uintptr_t>(lhs.data_start());
+        auto sx = n * sizeof(typename X::value_type), sl = n * sizeof(typename LHS::value_type);
+        return (px == pl and sx == sl) or (px + sx <= pl) or (pl + sl <= px);
+      }
+
+      static decltype(auto) get(X const &x, long i) { return x.data_start()[i]; }
+    };
+
+    namespace assignment {
+
+      // lhs[i] OP= f(i) for all the memory positions i of lhs, which must be compact.
+      template <typename Ops, typename LHS, typename F> void flat_loop(LHS &lhs, F const &f) {
+        auto *p = lhs.data_start();
+        long n  = lhs.domain().number_of_elements();
+#if defined(_OPENMP) && defined(TRIQS_ARRAYS_PARALLEL_ASSIGNMENT_THRESHOLD)
+#pragma omp parallel for if (n >= TRIQS_ARRAYS_PARALLEL_ASSIGNMENT_THRESHOLD)
+#endif
+        for (long i = 0; i < n; ++i) Ops::invoke(p[i], f(i));
+      }
+
+      // lhs OP= rhs with a flat loop, if possible. Returns false otherwise.
+      template <typename Ops, typename LHS, typename RHS> bool flat_assign(LHS &lhs, RHS const &rhs) {
+        if constexpr (flat_access<RHS>::value) {
+          if (!is_compact(lhs.indexmap()) or !flat_access<RHS>::compatible(rhs, lhs)) return false;
+          flat_loop<Ops>(lhs, [&rhs](long i) { return flat_access<RHS>::get(rhs, i); });
+          return true;
+        } else
+          return false;
+      }
+    } // namespace assignment
+  }   // namespace arrays
+} // namespace triqs
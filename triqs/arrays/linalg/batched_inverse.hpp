@@ -0,0 +1,107 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <exception>
+#include "../array.hpp"
+#include "../matrix.hpp"
+#include "../blas_lapack/getrf.hpp"
+#include "../blas_lapack/getri.hpp"
+#include "./small_matrix.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace triqs::arrays {
+
+  namespace detail {
+
+    // A batch is split among the OpenMP threads if it has at least this number of elements (~ n_batch * n^2)
+    constexpr long parallel_batched_inverse_threshold = 1 << 14;
+
+    // Invert the matrices a(i, _, _) for i in [first, last)
+    template <typename T> void inverse_in_place_batch(array_view<T, 3> a, long first, long last) {
+      long n = a.shape()[1];
+      if (first >= last) return;
+
+      if (small_matrix::applicable<T>(n)) {
+        auto const &s = a.indexmap().strides();
+        small_matrix::dispatch(n, [&](auto N) {
+          for (long i = first; i < last; ++i) small_matrix::kernels::inverse_in_place<N.value, T>({a.data_start() + i * s[0], s[1], s[2]});
+        });
+        return;
+      }
+
+      // lapack, with the pivots and the workspace shared by all the matrices of the batch
+      vector<int> ipiv(n);
+      vector<T> work;
+      for (long i = first; i < last; ++i) {
+        matrix_view<T> m = make_matrix_view(a(i, range(), range()));
+        // inverse of the transpose is the transpose of the inverse : work in Fortran order, without copy
+        matrix_view<T> W = (m.indexmap().memory_layout_is_c() ? m.transpose() : m);
+        if (lapack::getrf(W, ipiv) < 0) throw matrix_inverse_exception() << "Inverse/Det error : failure of getrf lapack routine ";
+        if (lapack::getri(W, ipiv, work) != 0) throw matrix_inverse_exception() << "Inverse/Det error : matrix is not invertible";
+      }
+    }
+  } // namespace detail
+
+  /**
+   * Inverts in place the n x n matrices a(i, _, _) for all i
+   *
+   * Same as a(i, _, _) = inverse(a(i, _, _)) for all i, but
+   *   - small matrices (n <= small_matrix::max_dim) are inverted by the fixed-size kernels, dispatched once for the batch,
+   *   - larger ones by lapack, with the pivots and the workspace allocated once for the batch,
+   *   - a large batch is split among the OpenMP threads (if any, and if not already in a parallel region).
+   *
+   * @param a A rank 3 array or array_view of double or complex
+   * @throws matrix_inverse_exception if a matrix is not invertible
+   */
+  template <typename A> void inverse_in_place_batched(A &&a) {
+    using A_t = std::decay_t<A>;
+    using T   = typename A_t::value_type;
+    static_assert(is_amv_value_or_view_class<A_t>::value and A_t::rank == 3, "inverse_in_place_batched takes a rank 3 array or array_view");
+    static_assert(is_blas_lapack_type<T>::value, "inverse_in_place_batched : only for double and complex");
+
+    array_view<T, 3> v = a;
+    long n_batch = v.shape()[0], n = v.shape()[1];
+    if (n != v.shape()[2]) TRIQS_RUNTIME_ERROR << "inverse_in_place_batched : matrices are not square but of size " << n << " x " << v.shape()[2];
+
+#ifdef _OPENMP
+    if (n_batch > 1 and n_batch * n * n >= detail::parallel_batched_inverse_threshold and omp_get_max_threads() > 1 and !omp_in_parallel()) {
+      // exceptions can not leave the parallel region : the first one is rethrown
+      std::exception_ptr error;
+#pragma omp parallel
+      {
+        long n_threads = omp_get_num_threads(), t = omp_get_thread_num();
+        try {
+          detail::inverse_in_place_batch(v, (n_batch * t) / n_threads, (n_batch * (t + 1)) / n_threads);
+        } catch (...) {
+#pragma omp critical
+          if (!error) error = std::current_exception();
+        }
+      }
+      if (error) std::rethrow_exception(error);
+      return;
+    }
+#endif
+    detail::inverse_in_place_batch(v, 0, n_batch);
+  }
+
+} // namespace triqs::arrays
@@ -24,13 +24,11 @@
 #include "../matrix.hpp"
 #include "../blas_lapack/getrf.hpp"
 #include "../blas_lapack/getri.hpp"
+#include "./small_matrix.hpp"
 
 namespace triqs {
   namespace arrays {
 
-    /// Error which occurs during the matrix inversion
-    class matrix_inverse_exception : public triqs::runtime_error {};
-
     /**
   * Lazy result of inverse(M) where M can be :
   *  * a matrix, a matrix_view
@@ -55,23 +53,29 @@ namespace triqs {
     // worker takes a contiguous view and compute the det and inverse in two steps.
     // it is separated in case of multiple use (no reallocation of ipvi, etc...)
     // A can be a matrix, a matrix_view
+    // Small matrices (dim <= small_matrix::max_dim) are done by the fixed-size kernels, without lapack (and ipiv).
     template <typename A> class det_and_inverse_worker {
       typedef typename A::value_type value_type;
       typedef matrix_view<value_type> V_type;
       A a;
       int dim;
-      triqs::arrays::vector<int> ipiv;
+      triqs::arrays::vector<int> ipiv; // resized by getrf
       int step, info;
       value_type _det;
+      bool small;
 
       public:
-      det_and_inverse_worker(A a_) : a(std::move(a_)), dim(first_dim(a)), ipiv(dim), step(0) {
+      det_and_inverse_worker(A a_) : a(std::move(a_)), dim(first_dim(a)), step(0), small(small_matrix::applicable<value_type>(dim)) {
         if (first_dim(a) != second_dim(a))
           TRIQS_RUNTIME_ERROR << "Inverse/Det error:non-square matrix. Dimensions are :(" << first_dim(a) << "," << second_dim(a) << ")\n  ";
         if (!(has_contiguous_data(a))) TRIQS_RUNTIME_ERROR << "det_and_inverse_worker only takes a contiguous view";
       }
 
       value_type det() {
+        if (small) {
+          if (step < 2) _det = small_matrix::determinant(a);
+          return _det;
+        }
         V_type W = fortran_view(a);
         _step1(W);
         _compute_det(W);
@@ -80,6 +84,11 @@ namespace triqs {
 
       A const &inverse() {
         if (step < 2) {
+          if (small) {
+            _det = small_matrix::inverse_in_place(a);
+            step = 2;
+            return a;
+          }
           V_type W = fortran_view(a);
           _step1(W);
           _step2(W);
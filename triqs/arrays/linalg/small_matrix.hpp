@@ -0,0 +1,205 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <complex>
+#include <cmath>
+#include <type_traits>
+#include "../impl/common.hpp"
+#include "../matrix.hpp"
+#include "../blas_lapack/tools.hpp"
+
+// Largest dimension of the square matrices handled by the fixed-size kernels.
+// Define it to 0 to always use blas/lapack.
+#ifndef TRIQS_ARRAYS_SMALL_MATRIX_MAX_DIM
+#define TRIQS_ARRAYS_SMALL_MATRIX_MAX_DIM 8
+#endif
+
+namespace triqs::arrays {
+
+  /// Error which occurs during the matrix inversion
+  class matrix_inverse_exception : public triqs::runtime_error {};
+} // namespace triqs::arrays
+
+/**
+ * Fixed-size kernels for the product, inverse and determinant of small square matrices.
+ *
+ * For N x N matrices with N <= max_dim, the call overhead of blas/lapack dominates.
+ * These kernels are templated on N (dispatched at runtime on the dimension), so that the compiler
+ * fully unrolls and vectorizes the loops. The matrix is loaded into a local array, which also makes
+ * them safe when the output aliases the input.
+ * They are used automatically by matrix * matrix, inverse and determinant.
+ */
+namespace triqs::arrays::small_matrix {
+
+  constexpr int max_dim = TRIQS_ARRAYS_SMALL_MATRIX_MAX_DIM;
+
+  /// Are the kernels used for a n x n matrix of T ?
+  template <typename T> bool applicable(long n) { return is_blas_lapack_type<T>::value and (n >= 1) and (n <= max_dim); }
+
+  // A matrix in memory : pointer and strides
+  template <typename T> struct strided {
+    T *p;
+    long s0, s1;
+    T &operator()(int i, int j) const { return p[i * s0 + j * s1]; }
+  };
+
+  template <typename T, typename M> strided<T> make_strided(M &&m) {
+    return {m.data_start(), long(m.indexmap().strides()[0]), long(m.indexmap().strides()[1])};
+  }
+
+  // ---------------  scalar helpers  ------------------------
+
+  // std::complex operator * and / check for inf/nan (e.g. __muldc3 in gcc), like blas/lapack we do not
+  inline double mul(double a, double b) { return a * b; }
+  inline std::complex<double> mul(std::complex<double> a, std::complex<double> b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+  }
+
+  inline double inv(double a) { return 1 / a; }
+  inline std::complex<double> inv(std::complex<double> a) {
+    double n = a.real() * a.real() + a.imag() * a.imag();
+    return {a.real() / n, -a.imag() / n};
+  }
+
+  // modulus used for pivoting, as in lapack (|re| + |im| for complex)
+  inline double abs1(double a) { return std::abs(a); }
+  inline double abs1(std::complex<double> a) { return std::abs(a.real()) + std::abs(a.imag()); }
+
+  // ---------------  kernels  ------------------------
+
+  namespace kernels {
+
+    // C = A * B
+    template <int N, typename T> void gemm(strided<T const> A, strided<T const> B, strided<T> C) {
+      T a[N][N], b[N][N], c[N][N];
+      for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j) {
+          a[i][j] = A(i, j);
+          b[i][j] = B(i, j);
+          c[i][j] = 0;
+        }
+      for (int i = 0; i < N; ++i)
+        for (int k = 0; k < N; ++k)
+          for (int j = 0; j < N; ++j) c[i][j] += mul(a[i][k], b[k][j]);
+      for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j) C(i, j) = c[i][j];
+    }
+
+    // A = A^{-1} by Gauss-Jordan elimination with partial pivoting. Returns det(A).
+    template <int N, typename T> T inverse_in_place(strided<T> A) {
+      T m[N][2 * N]; // [A | 1]
+      for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j) {
+          m[i][j]     = A(i, j);
+          m[i][N + j] = (i == j ? 1 : 0);
+        }
+      T det = 1;
+      for (int k = 0; k < N; ++k) {
+        int p = k;
+        for (int i = k + 1; i < N; ++i)
+          if (abs1(m[i][k]) > abs1(m[p][k])) p = i;
+        if (abs1(m[p][k]) == 0) throw matrix_inverse_exception() << "Inverse/Det error : matrix is not invertible";
+        if (p != k) {
+          for (int j = 0; j < 2 * N; ++j) std::swap(m[p][j], m[k][j]);
+          det = -det;
+        }
+        det         = mul(det, m[k][k]);
+        T inv_pivot = inv(m[k][k]);
+        for (int j = 0; j < 2 * N; ++j) m[k][j] = mul(m[k][j], inv_pivot);
+        for (int i = 0; i < N; ++i) {
+          if (i == k) continue;
+          T f = m[i][k];
+          for (int j = 0; j < 2 * N; ++j) m[i][j] -= mul(f, m[k][j]);
+        }
+      }
+      for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j) A(i, j) = m[i][N + j];
+      return det;
+    }
+
+    // det(A) by LU decomposition with partial pivoting
+    template <int N, typename T> T determinant(strided<T const> A) {
+      T m[N][N];
+      for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j) m[i][j] = A(i, j);
+      T det = 1;
+      for (int k = 0; k < N; ++k) {
+        int p = k;
+        for (int i = k + 1; i < N; ++i)
+          if (abs1(m[i][k]) > abs1(m[p][k])) p = i;
+        if (abs1(m[p][k]) == 0) return 0;
+        if (p != k) {
+          for (int j = k; j < N; ++j) std::swap(m[p][j], m[k][j]);
+          det = -det;
+        }
+        det         = mul(det, m[k][k]);
+        T inv_pivot = inv(m[k][k]);
+        for (int i = k + 1; i < N; ++i) {
+          T f = mul(m[i][k], inv_pivot);
+          for (int j = k + 1; j < N; ++j) m[i][j] -= mul(f, m[k][j]);
+        }
+      }
+      return det;
+    }
+  } // namespace kernels
+
+  // Call f(std::integral_constant<int, n>) for the runtime n in [1, max_dim]
+  template <int N = 1, typename F> decltype(auto) dispatch(int n, F &&f) {
+    if constexpr (N >= max_dim)
+      return f(std::integral_constant<int, N>{});
+    else {
+      if (n == N) return f(std::integral_constant<int, N>{});
+      return dispatch<N + 1>(n, std::forward<F>(f));
+    }
+  }
+
+  // ---------------  matrix interface  ------------------------
+
+  /**
+   * c = a * b if a, b, c are n x n matrices or matrix_views of the same blas type and n <= max_dim.
+   * Returns false (and does nothing) if the kernels are not applicable.
+   */
+  template <typename MA, typename MB, typename MC> bool gemm(MA const &a, MB const &b, MC &c) {
+    using T = std::remove_const_t<typename MC::value_type>;
+    if constexpr (is_amv_value_or_view_class<MA>::value and is_amv_value_or_view_class<MB>::value and is_amv_value_or_view_class<MC>::value
+                  and have_same_value_type<MA, MB, MC>::value) {
+      long n = first_dim(a);
+      if (!applicable<T>(n) or second_dim(a) != n or first_dim(b) != n or second_dim(b) != n or first_dim(c) != n or second_dim(c) != n)
+        return false;
+      dispatch(n, [&](auto N) { kernels::gemm<N.value, T>(make_strided<T const>(a), make_strided<T const>(b), make_strided<T>(c)); });
+      return true;
+    } else
+      return false;
+  }
+
+  /// Inverse in place of a n x n matrix or matrix_view with n <= max_dim. Returns the determinant of a.
+  template <typename M> auto inverse_in_place(M &a) {
+    using T = std::remove_const_t<typename M::value_type>;
+    return dispatch(first_dim(a), [&](auto N) { return kernels::inverse_in_place<N.value, T>(make_strided<T>(a)); });
+  }
+
+  /// Determinant of a n x n matrix or matrix_view with n <= max_dim.
+  template <typename M> auto determinant(M const &a) {
+    using T = std::remove_const_t<typename M::value_type>;
+    return dispatch(first_dim(a), [&](auto N) { return kernels::determinant<N.value, T>(make_strided<T const>(a)); });
+  }
+
+} // namespace triqs::arrays::small_matrix
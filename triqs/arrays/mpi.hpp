@@ -20,6 +20,10 @@
  ******************************************************************************/
 #pragma once
 #include "../mpi/base.hpp"
+#include "../mpi/chunked.hpp"
+#include "../mpi/hierarchical.hpp"
+#include "../mpi/request.hpp"
+#include "./storages/node_shared_block.hpp"
 
 namespace triqs {
   namespace arrays {
@@ -73,7 +77,7 @@ namespace triqs {
       MPI_Bcast(&sh[0], sh.size(), mpi::mpi_datatype<typename decltype(sh)::value_type>(), root, c.get());
       MPI_Bcast(&m_pos[0], m_pos.size(), mpi::mpi_datatype<typename decltype(m_pos)::value_type>(), root, c.get());
       if (c.rank() != root) { resize_or_check_if_view(a, sh, memory_layout_t<A::rank>(m_pos)); }
-      MPI_Bcast(a.data_start(), a.domain().number_of_elements(), mpi::mpi_datatype<typename A::value_type>(), root, c.get());
+      mpi::broadcast_n(a.data_start(), a.domain().number_of_elements(), c, root);
     }
 
     template <typename A> REQUIRES_IS_ARRAY2(reduce) mpi_reduce(A &a, mpi::communicator c = {}, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
@@ -81,6 +85,28 @@ namespace triqs {
       return {a, c, root, all, op};
     }
 
+    /**
+     * Non-blocking reduction of a, in place : the result is in a on root (or on all nodes if all) when the request is completed.
+     * a must not be used (nor destroyed) until then.
+     */
+    template <typename A>
+    std14::enable_if_t<is_amv_value_or_view_class<std::decay_t<A>>::value, mpi::request> mpi_ireduce(A &&a, mpi::communicator c = {}, int root = 0,
+                                                                                                       bool all = false, MPI_Op op = MPI_SUM) {
+      if (!has_contiguous_data(a)) TRIQS_RUNTIME_ERROR << "Non contiguous view in mpi_ireduce";
+      return mpi::ireduce_n(a.data_start(), a.data_start(), a.domain().number_of_elements(), c, root, all, op);
+    }
+
+    /**
+     * Reduction of a in place, first within each node then between the nodes (cf mpi::hierarchical_reduce_n).
+     * The result is in a on root (a rank in t.comm()), or on all processes if all. a is overwritten on the other processes.
+     */
+    template <typename A>
+    std14::enable_if_t<is_amv_value_or_view_class<std::decay_t<A>>::value> mpi_hierarchical_reduce(A &&a, mpi::node_topology const &t, int root = 0,
+                                                                                                 bool all = false, MPI_Op op = MPI_SUM) {
+      if (!has_contiguous_data(a)) TRIQS_RUNTIME_ERROR << "Non contiguous view in mpi_hierarchical_reduce";
+      mpi::hierarchical_reduce_n(a.data_start(), a.domain().number_of_elements(), t, root, all, op);
+    }
+
     template <typename A> REQUIRES_IS_ARRAY2(scatter) mpi_scatter(A &a, mpi::communicator c = {}, int root = 0, bool all = false) {
       if (!has_contiguous_data(a)) TRIQS_RUNTIME_ERROR << "Non contiguous view in mpi_scatter";
       return {a, c, root, all, nullptr};
@@ -91,6 +117,60 @@ namespace triqs {
       return {a, c, root, all, nullptr};
     }
 
+    // The data of an array, for the packed mpi reductions (cf triqs/mpi/packed.hpp)
+    template <typename A> std14::enable_if_t<is_amv_value_or_view_class<std::decay_t<A>>::value, A &> mpi_pack_data(A &a) { return a; }
+
+    //--------------------------------------------------------------------------------------------------------
+    // Arrays shared by the processes of a node
+
+    /**
+     * An array of the given shape, allocated once per node and shared by all its processes
+     *
+     * Collective on node_comm, the processes of a node, e.g. world.split_shared(). Cf storages::make_node_shared_block.
+     * All the processes get a view on the same memory. The array is typically filled once with mpi_broadcast_node_shared,
+     * then only read.
+     */
+    template <typename T, int R> array_view<T, R> make_node_shared_array(mini_vector<size_t, R> const &shape, mpi::communicator node_comm) {
+      using indexmap_t = typename array_view<T, R>::indexmap_type;
+      indexmap_t im{typename indexmap_t::domain_type{shape}};
+      return {im, storages::make_node_shared_block<T>(im.domain().number_of_elements(), node_comm)};
+    }
+
+    /**
+     * Broadcast the array a from root to all the nodes, a being made by make_node_shared_array on node_comm
+     *
+     * The data is sent once per node, to its first process, which writes it in the shared memory.
+     * Collective on c. node_comm splits c in groups of processes of the same node, e.g. c.split_shared(),
+     * and is the one given to make_node_shared_array.
+     * The writes in the shared memory (by root before the call, and by the node leaders) are synchronized
+     * with MPI_Win_sync in a passive target epoch, and are visible on all processes on return.
+     */
+    template <typename A> REQUIRES_IS_ARRAY mpi_broadcast_node_shared(A &a, mpi::communicator c, mpi::communicator node_comm, int root = 0) {
+      if (!has_contiguous_data(a)) TRIQS_RUNTIME_ERROR << "Non contiguous view in mpi_broadcast_node_shared";
+      if (a.domain().number_of_elements() == 0) return;
+      MPI_Win win = storages::node_shared_window(a.storage());
+      if (win == MPI_WIN_NULL) TRIQS_RUNTIME_ERROR << "mpi_broadcast_node_shared : the array is not made by make_node_shared_array";
+      bool leader      = (node_comm.rank() == 0);
+      auto leaders     = c.split(leader ? 0 : MPI_UNDEFINED, c.rank());
+      int root_on_node = mpi::mpi_reduce(int(c.rank() == root), node_comm, 0, true);
+
+      // a writer syncs its memory with the window then enters the barrier, a reader syncs after the barrier
+      MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+      auto sync_node = [&]() {
+        MPI_Win_sync(win);
+        node_comm.barrier();
+        MPI_Win_sync(win);
+      };
+      sync_node(); // root has written a
+      if (leader) {
+        int leader_root = mpi::mpi_reduce(root_on_node ? leaders.rank() : 0, leaders, 0, true);
+        mpi::broadcast_n(a.data_start(), a.domain().number_of_elements(), leaders, leader_root);
+        leaders.free();
+      }
+      sync_node(); // the data is in the shared memory
+      MPI_Win_unlock_all(win);
+    }
+
 #undef REQUIRES_IS_ARRAY
 #undef REQUIRES_IS_ARRAY2
 
@@ -116,10 +196,9 @@ namespace triqs {
 
           if (!has_contiguous_data(lhs)) TRIQS_RUNTIME_ERROR << "mpi reduction of array into a non contiguous view";
 
-          auto rhs_n_elem = laz.ref.domain().number_of_elements();
+          long rhs_n_elem = laz.ref.domain().number_of_elements();
           auto c          = laz.c;
           auto root       = laz.root;
-          auto D          = mpi::mpi_datatype<typename A::value_type>();
 
           bool in_place = (lhs.data_start() == laz.ref.data_start());
 
@@ -132,20 +211,7 @@ namespace triqs {
             if (std::abs(lhs.data_start() - laz.ref.data_start()) < rhs_n_elem) TRIQS_RUNTIME_ERROR << "mpi reduce of array : overlapping arrays !";
           }
 
-          void *lhs_p = lhs.data_start();
-          void *rhs_p = (void *)laz.ref.data_start();
-
-          if (!laz.all) {
-            if (in_place)
-              MPI_Reduce((c.rank() == root ? MPI_IN_PLACE : rhs_p), rhs_p, rhs_n_elem, D, laz.op, root, c.get());
-            else
-              MPI_Reduce(rhs_p, lhs_p, rhs_n_elem, D, laz.op, root, c.get());
-          } else {
-            if (in_place)
-              MPI_Allreduce(MPI_IN_PLACE, rhs_p, rhs_n_elem, D, laz.op, c.get());
-            else
-              MPI_Allreduce(rhs_p, lhs_p, rhs_n_elem, D, laz.op, c.get());
-          }
+          mpi::reduce_n(laz.ref.data_start(), lhs.data_start(), rhs_n_elem, c, root, laz.all, laz.op);
         }
       };
 
@@ -166,19 +232,17 @@ namespace triqs {
           resize_or_check_if_view(lhs, laz.domain().lengths());
 
           auto c           = laz.c;
-          auto slow_size   = first_dim(laz.ref);
-          auto slow_stride = laz.ref.indexmap().strides()[0];
-          auto sendcounts  = std::vector<int>(c.size());
-          auto displs      = std::vector<int>(c.size() + 1, 0);
-          int recvcount    = mpi::slice_length(slow_size - 1, c.size(), c.rank()) * slow_stride;
-          auto D           = mpi::mpi_datatype<typename A::value_type>();
+          long slow_size   = first_dim(laz.ref);
+          long slow_stride = laz.ref.indexmap().strides()[0];
+          auto sendcounts  = std::vector<long>(c.size());
+          auto displs      = std::vector<long>(c.size() + 1, 0);
 
           for (int r = 0; r < c.size(); ++r) {
             sendcounts[r] = mpi::slice_length(slow_size - 1, c.size(), r) * slow_stride;
             displs[r + 1] = sendcounts[r] + displs[r];
           }
 
-          MPI_Scatterv((void *)laz.ref.data_start(), &sendcounts[0], &displs[0], D, (void *)lhs.data_start(), recvcount, D, laz.root, c.get());
+          mpi::scatterv_n(laz.ref.data_start(), sendcounts, displs, lhs.data_start(), c, laz.root);
         }
       };
 
@@ -196,30 +260,14 @@ namespace triqs {
 
           if (!has_contiguous_data(lhs)) TRIQS_RUNTIME_ERROR << "mpi gather of array into a non contiguous view";
 
-          auto c          = laz.c;
-          auto recvcounts = std::vector<int>(c.size());
-          auto displs     = std::vector<int>(c.size() + 1, 0);
-          int sendcount   = laz.ref.domain().number_of_elements();
-          auto D          = mpi::mpi_datatype<typename A::value_type>();
+          auto c         = laz.c;
+          long sendcount = laz.ref.domain().number_of_elements();
 
           auto d = laz.domain();
           if (laz.all || (laz.c.rank() == laz.root)) resize_or_check_if_view(lhs, d.lengths());
 
-          void *lhs_p       = lhs.data_start();
-          const void *rhs_p = laz.ref.data_start();
-
-          auto mpi_ty = mpi::mpi_datatype<int>();
-          if (!laz.all)
-            MPI_Gather(&sendcount, 1, mpi_ty, &recvcounts[0], 1, mpi_ty, laz.root, c.get());
-          else
-            MPI_Allgather(&sendcount, 1, mpi_ty, &recvcounts[0], 1, mpi_ty, c.get());
-
-          for (int r = 0; r < c.size(); ++r) displs[r + 1] = recvcounts[r] + displs[r];
-
-          if (!laz.all)
-            MPI_Gatherv((void *)rhs_p, sendcount, D, lhs_p, &recvcounts[0], &displs[0], D, laz.root, c.get());
-          else
-            MPI_Allgatherv((void *)rhs_p, sendcount, D, lhs_p, &recvcounts[0], &displs[0], D, c.get());
+          auto [recvcounts, displs] = mpi::all_counts_and_displs(sendcount, c);
+          mpi::gatherv_n(laz.ref.data_start(), sendcount, lhs.data_start(), recvcounts, displs, c, laz.root, laz.all);
         }
       };
     } // namespace assignment
@@ -21,6 +21,7 @@
  ******************************************************************************/
 
 #include <atomic>
+#include <memory>
 
 #ifndef TRIQS_MEM_BLOCK_H
 #define TRIQS_MEM_BLOCK_H
@@ -115,6 +116,8 @@ namespace triqs {
   *
   *   - allocated (and deleted in C++)
   *   - owned by a numpy python object (py_numpy)
+  *   - owned by another C++ object (owner), e.g. a MPI shared memory window. It is in state 1, but the memory
+  *     is not deleted at destruction : the block just releases its reference to the owner.
   *
   *  The block contains its own reference system, to avoid the use of shared_ptr in shared_block
   *  (which was very slow in critical codes).
@@ -157,6 +160,7 @@ namespace triqs {
 	std::atomic<size_t> weak_ref_count; // number of refs. :  >=1
         PyObject *py_numpy;    // if not null, an owned reference to a numpy which is the data of this block
         PyObject *py_guard;    // if not null, a BORROWED reference to the guard. If null, the guard does not exist
+        std::shared_ptr<void> owner; // if not null, the owner of the memory p
         static_assert(!std::is_const<ValueType>::value, "internal error");
 
 #ifdef TRIQS_WITH_PYTHON_SUPPORT
@@ -193,6 +197,13 @@ namespace triqs {
           weak_ref_count = 0;
         }
 
+        // construct to state 1, on the memory ptr of size s owned by owner. The memory is not deleted by the block.
+        mem_block(size_t s, ValueType *ptr, std::shared_ptr<void> owner_)
+           : size_(s), p(ptr), py_numpy(nullptr), py_guard(nullptr), owner(std::move(owner_)) {
+          ref_count      = 1;
+          weak_ref_count = 0;
+        }
+
         // emplace the object at position i. Used in init of non default constructible types
         void _init_raw(size_t i, ValueType &&x) { new (&p[i]) ValueType{std::move(x)}; }
 
@@ -224,7 +235,7 @@ namespace triqs {
           if (py_numpy)
             Py_DECREF(py_numpy); // state 1
           else {
-            if (p) { // state 2 or state 0
+            if (p and !owner) { // state 2 or state 0. If owner is set, the memory is released with it
               TRACE_MEM_DEBUG("Desallocating from C++ a block of size " << this->size_ << " at address " << p);
               TRIQS_MEMORY_USED_INC(-size_);
               if (raw_ptr)
@@ -245,6 +256,7 @@ namespace triqs {
           weak_ref_count = X.weak_ref_count;
           py_numpy       = X.py_numpy;
           py_guard       = X.py_guard;
+          owner          = std::move(X.owner);
           X.p            = nullptr;
           X.py_numpy     = nullptr;
           X.py_guard     = nullptr; // state 0, ready to destruct
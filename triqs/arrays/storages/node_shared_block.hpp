@@ -0,0 +1,77 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <memory>
+#include <type_traits>
+#include "./shared_block.hpp"
+#include "../../mpi/base.hpp"
+
+namespace triqs {
+  namespace arrays {
+    namespace storages {
+
+      // Frees the window of make_node_shared_block. Also identifies its blocks, cf node_shared_window
+      struct node_window_deleter {
+        void operator()(MPI_Win *w) const {
+          MPI_Win_free(w);
+          delete w;
+        }
+      };
+
+      /**
+       * A shared_block on memory shared by all the processes of a node, allocated once per node
+       * with MPI_Win_allocate_shared (MPI-3).
+       *
+       * Collective on node_comm, which must contain processes of a single node (cf communicator::split_shared).
+       * All processes get a block on the same memory. It is not initialized.
+       *
+       * The window is freed when the last reference to the block is released. MPI_Win_free being collective,
+       * the blocks must be released in the same order on all the processes of node_comm, and before MPI_Finalize.
+       * The writes in the block are made visible to the other processes with MPI_Win_sync (cf node_shared_window).
+       */
+      template <typename ValueType> shared_block<ValueType> make_node_shared_block(size_t size, mpi::communicator node_comm) {
+        static_assert(std::is_trivially_copyable<ValueType>::value, "make_node_shared_block : only for trivially copyable types");
+        if (size == 0) return shared_block<ValueType>();
+
+        // the first process of the node allocates the whole block
+        MPI_Aint local_size = (node_comm.rank() == 0 ? size * sizeof(ValueType) : 0);
+        void *base          = nullptr;
+        auto *win           = new MPI_Win;
+        MPI_Win_allocate_shared(local_size, sizeof(ValueType), MPI_INFO_NULL, node_comm.get(), &base, win);
+
+        // the others get its address in their address space
+        MPI_Aint segment_size;
+        int disp_unit;
+        MPI_Win_shared_query(*win, 0, &segment_size, &disp_unit, &base);
+
+        std::shared_ptr<void> owner(win, node_window_deleter{});
+        return shared_block<ValueType>(size, static_cast<ValueType *>(base), std::move(owner));
+      }
+
+      /// The MPI window of a block made by make_node_shared_block, or MPI_WIN_NULL for any other block
+      template <typename ValueType, bool Weak> MPI_Win node_shared_window(shared_block<ValueType, Weak> const &b) {
+        auto *d = std::get_deleter<node_window_deleter>(b.owner());
+        return (d ? *static_cast<MPI_Win *>(b.owner().get()) : MPI_WIN_NULL);
+      }
+
+    } // namespace storages
+  }   // namespace arrays
+} // namespace triqs
@@ -68,6 +68,13 @@ namespace triqs {
           }
         }
 
+        /// A block on the memory ptr of given size, owned by owner (e.g. a MPI shared memory window), which is kept alive by the block
+        explicit shared_block(size_t size, ValueType *ptr, std::shared_ptr<void> owner) {
+          s     = size;
+          sptr  = new mem_block<ValueType>(size, ptr, std::move(owner));
+          data_ = sptr->p;
+        }
+
         void _init_raw(size_t i, ValueType &&x) {
           assert(sptr);
           sptr->_init_raw(i, std::move(x));
@@ -152,6 +159,12 @@ namespace triqs {
         size_t size() const { return s; }
         //size_t size() const {return (empty () ? 0 : sptr->size());}
 
+        /// The owner of the memory, if it is owned by another object (e.g. a MPI shared memory window), or null
+        std::shared_ptr<void> const &owner() const {
+          static const std::shared_ptr<void> none;
+          return (sptr ? sptr->owner : none);
+        }
+
 #ifdef TRIQS_WITH_PYTHON_SUPPORT
         PyObject *new_python_ref() const { return sptr->new_python_ref(); }
 #endif
@@ -25,6 +25,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <climits>
+#include <limits>
 #include <triqs/utility/c14.hpp>
 #include <triqs/utility/exceptions.hpp>
 #include <triqs/arrays/vector.hpp>
@@ -51,6 +53,25 @@ namespace triqs {
     // Quantum number operators are Hermitian, hence their eigenvalues are real
     using quantum_number_t = double;
 
+    /// Parameters of the low-energy (truncated) diagonalization
+    /**
+     * Only the lowest eigenstates of each invariant subspace are computed and kept.
+     * The large subspaces are diagonalized with the Lanczos algorithm, on the sparse matrix of the Hamiltonian.
+     * All the functions of atom_diag then work in the space of the retained eigenstates.
+     */
+    struct truncation_t {
+      /// Maximal number of eigenstates kept in each invariant subspace (all if <= 0). The degenerate partners of the last one are kept too.
+      int n_lowest = 0;
+      /// Only the eigenstates with an energy (measured from the ground state) below this cutoff are kept,
+      /// but at least the lowest one of each subspace (and its degenerate partners).
+      double energy_cutoff = std::numeric_limits<double>::infinity();
+      /// Subspaces of a larger dimension are diagonalized with the Lanczos algorithm, the others with LAPACK.
+      int lanczos_min_dim = 500;
+
+      /// Is there any truncation ?
+      bool is_active() const { return n_lowest > 0 or energy_cutoff < std::numeric_limits<double>::infinity(); }
+    };
+
     /// Lightweight exact diagonalization solver
     /**
      * This class is provided as a simple tool to diagonalize Hamiltonians of
@@ -72,6 +93,7 @@ namespace triqs {
       /// Block-diagonal matrix type
       using block_matrix_t = std::vector<matrix_t>;
       /// State vector in the full Hilbert space, written in the eigenbasis of :math:`\hat H`.
+      /// For a truncated diagonalization, only on the retained eigenstates (size get_retained_hilbert_space_dim()).
       using full_hilbert_space_state_t = vector<scalar_t>;
       /// Many-body operator type used by this atom_diag specialization.
       using many_body_op_t = triqs::operators::many_body_operator_generic<scalar_t>;
@@ -82,6 +104,7 @@ namespace triqs {
         vector<double> eigenvalues;
         /// Unitary transformation matrix :math:`\hat U` from the Fock basis to the eigenbasis.
         /// Defined according to :math:`\hat H = \hat  U \mathrm{diag}(E) * \hat U^\dagger`.
+        /// With a truncated diagonalization, only the columns of the retained eigenstates.
         matrix_t unitary_matrix;
 
         // HDF5
@@ -151,6 +174,29 @@ namespace triqs {
        */
       atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops, std::vector<many_body_op_t> const &qn_vector);
 
+      /// Reduce a given Hamiltonian to a block-diagonal form and compute its low-energy eigenstates
+      /**
+       * As the auto-partition constructor, but only the lowest eigenstates of each invariant subspace are kept.
+       *
+       * @param h Hamiltonian operator to be diagonalized.
+       * @param fops Fundamental operator set; Must at least contain all fundamental operators met in `h`.
+       * @param truncation Which eigenstates are kept, and which subspaces are diagonalized with the Lanczos algorithm.
+       * @param n_min Only the Fock states with at least n_min particles are considered
+       * @param n_max Only the Fock states with at most n_max particles are considered
+       */
+      TRIQS_CPP2PY_IGNORE atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops, truncation_t const &truncation, int n_min = 0,
+                                    int n_max = INT_MAX);
+
+      /// Reduce a given Hamiltonian to a block-diagonal form with quantum numbers and compute its low-energy eigenstates
+      /**
+       * @param h Hamiltonian operator to be diagonalized.
+       * @param fops Fundamental operator set; Must at least contain all fundamental operators met in `h`.
+       * @param qn_vector Vector of quantum number operators.
+       * @param truncation Which eigenstates are kept, and which subspaces are diagonalized with the Lanczos algorithm.
+       */
+      TRIQS_CPP2PY_IGNORE atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops, std::vector<many_body_op_t> const &qn_vector,
+                                    truncation_t const &truncation);
+
       /// The Hamiltonian used at construction
       many_body_op_t const &get_h_atomic() const { return h_atomic; }
 
@@ -161,12 +207,25 @@ namespace triqs {
       TRIQS_CPP2PY_IGNORE class hilbert_space const &get_full_hilbert_space() const { return full_hs; }
 
       /// Dimension of the full Hilbert space
+      /**
+       * For a truncated diagonalization, the state vectors in the eigenbasis (get_vacuum_state, act, index_range_of_subspace)
+       * are smaller : their size is get_retained_hilbert_space_dim().
+       */
       int get_full_hilbert_space_dim() const { return full_hs.size(); }
 
+      /// Number of eigenstates, i.e. the size of the state vectors in the eigenbasis
+      /**
+       * Equal to get_full_hilbert_space_dim(), except for a truncated diagonalization where only
+       * the retained eigenstates are counted.
+       */
+      int get_retained_hilbert_space_dim() const {
+        return (n_subspaces() == 0 ? 0 : first_eigenstate_of_subspace.back() + get_subspace_dim(n_subspaces() - 1));
+      }
+
       /// Number of invariant subspaces
       int n_subspaces() const { return eigensystems.size(); }
 
-      /// The dimension of a subspace
+      /// The dimension of a subspace (the number of retained eigenstates for a truncated diagonalization)
       /**
        * @param sp_index Index of the invariant subspace.
        */
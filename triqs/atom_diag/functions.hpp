@@ -49,6 +49,48 @@ namespace triqs {
 */
     template <bool Complex> typename atom_diag<Complex>::block_matrix_t atomic_density_matrix(atom_diag<Complex> const &atom, double beta);
 
+    /// Block-sparse matrix of an operator in the eigenbasis of the Hamiltonian
+    /**
+ * For each invariant subspace B, the list of the non-zero blocks of the operator from B,
+ * i.e. the final subspace B' and the matrix from B to B'.
+ * Built once with `make_eigenbasis_op`, it can be reused by `trace_rho_op`, `act` and `quantum_number_eigenvalues`.
+ * @tparam Complex Do we have a diagonalization problem with a complex-valued Hamiltonian?
+ * @include triqs/atom_diag/functions.hpp
+ */
+    template <bool Complex> struct eigenbasis_op_t {
+      using matrix_t = typename atom_diag<Complex>::matrix_t;
+      struct block_t {
+        int target;   // the final subspace
+        matrix_t mat; // the matrix from the initial subspace to the final one
+      };
+      std::vector<std::vector<block_t>> blocks; // blocks[B] : the blocks from the subspace B
+      int n_blocks() const { return blocks.size(); }
+    };
+
+    /// The block-sparse matrix of an operator in the eigenbasis of the Hamiltonian
+    /**
+ * The subspaces are processed in parallel (OpenMP).
+ *
+ * @param op Many body operator.
+ * @param atom Solved diagonalization problem.
+ * @return The matrix of `op`, by blocks.
+ * @include triqs/atom_diag/functions.hpp
+ */
+    template <bool Complex>
+    eigenbasis_op_t<Complex> make_eigenbasis_op(typename atom_diag<Complex>::many_body_op_t const &op, atom_diag<Complex> const &atom);
+
+    /// Compute Tr (op * density_matrix)
+    /**
+ * @param density_matrix Density matrix as a list of diagonal blocks for all invariant subspaces in `atom`.
+ * @param op Operator to be averaged, in the eigenbasis.
+ * @param atom Solved diagonalization problem.
+ * @return Operator `op` averaged over the density matrix.
+ * @include triqs/atom_diag/functions.hpp
+ */
+    template <bool Complex>
+    typename atom_diag<Complex>::scalar_t trace_rho_op(typename atom_diag<Complex>::block_matrix_t const &density_matrix,
+                                                       eigenbasis_op_t<Complex> const &op, atom_diag<Complex> const &atom);
+
     /// Compute Tr (op * density_matrix)
     /**
  * @param density_matrix Density matrix as a list of diagonal blocks for all invariant subspaces in `atom`.
@@ -61,6 +103,19 @@ namespace triqs {
     typename atom_diag<Complex>::scalar_t trace_rho_op(typename atom_diag<Complex>::block_matrix_t const &density_matrix,
                                                        typename atom_diag<Complex>::many_body_op_t const &op, atom_diag<Complex> const &atom);
 
+    /// Act with operator `op` on state `st`
+    /**
+ * @param op Operator to act on the state, in the eigenbasis.
+ * @param st Initial state vector in the full Hilbert space, written in the eigenbasis of the Hamiltonian.
+ * @param atom Solved diagonalization problem.
+ * @return Final state vector in the full Hilbert space.
+ * @include triqs/atom_diag/functions.hpp
+ */
+    template <bool Complex>
+    typename atom_diag<Complex>::full_hilbert_space_state_t act(eigenbasis_op_t<Complex> const &op,
+                                                                typename atom_diag<Complex>::full_hilbert_space_state_t const &st,
+                                                                atom_diag<Complex> const &atom);
+
     /// Act with operator `op` on state `st`
     /**
  * @param op Operator to act on the state.
@@ -74,6 +129,19 @@ namespace triqs {
                                                                 typename atom_diag<Complex>::full_hilbert_space_state_t const &st,
                                                                 atom_diag<Complex> const &atom);
 
+    /// Compute values of a given quantum number for all eigenstates
+    /**
+ * The diagonal elements of the operator in the eigenbasis. Unlike the version taking a many body operator,
+ * it is not checked that `op` commutes with the Hamiltonian.
+ *
+ * @param op Observable operator in the eigenbasis; supposed to be a quantum number.
+ * @param atom Solved diagonalization problem.
+ * @return The eigenvalues by block
+ * @include triqs/atom_diag/functions.hpp
+ */
+    template <bool Complex>
+    std::vector<std::vector<quantum_number_t>> quantum_number_eigenvalues(eigenbasis_op_t<Complex> const &op, atom_diag<Complex> const &atom);
+
     /// Compute values of a given quantum number for all eigenstates
     /**
  * @param op Observable operator; supposed to be a quantum number (if not -> exception).
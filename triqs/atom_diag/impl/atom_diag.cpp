@@ -56,6 +56,21 @@ namespace triqs {
       fill_first_eigenstate_of_subspace();
       compute_vacuum();
     }
+
+    ATOM_DIAG_CONSTRUCTOR((many_body_op_t const &h, fundamental_operator_set const &fops, truncation_t const &truncation, int n_min, int n_max))
+       : h_atomic(h), fops(fops), full_hs(fops), vacuum(full_hs.size()) {
+      atom_diag_worker<Complex>{this, n_min, n_max, truncation}.autopartition();
+      fill_first_eigenstate_of_subspace();
+      compute_vacuum();
+    }
+
+    ATOM_DIAG_CONSTRUCTOR((many_body_op_t const &h, fundamental_operator_set const &fops, std::vector<many_body_op_t> const &qn_vector,
+                           truncation_t const &truncation))
+       : h_atomic(h), fops(fops), full_hs(fops), vacuum(full_hs.size()) {
+      atom_diag_worker<Complex>{this, 0, INT_MAX, truncation}.partition_with_qn(qn_vector);
+      fill_first_eigenstate_of_subspace();
+      compute_vacuum();
+    }
     
     // -----------------------------------------------------------------
 
@@ -69,7 +84,8 @@ namespace triqs {
     // -----------------------------------------------------------------
 
     ATOM_DIAG_METHOD(void, compute_vacuum()) {
-      // Compute vacuum vector in the eigenbasis
+      // Compute vacuum vector in the eigenbasis (of the retained eigenstates)
+      vacuum.resize(first_eigenstate_of_subspace.back() + get_subspace_dim(n_subspaces() - 1));
       vacuum() = 0;
       for (int sp : range(sub_hilbert_spaces.size())) {
         if (sub_hilbert_spaces[sp].has_state(fock_state_t(0))) {
@@ -129,12 +145,7 @@ namespace triqs {
 	    op_mat.block_mat[b] += term.coef * mat;
 	  }
 	}
-	// Transform to Hamiltonian eigen basis
-	if( op_mat.connection(b) != -1 ) {
-	  auto U_left = dagger(eigensystems[op_mat.connection(b)].unitary_matrix);
-	  auto U_right = eigensystems[b].unitary_matrix;
-	  op_mat.block_mat[b] = U_left * op_mat.block_mat[b] * U_right;
-	}
+	// NB : the c, c_dag matrices, hence mat, are already in the Hamiltonian eigen basis
       }
       return std::move(op_mat);
     }
@@ -209,6 +220,8 @@ namespace triqs {
 
     template <bool Complex> std::ostream &operator<<(std::ostream &os, atom_diag<Complex> const &ad) {
       os << "Dimension of full Hilbert space: " << ad.get_full_hilbert_space_dim() << std::endl;
+      if (ad.get_retained_hilbert_space_dim() != ad.get_full_hilbert_space_dim())
+        os << "Number of retained eigenstates (truncated diagonalization): " << ad.get_retained_hilbert_space_dim() << std::endl;
       os << "Number of invariant subspaces: " << ad.n_subspaces() << std::endl;
       for (int n_sp = 0; n_sp < ad.n_subspaces(); ++n_sp) {
         os << "Subspace " << n_sp << ", ";
@@ -69,53 +69,105 @@ namespace triqs {
     template <bool Complex>
     auto matrix_element_of_monomial(ATOM_DIAG const &atom, operators::monomial_t const &op_vec, int B) -> std::pair<int, ATOM_DIAG_T::matrix_t> {
 
-      auto m           = triqs::arrays::make_unit_matrix<ATOM_DIAG_T::scalar_t>(atom.get_subspace_dim(B));
+      if (op_vec.empty()) return {B, triqs::arrays::make_unit_matrix<ATOM_DIAG_T::scalar_t>(atom.get_subspace_dim(B))};
+      ATOM_DIAG_T::matrix_t m;
       auto const &fops = atom.get_fops();
       for (int i = op_vec.size() - 1; i >= 0; --i) {
         int ind = fops[op_vec[i].indices];
         int Bp  = (op_vec[i].dagger ? atom.cdag_connection(ind, B) : atom.c_connection(ind, B));
         if (Bp == -1) return {-1, std::move(m)};
-        m = (op_vec[i].dagger ? atom.cdag_matrix(ind, B) : atom.c_matrix(ind, B)) * m;
+        auto const &c = (op_vec[i].dagger ? atom.cdag_matrix(ind, B) : atom.c_matrix(ind, B));
+        if (i == int(op_vec.size()) - 1)
+          m = c; // no product with the unit matrix
+        else
+          m = c * m;
         B = Bp;
       }
       return {B, std::move(m)};
     }
 
+    // -----------------------------------------------------------------
+    template <bool Complex> eigenbasis_op_t<Complex> make_eigenbasis_op(ATOM_DIAG_T::many_body_op_t const &op, ATOM_DIAG const &atom) {
+      eigenbasis_op_t<Complex> result;
+      int n_blocks = atom.n_subspaces();
+      result.blocks.resize(n_blocks);
+#pragma omp parallel for schedule(dynamic)
+      for (int B = 0; B < n_blocks; ++B) {
+        auto &blocks = result.blocks[B];
+        for (auto const &x : op) {
+          auto b_m = matrix_element_of_monomial(atom, x.monomial, B);
+          if (b_m.first == -1) continue;
+          auto it = std::find_if(blocks.begin(), blocks.end(), [&b_m](auto const &b) { return b.target == b_m.first; });
+          if (it == blocks.end())
+            blocks.push_back({b_m.first, x.coef * b_m.second});
+          else
+            it->mat += x.coef * b_m.second;
+        }
+      }
+      return result;
+    }
+    template eigenbasis_op_t<false> make_eigenbasis_op(ATOM_DIAG_R::many_body_op_t const &, ATOM_DIAG_R const &);
+    template eigenbasis_op_t<true> make_eigenbasis_op(ATOM_DIAG_C::many_body_op_t const &, ATOM_DIAG_C const &);
+
     // -----------------------------------------------------------------
 
     template <bool Complex>
-    ATOM_DIAG_T::scalar_t trace_rho_op(ATOM_DIAG_T::block_matrix_t const &density_matrix, ATOM_DIAG_T::many_body_op_t const &op,
-                                       ATOM_DIAG const &atom) {
-      ATOM_DIAG_T::scalar_t result = 0;
-      if (atom.n_subspaces() != density_matrix.size()) TRIQS_RUNTIME_ERROR << "trace_rho_op : size mismatch : number of blocks differ";
-      for (int sp = 0; sp < atom.n_subspaces(); ++sp) {
+    ATOM_DIAG_T::scalar_t trace_rho_op(ATOM_DIAG_T::block_matrix_t const &density_matrix, eigenbasis_op_t<Complex> const &op, ATOM_DIAG const &atom) {
+      int n_blocks = atom.n_subspaces();
+      if (n_blocks != density_matrix.size()) TRIQS_RUNTIME_ERROR << "trace_rho_op : size mismatch : number of blocks differ";
+      if (n_blocks != op.n_blocks()) TRIQS_RUNTIME_ERROR << "trace_rho_op : size mismatch : the operator has " << op.n_blocks() << " blocks";
+      for (int sp = 0; sp < n_blocks; ++sp) {
         if (atom.get_subspace_dim(sp) != first_dim(density_matrix[sp]))
           TRIQS_RUNTIME_ERROR << "trace_rho_op : size mismatch : size of block " << sp << " differ";
-        for (auto const &x : op) {
-          auto b_m = matrix_element_of_monomial(atom, x.monomial, sp);
-          if (b_m.first == sp) result += x.coef * trace(b_m.second * density_matrix[sp]);
+      }
+      // Tr(M rho) = sum_ij M(i,j) rho(j,i) on the diagonal blocks of op. Summed in a fixed order, whatever the number of threads
+      std::vector<ATOM_DIAG_T::scalar_t> tr(n_blocks, 0);
+#pragma omp parallel for schedule(dynamic)
+      for (int sp = 0; sp < n_blocks; ++sp) {
+        for (auto const &b : op.blocks[sp]) {
+          if (b.target != sp) continue;
+          auto const &rho = density_matrix[sp];
+          int dim         = first_dim(rho);
+          for (int i = 0; i < dim; ++i)
+            for (int j = 0; j < dim; ++j) tr[sp] += b.mat(i, j) * rho(j, i);
         }
       }
+      ATOM_DIAG_T::scalar_t result = 0;
+      for (auto const &x : tr) result += x;
       return result;
     }
+    template ATOM_DIAG_R::scalar_t trace_rho_op(ATOM_DIAG_R::block_matrix_t const &, eigenbasis_op_t<false> const &, ATOM_DIAG_R const &);
+    template ATOM_DIAG_C::scalar_t trace_rho_op(ATOM_DIAG_C::block_matrix_t const &, eigenbasis_op_t<true> const &, ATOM_DIAG_C const &);
+
+    template <bool Complex>
+    ATOM_DIAG_T::scalar_t trace_rho_op(ATOM_DIAG_T::block_matrix_t const &density_matrix, ATOM_DIAG_T::many_body_op_t const &op,
+                                       ATOM_DIAG const &atom) {
+      return trace_rho_op(density_matrix, make_eigenbasis_op(op, atom), atom);
+    }
     template ATOM_DIAG_R::scalar_t trace_rho_op(ATOM_DIAG_R::block_matrix_t const &, ATOM_DIAG_R::many_body_op_t const &, ATOM_DIAG_R const &);
     template ATOM_DIAG_C::scalar_t trace_rho_op(ATOM_DIAG_C::block_matrix_t const &, ATOM_DIAG_C::many_body_op_t const &, ATOM_DIAG_C const &);
 
     // -----------------------------------------------------------------
     template <bool Complex>
-    auto act(ATOM_DIAG_T::many_body_op_t const &op, ATOM_DIAG_T::full_hilbert_space_state_t const &st, ATOM_DIAG const &atom)
+    auto act(eigenbasis_op_t<Complex> const &op, ATOM_DIAG_T::full_hilbert_space_state_t const &st, ATOM_DIAG const &atom)
        -> ATOM_DIAG_T::full_hilbert_space_state_t {
+      if (op.n_blocks() != atom.n_subspaces()) TRIQS_RUNTIME_ERROR << "act : size mismatch : the operator has " << op.n_blocks() << " blocks";
       ATOM_DIAG_T::full_hilbert_space_state_t result(st.size());
       result() = 0;
-      for (auto const &x : op) {
-        for (int bl = 0; bl < atom.n_subspaces(); ++bl) {
-          auto b_m = matrix_element_of_monomial(atom, x.monomial, bl);
-          if (b_m.first == -1) continue;
-          result(atom.index_range_of_subspace(b_m.first)) += x.coef * b_m.second * st(atom.index_range_of_subspace(bl));
-        }
-      }
+      for (int bl = 0; bl < op.n_blocks(); ++bl)
+        for (auto const &b : op.blocks[bl]) result(atom.index_range_of_subspace(b.target)) += b.mat * st(atom.index_range_of_subspace(bl));
       return result;
     }
+    template ATOM_DIAG_R::full_hilbert_space_state_t act(eigenbasis_op_t<false> const &, ATOM_DIAG_R::full_hilbert_space_state_t const &,
+                                                         ATOM_DIAG_R const &);
+    template ATOM_DIAG_C::full_hilbert_space_state_t act(eigenbasis_op_t<true> const &, ATOM_DIAG_C::full_hilbert_space_state_t const &,
+                                                         ATOM_DIAG_C const &);
+
+    template <bool Complex>
+    auto act(ATOM_DIAG_T::many_body_op_t const &op, ATOM_DIAG_T::full_hilbert_space_state_t const &st, ATOM_DIAG const &atom)
+       -> ATOM_DIAG_T::full_hilbert_space_state_t {
+      return act(make_eigenbasis_op(op, atom), st, atom);
+    }
     template ATOM_DIAG_R::full_hilbert_space_state_t act(ATOM_DIAG_R::many_body_op_t const &, ATOM_DIAG_R::full_hilbert_space_state_t const &,
                                                          ATOM_DIAG_R const &);
     template ATOM_DIAG_C::full_hilbert_space_state_t act(ATOM_DIAG_C::many_body_op_t const &, ATOM_DIAG_C::full_hilbert_space_state_t const &,
@@ -123,24 +175,31 @@ namespace triqs {
 
     // -----------------------------------------------------------------
     template <bool Complex>
-    auto quantum_number_eigenvalues(ATOM_DIAG_T::many_body_op_t const &op, ATOM_DIAG const &atom) -> std::vector<std::vector<quantum_number_t>> {
-
-      auto commutator = op * atom.get_h_atomic() - atom.get_h_atomic() * op;
-      if (!commutator.is_zero()) TRIQS_RUNTIME_ERROR << "The operator is not a quantum number";
-
+    auto quantum_number_eigenvalues(eigenbasis_op_t<Complex> const &op, ATOM_DIAG const &atom) -> std::vector<std::vector<quantum_number_t>> {
+      if (op.n_blocks() != atom.n_subspaces())
+        TRIQS_RUNTIME_ERROR << "quantum_number_eigenvalues : size mismatch : the operator has " << op.n_blocks() << " blocks";
       std::vector<std::vector<quantum_number_t>> result;
-
       for (int sp = 0; sp < atom.n_subspaces(); ++sp) {
         auto dim = atom.get_subspace_dim(sp);
         result.push_back(std::vector<quantum_number_t>(dim, 0));
-        for (auto const &x : op) {
-          auto b_m = matrix_element_of_monomial(atom, x.monomial, sp);
-          if (b_m.first != sp) continue;
-          for (int i = 0; i < dim; ++i) result.back()[i] += real(x.coef * b_m.second(i, i));
+        for (auto const &b : op.blocks[sp]) {
+          if (b.target != sp) continue;
+          for (int i = 0; i < dim; ++i) result.back()[i] += real(b.mat(i, i));
         }
       }
       return result;
     }
+    template std::vector<std::vector<quantum_number_t>> quantum_number_eigenvalues(eigenbasis_op_t<false> const &, ATOM_DIAG_R const &);
+    template std::vector<std::vector<quantum_number_t>> quantum_number_eigenvalues(eigenbasis_op_t<true> const &, ATOM_DIAG_C const &);
+
+    template <bool Complex>
+    auto quantum_number_eigenvalues(ATOM_DIAG_T::many_body_op_t const &op, ATOM_DIAG const &atom) -> std::vector<std::vector<quantum_number_t>> {
+
+      auto commutator = op * atom.get_h_atomic() - atom.get_h_atomic() * op;
+      if (!commutator.is_zero()) TRIQS_RUNTIME_ERROR << "The operator is not a quantum number";
+
+      return quantum_number_eigenvalues(make_eigenbasis_op(op, atom), atom);
+    }
     template std::vector<std::vector<quantum_number_t>> quantum_number_eigenvalues(ATOM_DIAG_R::many_body_op_t const &, ATOM_DIAG_R const &);
     template std::vector<std::vector<quantum_number_t>> quantum_number_eigenvalues(ATOM_DIAG_C::many_body_op_t const &, ATOM_DIAG_C const &);
 
@@ -159,28 +218,15 @@ namespace triqs {
       auto commutator = op * atom.get_h_atomic() - atom.get_h_atomic() * op;
       if (!commutator.is_zero()) TRIQS_RUNTIME_ERROR << "The operator is not a quantum number";
 
-      auto d = atom.get_full_hilbert_space_dim();
-      matrix<quantum_number_t> M(d, d);
-      M() = 0;
-      std::vector<std::vector<quantum_number_t>> result;
-
+      // The matrix is diagonal iff its blocks between different subspaces vanish and its diagonal blocks are diagonal
+      auto op_mat = make_eigenbasis_op(op, atom);
       for (int sp = 0; sp < atom.n_subspaces(); ++sp) {
-        auto dim = atom.get_subspace_dim(sp);
-        for (auto const &x : op) {
-          auto b_m = matrix_element_of_monomial(atom, x.monomial, sp);
-          if (b_m.first == -1) continue;
-          M(atom.index_range_of_subspace(b_m.first), atom.index_range_of_subspace(sp)) += real(x.coef * b_m.second);
+        for (auto const &b : op_mat.blocks[sp]) {
+          bool diag = (b.target == sp ? is_diagonal(b.mat) : triqs::utility::is_zero(sum(abs(b.mat)), 1.e-11));
+          if (!diag) TRIQS_RUNTIME_ERROR << "The matrix of the operator is not diagonal !!!";
         }
       }
-      if (!is_diagonal(M)) TRIQS_RUNTIME_ERROR << "The matrix of the operator is not diagonal !!!";
-
-      for (int sp = 0; sp < atom.n_subspaces(); ++sp) {
-        auto dim = atom.get_subspace_dim(sp);
-        result.push_back(std::vector<quantum_number_t>(dim, 0));
-        for (int i = 0; i < dim; ++i) result.back()[i] = M(atom.flatten_subspace_index(sp, i), atom.flatten_subspace_index(sp, i));
-      }
-
-      return result;
+      return quantum_number_eigenvalues(op_mat, atom);
     }
     template std::vector<std::vector<quantum_number_t>> quantum_number_eigenvalues_checked(ATOM_DIAG_R::many_body_op_t const &, ATOM_DIAG_R const &);
     template std::vector<std::vector<quantum_number_t>> quantum_number_eigenvalues_checked(ATOM_DIAG_C::many_body_op_t const &, ATOM_DIAG_C const &);
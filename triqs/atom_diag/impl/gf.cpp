@@ -22,6 +22,7 @@
 #include "../gf.hpp"
 #include <cmath>
 #include <algorithm>
+#include <array>
 #include <limits>
 #include <utility>
 #include <vector>
@@ -159,20 +160,84 @@ namespace triqs {
 
     // -----------------------------------------------------------------
 
+    /// Fill block_gf<T> object from the Lehmann representation, matrix element by matrix element, in parallel (OpenMP)
+    /// kernel(g, n1, n2, terms) adds all the terms of the matrix element (n1, n2) to the block g
+    template <bool Complex, typename T, typename Kernel>
+    inline void fill_block_gf_by_element(block_gf_view<T> g, gf_lehmann_t<Complex> const &lehmann, Kernel kernel) {
+      check_lehmann_struct<Complex>(lehmann, g);
+
+      std::vector<std::array<int, 3>> elements; // (bl, n1, n2)
+      for (int bl = 0; bl < g.size(); ++bl) {
+        auto shape = g[bl].target_shape();
+        for (int n1 : range(shape[0]))
+          for (int n2 : range(shape[1]))
+            if (!lehmann[bl](n1, n2).empty()) elements.push_back({bl, n1, n2});
+      }
+#pragma omp parallel for schedule(dynamic)
+      for (long i = 0; i < long(elements.size()); ++i) {
+        auto [bl, n1, n2] = elements[i];
+        kernel(g[bl], n1, n2, lehmann[bl](n1, n2));
+      }
+    }
+
+    // The poles and the real and imaginary parts of the residues of one matrix element, as arrays for the vectorized kernels
+    struct lehmann_arrays {
+      std::vector<double> pole, re, im;
+      template <typename Terms> explicit lehmann_arrays(Terms const &terms) {
+        for (auto const &t : terms) add(t.first, t.second);
+      }
+      lehmann_arrays() = default;
+      void add(double p, dcomplex r) {
+        pole.push_back(p);
+        re.push_back(std::real(r));
+        im.push_back(std::imag(r));
+      }
+    };
+
+    // -----------------------------------------------------------------
+
     //////////////////////////
     /// GF: Imaginary time ///
     //////////////////////////
 
-    // Returns lambda-function compatible with atomic_g_lehmann_impl
-    // The lambda-function captures 'gf' and fills it when passed to atomic_g_lehmann_impl
-    template <bool Complex> auto make_term_proc(double beta, block_gf_view<imtime> gf) {
-      return [&gf, beta](int bl, int n1, int n2, double pole, ATOM_DIAG_T::scalar_t residue) {
-        gf_view<imtime, scalar_valued> g = slice_target_to_scalar(gf[bl], n1, n2);
-
-        auto w = -residue / (pole > 0 ? (1 + std::exp(-beta * pole)) : (std::exp(beta * pole) + 1));
+    // g(k) += sum_j w_j exp(-a_j * k * delta), k = 0 ... n-1, a_j >= 0 (the index is n-1-k if reversed).
+    // The exponentials are computed by recurrence along the mesh, and exactly every 64 points to bound the rounding errors.
+    // The poles are the inner loop, vectorized.
+    template <typename G> void add_decaying_exponentials(G &&g, double delta, lehmann_arrays const &w, bool reversed) {
+      long n = first_dim(g);
+      int m  = w.pole.size();
+      if (m == 0) return;
+      std::vector<double> x(m), r(m);
+      for (int j = 0; j < m; ++j) r[j] = std::exp(-w.pole[j] * delta);
+      double const *a = w.pole.data(), *wr = w.re.data(), *wi = w.im.data();
+      double *xp = x.data(), *rp = r.data();
+      for (long k = 0; k < n; ++k) {
+        if (k % 64 == 0)
+          for (int j = 0; j < m; ++j) xp[j] = std::exp(-a[j] * (k * delta));
+        double sr = 0, si = 0;
+#pragma omp simd reduction(+ : sr, si)
+        for (int j = 0; j < m; ++j) {
+          sr += wr[j] * xp[j];
+          si += wi[j] * xp[j];
+          xp[j] *= rp[j];
+        }
+        g(reversed ? n - 1 - k : k) += dcomplex{sr, si};
+      }
+    }
 
-        // Set data points
-        for (auto tau : g.mesh()) g[tau] += w * (pole > 0 ? std::exp(-double(tau) * pole) : std::exp((beta - double(tau)) * pole));
+    // The kernel for fill_block_gf_by_element on the (uniform) imaginary time mesh
+    //   G(tau) = - sum residue exp(-tau pole) / (1 + exp(-beta pole)), written with decaying exponentials only :
+    //   for pole > 0 from tau = 0, for pole < 0 from tau = beta
+    inline auto make_tau_kernel(double beta) {
+      return [beta](gf_view<imtime> g, int n1, int n2, auto const &terms) {
+        lehmann_arrays pos, neg; // the poles are stored as |pole|
+        for (auto const &[pole, residue] : terms) {
+          dcomplex w = -dcomplex(residue) / (1 + std::exp(-beta * std::abs(pole)));
+          (pole > 0 ? pos : neg).add(std::abs(pole), w);
+        }
+        auto d = g.data()(range(), n1, n2);
+        add_decaying_exponentials(d, g.mesh().delta(), pos, false);
+        add_decaying_exponentials(d, g.mesh().delta(), neg, true);
       };
     }
 
@@ -181,9 +246,8 @@ namespace triqs {
     /// G(\tau) from Lehmann representation
     template <bool Complex>
     block_gf<imtime> atomic_g_tau(gf_lehmann_t<Complex> const &lehmann, gf_struct_t const &gf_struct, gf_mesh<imtime> const &mesh) {
-      double beta = mesh.domain().beta;
-      auto g      = block_gf{mesh, gf_struct};
-      fill_block_gf_from_lehmann<Complex>(g(), lehmann, make_term_proc<Complex>(beta, g()));
+      auto g = block_gf{mesh, gf_struct};
+      fill_block_gf_by_element<Complex>(g(), lehmann, make_tau_kernel(mesh.domain().beta));
       return g;
     }
     template block_gf<imtime> atomic_g_tau<false>(gf_lehmann_t<false> const &, gf_struct_t const &, gf_mesh<imtime> const &);
@@ -195,9 +259,7 @@ namespace triqs {
     template <bool Complex>
     block_gf<imtime> atomic_g_tau(ATOM_DIAG const &atom, double beta, gf_struct_t const &gf_struct, int n_tau,
                                   excluded_states_t const &excluded_states) {
-      auto g = block_gf<imtime>{{beta, Fermion, n_tau}, gf_struct};
-      atomic_g_lehmann_impl(atom, beta, gf_struct, excluded_states, make_term_proc<Complex>(beta, g()));
-      return g;
+      return atomic_g_tau<Complex>(atomic_g_lehmann(atom, beta, gf_struct, excluded_states), gf_struct, {beta, Fermion, n_tau});
     }
     template block_gf<imtime> atomic_g_tau(ATOM_DIAG_R const &, double, gf_struct_t const &, int, excluded_states_t const &);
     template block_gf<imtime> atomic_g_tau(ATOM_DIAG_C const &, double, gf_struct_t const &, int, excluded_states_t const &);
@@ -208,14 +270,24 @@ namespace triqs {
     /// GF: Matsubara frequencies ///
     /////////////////////////////////
 
-    // Returns lambda-function compatible with atomic_g_lehmann_impl
-    // The lambda-function captures 'gf' and fills it when passed to atomic_g_lehmann_impl
-    template <bool Complex> auto make_term_proc(block_gf_view<imfreq> gf) {
-      return [&gf](int bl, int n1, int n2, double pole, ATOM_DIAG_T::scalar_t residue) {
-        gf_view<imfreq, scalar_valued> g = slice_target_to_scalar(gf[bl], n1, n2);
-
-        // Set data points
-        for (auto iw : g.mesh()) g[iw] += residue / (iw - pole);
+    // The kernel for fill_block_gf_by_element on a Matsubara mesh : G(iw) = sum residue / (iw - pole)
+    // With residue = a + ib, residue / (iw - pole) = (a + ib)(-pole - iw) / (pole^2 + w^2). The poles are the inner loop, vectorized.
+    inline auto make_iw_kernel() {
+      return [](gf_view<imfreq> g, int n1, int n2, auto const &terms) {
+        lehmann_arrays l(terms);
+        int m           = l.pole.size();
+        double const *p = l.pole.data(), *a = l.re.data(), *b = l.im.data();
+        auto d          = g.data()(range(), n1, n2);
+        for (auto iw : g.mesh()) {
+          double w = std::imag(dcomplex(iw)), sr = 0, si = 0;
+#pragma omp simd reduction(+ : sr, si)
+          for (int j = 0; j < m; ++j) {
+            double den = 1 / (p[j] * p[j] + w * w);
+            sr += den * (b[j] * w - a[j] * p[j]);
+            si -= den * (a[j] * w + b[j] * p[j]);
+          }
+          d(iw.linear_index()) += dcomplex{sr, si};
+        }
       };
     }
 
@@ -225,7 +297,7 @@ namespace triqs {
     template <bool Complex>
     block_gf<imfreq> atomic_g_iw(gf_lehmann_t<Complex> const &lehmann, gf_struct_t const &gf_struct, gf_mesh<imfreq> const &mesh) {
       auto g = block_gf{mesh, gf_struct};
-      fill_block_gf_from_lehmann<Complex>(g(), lehmann, make_term_proc<Complex>(g()));
+      fill_block_gf_by_element<Complex>(g(), lehmann, make_iw_kernel());
       return g;
     }
     template block_gf<imfreq> atomic_g_iw<false>(gf_lehmann_t<false> const &, gf_struct_t const &, gf_mesh<imfreq> const &);
@@ -237,9 +309,7 @@ namespace triqs {
     template <bool Complex>
     block_gf<imfreq> atomic_g_iw(ATOM_DIAG const &atom, double beta, gf_struct_t const &gf_struct, int n_iw,
                                  excluded_states_t const &excluded_states) {
-      auto g = block_gf<imfreq>{{beta, Fermion, n_iw}, gf_struct};
-      atomic_g_lehmann_impl(atom, beta, gf_struct, excluded_states, make_term_proc<Complex>(g()));
-      return g;
+      return atomic_g_iw<Complex>(atomic_g_lehmann(atom, beta, gf_struct, excluded_states), gf_struct, {beta, Fermion, n_iw});
     }
     template block_gf<imfreq> atomic_g_iw(ATOM_DIAG_R const &, double, gf_struct_t const &, int, excluded_states_t const &);
     template block_gf<imfreq> atomic_g_iw(ATOM_DIAG_C const &, double, gf_struct_t const &, int, excluded_states_t const &);
@@ -298,14 +368,24 @@ namespace triqs {
     /// GF: Real frequencies ///
     ////////////////////////////
 
-    // Returns lambda-function compatible with atomic_g_lehmann_impl
-    // The lambda-function captures 'gf' and fills it when passed to atomic_g_lehmann_impl
-    template <bool Complex> auto make_term_proc(block_gf_view<refreq> gf, double broadening) {
-      return [&gf, broadening](int bl, int n1, int n2, double pole, ATOM_DIAG_T::scalar_t residue) {
-        gf_view<refreq, scalar_valued> g = slice_target_to_scalar(gf[bl], n1, n2);
-
-        // Set data points
-        for (auto w : g.mesh()) g[w] += residue / (w + 1_j * broadening - pole);
+    // The kernel for fill_block_gf_by_element on a real frequency mesh : G(w) = sum residue / (w + i eta - pole)
+    // With residue = a + ib and x = w - pole, residue / (x + i eta) = (a + ib)(x - i eta) / (x^2 + eta^2). Vectorized on the poles.
+    inline auto make_w_kernel(double broadening) {
+      return [eta = broadening](gf_view<refreq> g, int n1, int n2, auto const &terms) {
+        lehmann_arrays l(terms);
+        int m           = l.pole.size();
+        double const *p = l.pole.data(), *a = l.re.data(), *b = l.im.data();
+        auto d          = g.data()(range(), n1, n2);
+        for (auto w : g.mesh()) {
+          double sr = 0, si = 0, wr = w;
+#pragma omp simd reduction(+ : sr, si)
+          for (int j = 0; j < m; ++j) {
+            double x = wr - p[j], den = 1 / (x * x + eta * eta);
+            sr += den * (a[j] * x + b[j] * eta);
+            si += den * (b[j] * x - a[j] * eta);
+          }
+          d(w.linear_index()) += dcomplex{sr, si};
+        }
       };
     }
 
@@ -315,7 +395,7 @@ namespace triqs {
     template <bool Complex>
     block_gf<refreq> atomic_g_w(gf_lehmann_t<Complex> const &lehmann, gf_struct_t const &gf_struct, gf_mesh<refreq> const &mesh, double broadening) {
       auto g = block_gf{mesh, gf_struct};
-      fill_block_gf_from_lehmann<Complex>(g(), lehmann, make_term_proc<Complex>(g(), broadening));
+      fill_block_gf_by_element<Complex>(g(), lehmann, make_w_kernel(broadening));
       return g;
     }
     template block_gf<refreq> atomic_g_w<false>(gf_lehmann_t<false> const &, gf_struct_t const &, gf_mesh<refreq> const &, double);
@@ -327,9 +407,8 @@ namespace triqs {
     template <bool Complex>
     block_gf<refreq> atomic_g_w(ATOM_DIAG const &atom, double beta, gf_struct_t const &gf_struct, std::pair<double, double> const &energy_window,
                                 int n_w, double broadening, excluded_states_t const &excluded_states) {
-      auto g = block_gf<refreq>{{energy_window.first, energy_window.second, n_w}, gf_struct};
-      atomic_g_lehmann_impl(atom, beta, gf_struct, excluded_states, make_term_proc<Complex>(g(), broadening));
-      return g;
+      gf_mesh<refreq> mesh{energy_window.first, energy_window.second, n_w};
+      return atomic_g_w<Complex>(atomic_g_lehmann(atom, beta, gf_struct, excluded_states), gf_struct, mesh, broadening);
     }
     template block_gf<refreq> atomic_g_w(ATOM_DIAG_R const &, double, gf_struct_t const &, std::pair<double, double> const &, int, double,
                                          excluded_states_t const &);
@@ -0,0 +1,233 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <triqs/arrays.hpp>
+#include <triqs/arrays/blas_lapack/dot.hpp>
+#include <triqs/arrays/linalg/eigenelements.hpp>
+#include <triqs/utility/exceptions.hpp>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace triqs {
+  namespace atom_diag {
+
+    using namespace triqs::arrays;
+
+    // A sparse matrix, stored by columns
+    template <typename T> struct sparse_matrix {
+      long dim                    = 0;
+      std::vector<long> col_start = {0};
+      std::vector<int> row;
+      std::vector<T> val;
+
+      // Append the column dim. Call with each non zero element of the column, in any order, then end_col()
+      void push_back(int r, T v) {
+        row.push_back(r);
+        val.push_back(v);
+      }
+      void end_col() {
+        col_start.push_back(row.size());
+        ++dim;
+      }
+
+      // y = M x
+      void apply(vector<T> const &x, vector<T> &y) const {
+        y() = 0;
+        for (long c = 0; c < dim; ++c) {
+          T xc = x(c);
+          for (long k = col_start[c]; k < col_start[c + 1]; ++k) y(row[k]) += val[k] * xc;
+        }
+      }
+    };
+
+    /**
+     * Lowest eigenpairs of a Hermitian sparse matrix : Lanczos with full reorthogonalization and locking.
+     *
+     * Each run starts from a random vector orthogonal to the locked eigenvectors. The converged Ritz pairs
+     * at the bottom of the spectrum are locked, so that the degenerate eigenvectors, which a single Lanczos run
+     * can not resolve, are found by the next runs.
+     */
+    template <typename T> class lanczos_solver {
+      sparse_matrix<T> const &h;
+      long dim;
+      std::vector<vector<T>> locked_vec;
+      std::vector<double> locked_val;
+      std::mt19937 rng{1234};
+      int n_steps;
+      double tol;
+      int max_restarts;
+
+      static constexpr double degeneracy_tol = 1.e-8;
+
+      public:
+      /**
+       * @param h The matrix, Hermitian
+       * @param n_steps Number of Lanczos steps of a run (doubled when nothing converges)
+       * @param tol Convergence criterion on the norm of the residual of a Ritz pair, relative to max(1, |eigenvalue|)
+       * @param max_restarts Maximal number of successive runs where nothing converges
+       */
+      lanczos_solver(sparse_matrix<T> const &h, int n_steps = 100, double tol = 1.e-10, int max_restarts = 10)
+         : h(h), dim(h.dim), n_steps(n_steps), tol(tol), max_restarts(max_restarts) {}
+
+      /**
+       * Converge the eigenpairs with an eigenvalue <= e_max, or the n_max lowest ones (with their degenerate partners)
+       * if there are more of them. The lowest eigenvalue and its degenerate partners are always converged.
+       * Can be called again with larger n_max or e_max : the eigenpairs already converged are kept.
+       * Throws if the lowest eigenpair does not converge after max_restarts runs, or with a full Krylov space.
+       */
+      void run(int n_max, double e_max) {
+        long m         = n_steps;
+        int n_restarts = 0;
+        while (locked_vec.size() < dim) {
+          long m_run                           = std::min<long>(m, dim - locked_vec.size());
+          auto [ritz_val, ritz_vec, converged] = lanczos(m_run);
+          if (!converged[0]) { // not even the lowest one : longer runs
+            if (m_run == dim - locked_vec.size() or ++n_restarts > max_restarts)
+              TRIQS_RUNTIME_ERROR << "Lanczos : no convergence after " << n_restarts << " runs of at most " << m_run << " steps (dimension " << dim
+                                  << ", " << locked_vec.size() << " eigenvectors converged)";
+            m *= 2;
+            continue;
+          }
+          n_restarts = 0;
+          if (!locked_val.empty() and ritz_val[0] > threshold(n_max, e_max)) return;
+          for (int i = 0; i < ritz_val.size() and converged[i]; ++i) {
+            if (!locked_val.empty() and ritz_val[i] > threshold(n_max, e_max)) break;
+            locked_val.push_back(ritz_val[i]);
+            locked_vec.push_back(std::move(ritz_vec[i]));
+          }
+        }
+      }
+
+      /// The converged eigenvalues (sorted) and the eigenvectors as columns, restricted as in run
+      std::pair<vector<double>, matrix<T>> eigenelements(int n_max, double e_max) const {
+        std::vector<int> perm(locked_val.size());
+        std::iota(perm.begin(), perm.end(), 0);
+        std::sort(perm.begin(), perm.end(), [this](int i, int j) { return locked_val[i] < locked_val[j]; });
+        std::vector<double> sorted;
+        for (int i : perm) sorted.push_back(locked_val[i]);
+        int n = n_retained(sorted, n_max, e_max);
+        std::pair<vector<double>, matrix<T>> r{vector<double>(n), matrix<T>(dim, n)};
+        for (int k = 0; k < n; ++k) {
+          r.first(k)           = sorted[k];
+          r.second(range(), k) = locked_vec[perm[k]];
+        }
+        return r;
+      }
+
+      /// Number of the lowest of the sorted eigenvalues e to keep : those <= e_max, at most n_max (and their degenerate partners),
+      /// and at least the lowest one and its degenerate partners
+      static int n_retained(std::vector<double> const &e, int n_max, double e_max) {
+        auto keep = [&](int n) {
+          return e[n] <= e[0] + degeneracy_tol or (e[n] <= e_max and (n < n_max or e[n] <= e[n_max - 1] + degeneracy_tol));
+        };
+        int n = 1;
+        while (n < e.size() and keep(n)) ++n;
+        return n;
+      }
+
+      private:
+      // The largest eigenvalue still to be converged (cf n_retained). Precondition : locked_val is not empty
+      double threshold(int n_max, double e_max) const {
+        double e_min = *std::min_element(locked_val.begin(), locked_val.end());
+        if (locked_val.size() >= n_max) {
+          auto v = locked_val;
+          std::nth_element(v.begin(), v.begin() + n_max - 1, v.end());
+          e_max = std::min(e_max, v[n_max - 1] + degeneracy_tol);
+        }
+        return std::max(e_max, e_min + degeneracy_tol);
+      }
+
+      static double real_part(T const &x) { return std::real(x); }
+
+      // Orthogonalize w against the locked vectors and the vectors of v (twice, for stability)
+      void orthogonalize(vector<T> &w, std::vector<vector<T>> const &v) const {
+        for (int pass = 0; pass < 2; ++pass) {
+          for (auto const &u : locked_vec) w -= dotc(u, w) * u;
+          for (auto const &u : v) w -= dotc(u, w) * u;
+        }
+      }
+
+      vector<T> random_vector() {
+        std::uniform_real_distribution<double> u(-1, 1);
+        vector<T> r(dim);
+        for (long i = 0; i < dim; ++i) {
+          if constexpr (std::is_same<T, double>::value)
+            r(i) = u(rng);
+          else
+            r(i) = T{u(rng), u(rng)};
+        }
+        return r;
+      }
+
+      // A Lanczos run of at most m steps. Returns the Ritz values (ascending), Ritz vectors, and whether they are converged
+      std::tuple<std::vector<double>, std::vector<vector<T>>, std::vector<bool>> lanczos(long m) {
+        std::vector<vector<T>> v;
+        std::vector<double> alpha, beta;
+        double beta_last = 0, scale = 1;
+
+        vector<T> w = random_vector();
+        orthogonalize(w, v);
+        w /= std::sqrt(real_part(dotc(w, w)));
+        vector<T> hv(dim);
+
+        for (long j = 0; j < m; ++j) {
+          v.push_back(w);
+          h.apply(v[j], hv);
+          alpha.push_back(real_part(dotc(v[j], hv)));
+          scale = std::max(scale, std::abs(alpha[j]));
+          w     = hv;
+          orthogonalize(w, v);
+          beta_last = std::sqrt(real_part(dotc(w, w)));
+          if (j == m - 1 or beta_last < tol * scale) break; // end of the run, or the Krylov space is invariant
+          beta.push_back(beta_last);
+          w /= beta_last;
+        }
+
+        // Ritz pairs from the tridiagonal matrix
+        long n = alpha.size();
+        matrix<double> t(n, n);
+        t() = 0;
+        for (long i = 0; i < n; ++i) t(i, i) = alpha[i];
+        for (long i = 0; i + 1 < n; ++i) t(i, i + 1) = t(i + 1, i) = beta[i];
+        auto [ev, s] = linalg::eigenelements(t); // eigenvectors as rows
+
+        std::vector<double> ritz_val(n);
+        std::vector<vector<T>> ritz_vec(n, vector<T>(dim));
+        std::vector<bool> converged(n);
+        for (long i = 0; i < n; ++i) {
+          ritz_val[i]   = ev(i);
+          converged[i]  = std::abs(beta_last * s(i, n - 1)) < tol * std::max(1.0, std::abs(ev(i)));
+          ritz_vec[i]() = 0;
+          for (long k = 0; k < n; ++k) ritz_vec[i] += s(i, k) * v[k];
+        }
+        return {std::move(ritz_val), std::move(ritz_vec), std::move(converged)};
+      }
+    };
+
+  } // namespace atom_diag
+} // namespace triqs
@@ -27,6 +27,7 @@
 #include <triqs/hilbert_space/imperative_operator.hpp>
 #include <triqs/hilbert_space/space_partition.hpp>
 #include <triqs/arrays/linalg/eigenelements.hpp>
+#include "./lanczos.hpp"
 
 using namespace triqs::hilbert_space;
 
@@ -258,25 +259,32 @@ namespace triqs {
       auto const &to_sp                    = hdiag->sub_hilbert_spaces[to_spn];
 
       imperative_operator<class hilbert_space, scalar_t> imp_op(op, fops);
+      auto const &U_from = hdiag->eigensystems[from_spn].unitary_matrix;
+      auto const &U_to   = hdiag->eigensystems[to_spn].unitary_matrix;
 
-      auto M = matrix_t(to_sp.size(), from_sp.size());
-      M()    = 0;
+      // W = M * U_from, with M the (sparse) matrix of op in the Fock basis : accumulate the rows of U_from.
+      // U_from, U_to only have the columns of the retained eigenstates for a truncated diagonalization.
+      auto W = matrix_t(to_sp.size(), second_dim(U_from));
+      W()    = 0;
 
+      state<class hilbert_space, scalar_t, true> from_s(full_hs), to_s(full_hs);
       for (int i = 0; i < from_sp.size(); ++i) { // loop on all fock states of the blocks
-        state<class hilbert_space, scalar_t, true> from_s(full_hs);
+        from_s.clear();
         from_s(from_sp.get_fock_state(i)) = 1.0;
-        auto to_s                         = imp_op(from_s);
-        auto proj_s                       = project<state<sub_hilbert_space, scalar_t, true>>(to_s, to_sp);
-        foreach (proj_s, [&](int j, scalar_t ampl) { M(j, i) = ampl; })
+        imp_op.act(from_s, to_s);
+        foreach (to_s, [&](int f, scalar_t ampl) { // projection on to_sp
+          auto fs = full_hs.get_fock_state(f);
+          if (to_sp.has_state(fs)) W(to_sp.get_state_index(fs), range()) += ampl * U_from(i, range());
+        })
           ;
       }
 
-      return dagger(hdiag->eigensystems[to_spn].unitary_matrix) * M * hdiag->eigensystems[from_spn].unitary_matrix;
+      return dagger(U_to) * W;
     }
 
     // -----------------------------------------------------------------
 
-    ATOM_DIAG_WORKER_METHOD(void, complete()) {
+    ATOM_DIAG_WORKER_METHOD(void, diagonalize()) {
 
       fundamental_operator_set const &fops = hdiag->get_fops();
       many_body_op_t const &h              = hdiag->get_h_atomic();
@@ -284,34 +292,104 @@ namespace triqs {
       imperative_operator<class hilbert_space, scalar_t, false> hamiltonian(h, fops);
 
       //  Compute energy levels and eigenvectors of the local Hamiltonian
-      int n_subspaces = hdiag->sub_hilbert_spaces.size();
-      hdiag->eigensystems.resize(n_subspaces);
+      int n_subspaces     = hdiag->sub_hilbert_spaces.size();
+      auto &eigensystems  = hdiag->eigensystems;
+      bool truncate       = truncation.is_active();
+      double const no_cut = -std::numeric_limits<double>::infinity();
+      eigensystems.resize(n_subspaces);
       hdiag->gs_energy = std::numeric_limits<double>::infinity();
 
-      // Prepare the eigensystem in a temporary map to sort them by energy !
-      std::map<std::pair<double, int>, typename atom_diag<Complex>::eigensystem_t> eign_map;
-      double energy_split = 1.e-10; // to split the eigenvalues, which are numerically very close
-      for (int spn = 0; spn < n_subspaces; ++spn) {
-        auto const &sp = hdiag->sub_hilbert_spaces[spn];
-        typename atom_diag<Complex>::eigensystem_t eigensystem;
+      // Large subspaces of a truncated diagonalization : sparse matrix of H and Lanczos (the map keeps their addresses)
+      std::map<int, sparse_matrix<scalar_t>> h_sparse;
+      std::map<int, lanczos_solver<scalar_t>> solvers;
 
-        state<sub_hilbert_space, scalar_t, false> i_state(sp);
+      // Dense matrix of H in the subspace and LAPACK : all the eigenstates
+      auto diagonalize_dense = [&](int spn) {
+        auto const &sp = hdiag->sub_hilbert_spaces[spn];
+        state<sub_hilbert_space, scalar_t, false> i_state(sp), f_state(sp);
         matrix_t h_matrix(sp.size(), sp.size());
 
         for (int i = 0; i < sp.size(); ++i) {
-          i_state.amplitudes()() = 0;
-          i_state(i)             = 1;
-          auto f_state           = hamiltonian(i_state);
-          h_matrix(range(), i)   = f_state.amplitudes();
+          i_state.clear();
+          i_state(i) = 1;
+          hamiltonian.act(i_state, f_state);
+          h_matrix(range(), i) = f_state.amplitudes();
+        }
+
+        auto eig                         = linalg::eigenelements(h_matrix);
+        eigensystems[spn].eigenvalues    = eig.first;
+        eigensystems[spn].unitary_matrix = eig.second.transpose(); // Convert from eigenvectors as rows to columns.
+      };
+
+      // When Lanczos does not converge (e.g. a badly conditioned subspace), the subspace is diagonalized with LAPACK
+      auto drop_solver = [&](int spn) {
+        solvers.erase(spn);
+        h_sparse.erase(spn);
+        diagonalize_dense(spn);
+      };
+
+      for (int spn = 0; spn < n_subspaces; ++spn) {
+        auto const &sp    = hdiag->sub_hilbert_spaces[spn];
+        auto &eigensystem = eigensystems[spn];
+
+        if (truncate and sp.size() > truncation.lanczos_min_dim) {
+          auto &h_sp = h_sparse[spn];
+          state<sub_hilbert_space, scalar_t, true> i_state(sp), f_state(sp);
+          for (int i = 0; i < sp.size(); ++i) {
+            i_state.clear();
+            i_state(i) = 1;
+            hamiltonian.act(i_state, f_state);
+            foreach (f_state, [&h_sp](int j, scalar_t x) { h_sp.push_back(j, x); })
+              ;
+            h_sp.end_col();
+          }
+          auto &solver = solvers.emplace(std::piecewise_construct, std::forward_as_tuple(spn), std::forward_as_tuple(h_sp)).first->second;
+          try {
+            solver.run(INT_MAX, no_cut); // only the lowest eigenvalue (multiplet) for now, to find the ground state energy
+            eigensystem.eigenvalues = solver.eigenelements(1, no_cut).first;
+          } catch (triqs::runtime_error const &) { drop_solver(spn); }
+        } else {
+          diagonalize_dense(spn);
         }
+        hdiag->gs_energy = std::min(hdiag->gs_energy, eigensystem.eigenvalues[0]);
+      }
 
-        auto eig                   = linalg::eigenelements(h_matrix);
-        eigensystem.eigenvalues    = eig.first;
-        eigensystem.unitary_matrix = eig.second.transpose(); // Convert from eigenvectors as rows to columns.
-        hdiag->gs_energy           = std::min(hdiag->gs_energy, eigensystem.eigenvalues[0]);
+      if (!truncate) return;
 
-        eign_map.insert({{eigensystem.eigenvalues(0) + energy_split * spn, spn}, eigensystem});
+      // Keep the low-energy eigenstates
+      int n_lowest = (truncation.n_lowest > 0 ? truncation.n_lowest : INT_MAX);
+      double e_max = hdiag->gs_energy + truncation.energy_cutoff;
+      for (int spn = 0; spn < n_subspaces; ++spn) {
+        auto &eigensystem = eigensystems[spn];
+        if (auto it = solvers.find(spn); it != solvers.end()) {
+          try {
+            it->second.run(n_lowest, e_max);
+            std::tie(eigensystem.eigenvalues, eigensystem.unitary_matrix) = it->second.eigenelements(n_lowest, e_max);
+            continue;
+          } catch (triqs::runtime_error const &) { drop_solver(spn); }
+        }
+        // All the eigenstates are known (LAPACK)
+        std::vector<double> e(eigensystem.eigenvalues.begin(), eigensystem.eigenvalues.end());
+        int n                      = lanczos_solver<scalar_t>::n_retained(e, n_lowest, e_max);
+        eigensystem.eigenvalues    = vector<double>(eigensystem.eigenvalues(range(0, n)));
+        eigensystem.unitary_matrix = matrix_t(eigensystem.unitary_matrix(range(), range(0, n)));
       }
+    }
+
+    // -----------------------------------------------------------------
+
+    ATOM_DIAG_WORKER_METHOD(void, complete()) {
+
+      fundamental_operator_set const &fops = hdiag->get_fops();
+
+      diagonalize();
+
+      // Prepare the eigensystem in a temporary map to sort them by energy !
+      int n_subspaces = hdiag->sub_hilbert_spaces.size();
+      std::map<std::pair<double, int>, typename atom_diag<Complex>::eigensystem_t> eign_map;
+      double energy_split = 1.e-10; // to split the eigenvalues, which are numerically very close
+      for (int spn = 0; spn < n_subspaces; ++spn)
+        eign_map.insert({{hdiag->eigensystems[spn].eigenvalues(0) + energy_split * spn, spn}, hdiag->eigensystems[spn]});
 
       // Reorder the block along their minimal energy
       {
@@ -36,7 +36,8 @@ namespace triqs {
       using matrix_t       = typename atom_diag<Complex>::matrix_t;
       using many_body_op_t = typename atom_diag<Complex>::many_body_op_t;
 
-      atom_diag_worker(atom_diag<Complex> *hdiag, int n_min = 0, int n_max = INT_MAX) : hdiag(hdiag), n_min(n_min), n_max(n_max) {}
+      atom_diag_worker(atom_diag<Complex> *hdiag, int n_min = 0, int n_max = INT_MAX, truncation_t const &truncation = {})
+         : hdiag(hdiag), n_min(n_min), n_max(n_max), truncation(truncation) {}
 
       void autopartition();
       void partition_with_qn(std::vector<many_body_op_t> const &qn_vector);
@@ -44,10 +45,14 @@ namespace triqs {
       private:
       atom_diag<Complex> *hdiag;
       int n_min, n_max;
+      truncation_t truncation;
 
       // Create matrix of an operator acting from one subspace to another
       matrix_t make_op_matrix(many_body_op_t const &op, int from_sp, int to_sp) const;
 
+      // Diagonalize the Hamiltonian in each subspace (truncated if needed)
+      void diagonalize();
+
       void complete();
       bool fock_state_filter(fock_state_t s);
     };
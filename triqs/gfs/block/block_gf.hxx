@@ -96,8 +96,41 @@ namespace triqs {
         return r;
       }
       inline std::vector<std::vector<std::string>> _make_block_names2(int n, int p) { return {_make_block_names1(n), _make_block_names1(p)}; }
+
+      // Do the gf in x and y (gf, or vectors of gf) have the same data shapes
+      template <typename X, typename Y> bool _same_data_shapes(X const &x, Y const &y) {
+        if constexpr (is_gf<X>::value)
+          return x.data_shape() == y.data_shape();
+        else {
+          if (x.size() != y.size()) return false;
+          for (int i = 0; i < x.size(); ++i)
+            if (!_same_data_shapes(x[i], y[i])) return false;
+          return true;
+        }
+      }
     } // namespace details
 
+    /**
+     * Non-blocking reduction of the block_gf or block2_gf g, in place : the result is in g on root (or on all nodes if all)
+     * when the request is completed. g must not be used (nor destroyed) until then.
+     * All the blocks are reduced with a single collective.
+     */
+    template <typename BG>
+    std::enable_if_t<is_block_gf_or_view<BG>::value, mpi::request> mpi_ireduce(BG &g, mpi::communicator c = {}, int root = 0, bool all = false,
+                                                                              MPI_Op op = MPI_SUM) {
+      return mpi::mpi_ireduce_in_place_packed(g.data(), c, root, all, op);
+    }
+
+    /**
+     * Reduction of the block_gf or block2_gf g in place, first within each node then between the nodes (cf mpi::hierarchical_reduce_n).
+     * All the blocks are reduced together.
+     */
+    template <typename BG>
+    std::enable_if_t<is_block_gf_or_view<BG>::value> mpi_hierarchical_reduce(BG &g, mpi::node_topology const &t, int root = 0, bool all = false,
+                                                                            MPI_Op op = MPI_SUM) {
+      mpi::mpi_reduce_in_place_packed(g.data(), t, root, all, op);
+    }
+
     /// ---------------------------  implementation  ---------------------------------
 
     // ----------------------  block_gf -----------------------------------------
@@ -250,9 +283,10 @@ namespace triqs {
     */
       block_gf &operator=(mpi_lazy<mpi::tag::reduce, block_gf::const_view_type> l) {
         _block_names = l.rhs.block_names();
-        _glist       = mpi_reduce(l.rhs.data(), l.c, l.root, l.all, l.op);
+        _glist       = factory<data_t>(l.rhs.data());
+        // all the blocks are reduced with a single collective
+        mpi::mpi_reduce_in_place_packed(_glist, l.c, l.root, l.all, l.op);
         return *this;
-        // mpi_reduce of vector produces a new vector of gf, so it is fine here
       }
 
       /**
@@ -604,9 +638,12 @@ namespace triqs {
         if (l.rhs.size() != this->size())
           TRIQS_RUNTIME_ERROR << "mpi reduction of block_gf : size of RHS is incompatible with the size of the view to be assigned to";
         _block_names = l.rhs.block_names();
-        for (int i = 0; i < size(); ++i) _glist[i] = mpi_reduce(l.rhs.data()[i], l.c, l.root, l.all, l.op);
-        // here we need to enumerate the vector, the mpi_reduce produce a vector<gf>, NOT a gf_view,
-        // we can not overload the = of vector for better API.
+        if (!details::_same_data_shapes(_glist, l.rhs.data()))
+          TRIQS_RUNTIME_ERROR << "mpi reduction of block_gf : the blocks of RHS and of the view to be assigned to have different shapes";
+        // all the blocks are reduced with a single collective, then copied into the views
+        mpi::packed_reduce<mpi::packed_value_t<data_t>> p;
+        p.pack(l.rhs.data());
+        if (p.reduce(l.c, l.root, l.all, l.op)) p.unpack(_glist);
       }
 
       /**
@@ -1273,9 +1310,10 @@ namespace triqs {
     */
       block2_gf &operator=(mpi_lazy<mpi::tag::reduce, block2_gf::const_view_type> l) {
         _block_names = l.rhs.block_names();
-        _glist       = mpi_reduce(l.rhs.data(), l.c, l.root, l.all, l.op);
+        _glist       = factory<data_t>(l.rhs.data());
+        // all the blocks are reduced with a single collective
+        mpi::mpi_reduce_in_place_packed(_glist, l.c, l.root, l.all, l.op);
         return *this;
-        // mpi_reduce of vector produces a new vector of gf, so it is fine here
       }
 
       /**
@@ -1627,10 +1665,12 @@ namespace triqs {
         if (l.rhs.size() != this->size())
           TRIQS_RUNTIME_ERROR << "mpi reduction of block_gf : size of RHS is incompatible with the size of the view to be assigned to";
         _block_names = l.rhs.block_names();
-        for (int i = 0; i < size1(); ++i)
-          for (int j = 0; j < size2(); ++j) _glist[i][j] = mpi_reduce(l.rhs.data()[i][j], l.c, l.root, l.all, l.op);
-        // here we need to enumerate the vector, the mpi_reduce produce a vector<gf>, NOT a gf_view,
-        // we can not overload the = of vector for better API.
+        if (!details::_same_data_shapes(_glist, l.rhs.data()))
+          TRIQS_RUNTIME_ERROR << "mpi reduction of block_gf : the blocks of RHS and of the view to be assigned to have different shapes";
+        // all the blocks are reduced with a single collective, then copied into the views
+        mpi::packed_reduce<mpi::packed_value_t<data_t>> p;
+        p.pack(l.rhs.data());
+        if (p.reduce(l.c, l.root, l.all, l.op)) p.unpack(_glist);
       }
 
       /**
@@ -187,5 +187,10 @@ namespace triqs {
       return map_block_gf(l, g);
     }
 
+    /// Invert in place all the blocks of a block_gf, block2_gf or of a (non const) view
+    template <typename BG> std::enable_if_t<is_block_gf_or_view<BG>::value> invert_in_place(BG &&g) {
+      for (auto &x : g) invert_in_place(x);
+    }
+
   } // namespace gfs
 } // namespace triqs
@@ -21,6 +21,7 @@
 #pragma once
 #include "../meshes/product.hpp"
 #include "../../utility/itertools.hpp"
+#include "../../arrays/linalg/batched_inverse.hpp"
 
 namespace triqs::gfs {
 
@@ -178,7 +179,26 @@ namespace triqs::gfs {
   *-----------------------------------------------------------------------------------------------------*/
 
   // auxiliary function : invert the data : one function for all matrix valued gf (save code).
+  // When the mesh indices can be grouped into one (e.g. the data of a gf), all matrices are inverted as a batch.
   template <typename A3> void _gf_invert_data_in_place(A3 &&a) {
+    using T         = typename std::decay_t<A3>::value_type;
+    constexpr int R = std::decay_t<A3>::rank - 2; // rank of the mesh
+    auto const &l   = a.indexmap().lengths();
+    auto const &s   = a.indexmap().strides();
+    size_t n_mesh   = l[0];
+    bool can_group  = true;
+    for (int r = 1; r < R; ++r) {
+      n_mesh *= l[r];
+      can_group &= (s[r - 1] == s[r] * std::ptrdiff_t(l[r]));
+    }
+    if (can_group) {
+      using idx_map_t = typename arrays::array_view<T, 3>::indexmap_type;
+      auto idx_map    = idx_map_t{{n_mesh, l[R], l[R + 1]}, {s[R - 1], s[R], s[R + 1]}, std::ptrdiff_t(a.indexmap().start_shift())};
+      auto v          = arrays::array_view<T, 3>{idx_map, a.storage()};
+      arrays::inverse_in_place_batched(v);
+      return;
+    }
+
     auto dom = a(ellipsis(), 0, 0).indexmap().domain();
     auto f   = [&a, _ = arrays::range()](auto... x) { return a(x..., _, _); };
     for (auto ind : dom) {
@@ -188,6 +208,7 @@ namespace triqs::gfs {
   }
 
   template <typename M> void invert_in_place(gf_view<M, matrix_valued> g) { _gf_invert_data_in_place(g.data()); }
+  template <typename M> void invert_in_place(gf<M, matrix_valued> &g) { _gf_invert_data_in_place(g.data()); }
 
   template <typename M> gf<M, matrix_valued> inverse(gf<M, matrix_valued> const &g) {
     auto res                    = g;
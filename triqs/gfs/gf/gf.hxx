@@ -71,6 +71,26 @@ namespace triqs {
 
     template <typename G, typename M> inline constexpr bool  is_gf_v = is_gf<G, M>::value;
 
+    // The data of a gf, for the packed mpi reductions (cf triqs/mpi/packed.hpp)
+    template <typename G, typename = std::enable_if_t<is_gf<std::decay_t<G>>::value>> decltype(auto) mpi_pack_data(G &g) { return g.data(); }
+
+    /**
+     * Non-blocking reduction of the gf g, in place : the result is in g on root (or on all nodes if all) when the request is completed.
+     * g must not be used (nor destroyed) until then.
+     */
+    template <typename G>
+    std::enable_if_t<is_gf<std::decay_t<G>>::value, mpi::request> mpi_ireduce(G &&g, mpi::communicator c = {}, int root = 0, bool all = false,
+                                                                             MPI_Op op = MPI_SUM) {
+      return arrays::mpi_ireduce(g.data(), c, root, all, op);
+    }
+
+    /// Reduction of g in place, first within each node then between the nodes. Cf arrays::mpi_hierarchical_reduce
+    template <typename G>
+    std::enable_if_t<is_gf<std::decay_t<G>>::value> mpi_hierarchical_reduce(G &&g, mpi::node_topology const &t, int root = 0, bool all = false,
+                                                                            MPI_Op op = MPI_SUM) {
+      arrays::mpi_hierarchical_reduce(g.data(), t, root, all, op);
+    }
+
     /// ---------------------------  implementation  ---------------------------------
 
     namespace details {
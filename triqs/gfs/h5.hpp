@@ -93,4 +93,33 @@ namespace triqs::gfs {
     }
   };
 
+  /// ---------------------------
+
+  /**
+   * Read a part of the data of the gf stored in gr[name] : the mesh points in mesh_slice (one range of linear indices
+   * per mesh of a cartesian product, completed with range()), for all the target indices, e.g. a few k points of G(k, iw).
+   * Only this part is read from the file. data is resized to the slice (or checked, for a view).
+   */
+  template <typename A> void h5_read_data_slice(h5::group gr, std::string const &name, A &&data, std::vector<range> const &mesh_slice) {
+    arrays::h5_read_slice(gr.open_group(name), "data", std::forward<A>(data), mesh_slice);
+  }
+
+#ifdef H5_HAVE_PARALLEL
+  /**
+   * Write a gf scattered over the processes of c (e.g. g = mpi_scatter(g_full, c)) into a file opened with MPI-IO (cf h5::file),
+   * collectively, without gathering it. g is the part of this process : each process writes its own data, and the gf in the file
+   * is the whole one, on the mesh mpi_gather(g.mesh(), c). Hence only for the meshes which can be scattered (e.g. imtime, refreq, retime).
+   * Only with a parallel HDF5 library.
+   */
+  template <typename G> std::enable_if_t<is_gf<G>::value> h5_write_distributed(h5::group fg, std::string const &name, G const &g, mpi::communicator c) {
+    auto mesh = mpi_gather(g.mesh(), c);
+    auto gr   = fg.create_group(name);
+    gr.write_hdf5_scheme(g);
+    arrays::h5_write_distributed(gr, "data", g.data(), c);
+    // the small metadata is written identically by all processes
+    h5_write(gr, "mesh", mesh);
+    h5_write(gr, "indices", g.indices());
+  }
+#endif
+
 } // namespace triqs::gfs
@@ -21,6 +21,7 @@
 #pragma once
 #include "./mesh_tools.hpp"
 #include "./linear_interpolation.hpp"
+#include <triqs/mpi/base.hpp>
 namespace triqs {
   namespace gfs {
 
@@ -127,6 +128,36 @@ namespace triqs {
         m = linear_mesh(std::move(dom), a, b, L);
       }
 
+      // -------------------- mpi -------------------
+
+      /**
+       * The part of the mesh m of this process in the mpi_scatter of a gf on m : the points mpi::slice_range(0, m.size() - 1, c.size(), c.rank()),
+       * i.e. the ones of the scattered data. It is a linear mesh with the same step. m must be the same on all processes.
+       */
+      template <typename M>
+      friend std14::enable_if_t<std::is_base_of<linear_mesh, M>::value, M> mpi_scatter(M const &m, mpi::communicator c = {}, int root = 0) {
+        auto [f, l]     = mpi::slice_range(0, m.size() - 1, c.size(), c.rank());
+        M r             = m;
+        linear_mesh &rl = r;
+        rl.L            = l - f + 1;
+        rl.xmin         = m.x_min() + f * m.delta();
+        rl.xmax         = (l == m.size() - 1 ? m.x_max() : m.x_min() + l * m.delta());
+        return r;
+      }
+
+      /// Inverse of mpi_scatter : the whole mesh, from its parts m on the processes of c. Collective, the result is valid on all processes.
+      template <typename M>
+      friend std14::enable_if_t<std::is_base_of<linear_mesh, M>::value, M> mpi_gather(M const &m, mpi::communicator c = {}, int root = 0) {
+        M r             = m;
+        linear_mesh &rl = r;
+        rl.L            = mpi::mpi_all_reduce(rl.L, c);
+        if (rl.L == 0) return r;
+        // the first point is on process 0, the last one on the last non empty part (cf mpi::slice_range)
+        mpi::mpi_broadcast(rl.xmin, c, 0);
+        mpi::mpi_broadcast(rl.xmax, c, int(std::min<long>(rl.L, c.size()) - 1));
+        return r;
+      }
+
       // -------------------- boost serialization -------------------
 
       friend class boost::serialization::access;
@@ -17,31 +17,41 @@ namespace triqs {
 
     file::file(const char *name, char flags) : file(name, h5_char_to_int(flags)) {}
 
-    file::file(const char *name, unsigned flags) {
+    file::file(const char *name, unsigned flags) { open(name, flags, H5P_DEFAULT); }
+
+#ifdef H5_HAVE_PARALLEL
+    file::file(std::string const &name, char flags, mpi::communicator c) {
+      proplist fapl = H5Pcreate(H5P_FILE_ACCESS);
+      if (H5Pset_fapl_mpio(fapl, c.get(), MPI_INFO_NULL) < 0) TRIQS_RUNTIME_ERROR << "HDF5 : cannot set the MPI-IO driver for the file " << name;
+      open(name.c_str(), h5_char_to_int(flags), fapl);
+    }
+#endif
+
+    void file::open(const char *name, unsigned flags, hid_t fapl) {
 
       if (flags == H5F_ACC_RDONLY) {
-        id = H5Fopen(name, flags, H5P_DEFAULT);
+        id = H5Fopen(name, flags, fapl);
         if (id < 0) TRIQS_RUNTIME_ERROR << "HDF5 : cannot open file " << name;
         return;
       }
 
       if (flags == H5F_ACC_RDWR) {
-        id = H5Fopen(name, flags, H5P_DEFAULT);
+        id = H5Fopen(name, flags, fapl);
         if (id < 0) {
-          id = H5Fcreate(name, H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
+          id = H5Fcreate(name, H5F_ACC_EXCL, H5P_DEFAULT, fapl);
           if (id < 0) TRIQS_RUNTIME_ERROR << "HDF5 : cannot open file " << name;
         }
         return;
       }
 
       if (flags == H5F_ACC_TRUNC) {
-        id = H5Fcreate(name, flags, H5P_DEFAULT, H5P_DEFAULT);
+        id = H5Fcreate(name, flags, H5P_DEFAULT, fapl);
         if (id < 0) TRIQS_RUNTIME_ERROR << "HDF5 : cannot create file " << name;
         return;
       }
 
       if (flags == H5F_ACC_EXCL) {
-        id = H5Fcreate(name, flags, H5P_DEFAULT, H5P_DEFAULT);
+        id = H5Fcreate(name, flags, H5P_DEFAULT, fapl);
         if (id < 0) TRIQS_RUNTIME_ERROR << "HDF5 : cannot create file " << name << ". Does it exists ?";
         return;
       }
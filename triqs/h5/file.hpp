@@ -20,6 +20,10 @@
  ******************************************************************************/
 #pragma once
 #include "./base_public.hpp"
+#include "./write_policy.hpp"
+#ifdef H5_HAVE_PARALLEL
+#include "../mpi/base.hpp"
+#endif
 
 namespace triqs {
   namespace h5 {
@@ -28,6 +32,9 @@ namespace triqs {
   *  \brief A little handler for the file
   */
     class file : public h5_object {
+      write_policy _policy;
+
+      void open(const char *name, unsigned flags, hid_t fapl);
 
       public:
       /**
@@ -55,12 +62,28 @@ namespace triqs {
       ///
       file(std::string const &name, char flags) : file(name.c_str(), flags) {}
 
+#ifdef H5_HAVE_PARALLEL
+      /**
+       * Open the file name with MPI-IO, on all the processes of c (collective). Flags as above.
+       * All the processes must then create the groups and datasets, and write the attributes, in the same way (collectively).
+       * The arrays distributed over the processes are written with h5_write_distributed.
+       * Only with a parallel HDF5 library.
+       */
+      file(std::string const &name, char flags, mpi::communicator c);
+#endif
+
       /// Internal : from an hdf5 id.
       file(hid_t id);
       file(h5_object obj);
 
       /// Name of the file
       std::string name() const;
+
+      /// The write policy of the arrays written in the file (unless changed in a group)
+      write_policy const &get_write_policy() const { return _policy; }
+
+      /// Change the write policy, cf write_policy
+      void set_write_policy(write_policy p) { _policy = p; }
     };
   } // namespace h5
 } // namespace triqs
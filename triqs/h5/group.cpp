@@ -4,7 +4,7 @@
 namespace triqs {
   namespace h5 {
 
-    group::group(h5::file f) : h5_object() {
+    group::group(h5::file f) : h5_object(), _policy(f.get_write_policy()) {
       id = H5Gopen2(f, "/", H5P_DEFAULT);
       if (id < 0) TRIQS_RUNTIME_ERROR << "Cannot open the root group / in the file " << f.name();
     }
@@ -56,7 +56,9 @@ namespace triqs {
       if (!has_key(key)) TRIQS_RUNTIME_ERROR << "no subgroup " << key << " in the group";
       hid_t sg = H5Gopen2(id, key.c_str(), H5P_DEFAULT);
       if (sg < 0) TRIQS_RUNTIME_ERROR << "Error in opening the subgroup " << key;
-      return group(sg);
+      group res(sg);
+      res._policy = _policy;
+      return res;
     }
 
     /// Open an existing DataSet. Throw if it does not exist.
@@ -72,7 +74,9 @@ namespace triqs {
       unlink_key_if_exists(key);
       hid_t id_g = H5Gcreate2(id, key.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
       if (id_g < 0) TRIQS_RUNTIME_ERROR << "Cannot create the subgroup " << key << " of the group" << name();
-      return group(id_g);
+      group res(id_g);
+      res._policy = _policy;
+      return res;
     }
 
     /**
@@ -29,6 +29,7 @@ namespace triqs {
   *  Rationale : use ADL for h5_read/h5_write, catch and rethrow exception, add some policy for opening/creating
   */
     class group : public h5_object {
+      write_policy _policy; // inherited by the subgroups
 
       public:
       group() = default; // for python converter only
@@ -53,6 +54,12 @@ namespace triqs {
       /// Name of the group
       std::string name() const;
 
+      /// The write policy of the arrays written in this group. The group opened from a file takes the policy of the file.
+      write_policy const &get_write_policy() const { return _policy; }
+
+      /// Change the write policy of this group, and of the subgroups opened or created from it later
+      void set_write_policy(write_policy p) { _policy = p; }
+
       /// Write the triqs tag
       void write_hdf5_scheme_as_string(const char *a);
 
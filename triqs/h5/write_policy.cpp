@@ -0,0 +1,57 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#include "./write_policy.hpp"
+#include <triqs/utility/exceptions.hpp>
+#include <algorithm>
+
+namespace triqs {
+  namespace h5 {
+
+    std::vector<hsize_t> chunk_dimensions(write_policy const &p, std::vector<hsize_t> const &max_dims, size_t element_size) {
+      int R = max_dims.size();
+      std::vector<hsize_t> c(R);
+      for (int i = 0; i < R; ++i) c[i] = std::max(max_dims[i], hsize_t(1));
+      if (p.chunk_bytes == 0) return c;
+
+      // From the last dimension, keep the full dimensions as long as the chunk fits,
+      // then take a slice of the next one, and 1 for the first ones.
+      hsize_t n = std::max(p.chunk_bytes / element_size, size_t(1)); // elements per chunk
+      int i     = R - 1;
+      for (; i >= 0 and c[i] <= n; --i) n /= c[i];
+      if (i >= 0) c[i] = std::max(n, hsize_t(1));
+      for (int j = i - 1; j >= 0; --j) c[j] = 1;
+      return c;
+    }
+
+    proplist dataset_create_proplist(write_policy const &p, std::vector<hsize_t> const &max_dims, size_t element_size, bool chunked) {
+      if (p.deflate_level < 0 or p.deflate_level > 9) TRIQS_RUNTIME_ERROR << "h5 : deflate level " << p.deflate_level << " not in [0, 9]";
+      proplist cparms = H5Pcreate(H5P_DATASET_CREATE);
+      // the filters require a chunked dataset
+      if (!chunked and p.deflate_level == 0 and !p.shuffle and p.chunk_bytes == 0) return cparms;
+      auto c = chunk_dimensions(p, max_dims, element_size);
+      H5Pset_chunk(cparms, c.size(), c.data());
+      if (p.shuffle) H5Pset_shuffle(cparms);
+      if (p.deflate_level > 0) H5Pset_deflate(cparms, p.deflate_level);
+      return cparms;
+    }
+
+  } // namespace h5
+} // namespace triqs
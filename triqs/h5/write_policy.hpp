@@ -0,0 +1,68 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include "./base_public.hpp"
+#include <vector>
+
+namespace triqs {
+  namespace h5 {
+
+    /**
+     * How the arrays are written : compression and chunking of the datasets
+     *
+     * Set on a file or a group (set_write_policy), it is used for all the arrays written in it,
+     * and inherited by its subgroups. The default is a single chunk compressed with deflate level 8.
+     */
+    struct write_policy {
+      /// Deflate (gzip) compression level, 0 (no compression) to 9
+      int deflate_level = 8;
+
+      /// Apply the shuffle filter before the compression (often better compression of floating point data)
+      bool shuffle = false;
+
+      /**
+       * Target size of a chunk in bytes, e.g. 1 << 20.
+       * 0 : one chunk for the whole array. Smaller chunks allow to read a part of a large array without decompressing it all.
+       */
+      size_t chunk_bytes = 0;
+
+      /// No compression : the arrays are written contiguously (unless chunk_bytes is set), the fastest
+      static write_policy no_compression() { return {0, false, 0}; }
+
+      /// Compressed with deflate and shuffle filters, in chunks of about 1 MB
+      static write_policy compressed(int level = 4) { return {level, true, 1ul << 20}; }
+    };
+
+    /**
+     * The chunk dimensions for a dataset of dimensions dims (at most max_dims), with elements of element_size bytes.
+     * The chunks contain the full last dimensions, and as much of the first one (in C order) as fit in p.chunk_bytes.
+     * If p.chunk_bytes == 0, they are max_dims (0 replaced by 1).
+     */
+    std::vector<hsize_t> chunk_dimensions(write_policy const &p, std::vector<hsize_t> const &max_dims, size_t element_size);
+
+    /**
+     * The dataset creation property list implementing p, for a dataset of dimensions max_dims.
+     * chunked : the dataset must be chunked (e.g. extendible), even without compression.
+     */
+    proplist dataset_create_proplist(write_policy const &p, std::vector<hsize_t> const &max_dims, size_t element_size, bool chunked = false);
+
+  } // namespace h5
+} // namespace triqs
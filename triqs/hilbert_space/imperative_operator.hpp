@@ -146,10 +146,28 @@ namespace triqs {
         return StateType(st.get_hilbert());
       }
 
+      // Same as get_target_st, but reuses the storage of target_st. Returns false if st is mapped to no subspace.
+      template <typename StateType> bool reset_target_st(StateType const &st, StateType &target_st, std::true_type use_map) const {
+        auto n = hilbert_map[st.get_hilbert().get_index()];
+        if (n == -1) {
+          target_st = StateType{};
+          return false;
+        }
+        target_st.set_hilbert((*sub_spaces)[n]);
+        target_st.clear();
+        return true;
+      }
+
+      template <typename StateType> bool reset_target_st(StateType const &st, StateType &target_st, std::false_type use_map) const {
+        target_st.set_hilbert(st.get_hilbert());
+        target_st.clear();
+        return true;
+      }
+
       static bool parity_number_of_bits(uint64_t v) {
         // http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetNaive
-        // v ^= v >> 16;
-        // only ok until 16 orbitals ! assert this or put the >> 16
+        v ^= v >> 32;
+        v ^= v >> 16;
         v ^= v >> 8;
         v ^= v >> 4;
         v ^= v >> 2;
@@ -157,6 +175,17 @@ namespace triqs {
         return v & 0x01;
       }
 
+      // Call l(f3, M, sign_is_minus) for each monomial M mapping the Fock state f1 to the Fock state f3
+      template <typename Lambda> void foreach_term(fock_state_t f1, Lambda &&l) const {
+        for (auto const &M : all_terms) {
+          if ((f1 & M.d_mask) != M.d_mask) continue;
+          fock_state_t f2 = f1 & ~M.d_mask;
+          if (((f2 ^ M.dag_mask) & M.dag_mask) != M.dag_mask) continue;
+          fock_state_t f3 = ~(~f2 & ~M.dag_mask);
+          l(f3, M, parity_number_of_bits((f2 & M.d_count_mask) ^ (f3 & M.dag_count_mask)));
+        }
+      }
+
       // Forward the call to the coefficient
 #ifdef GCC_BUG_41933_WORKAROUND
       template <typename... Args>
@@ -188,9 +217,44 @@ namespace triqs {
    @param args Optional argument pack passed to each coefficient of the operator
   */
       template <typename StateType, typename... Args> StateType operator()(StateType const &st, Args &&... args) const {
-
         StateType target_st = get_target_st(st, std::integral_constant<bool, UseMap>());
-        auto const &hs      = st.get_hilbert();
+        add_terms(st, target_st, std::forward<Args>(args)...);
+        return target_st;
+      }
+
+      /// Act on a state, and put the result into another state
+      /**
+   Same as `operator()`, but the result overwrites `target_st` : its memory is reused,
+   so that no allocation occurs when an operator is applied to many states in a loop.
+
+   @tparam StateType Type of the initial state
+   @tparam Args Types of the optional arguments
+   @param st Initial state
+   @param target_st State receiving the result (must not be `st`)
+   @param args Optional argument pack passed to each coefficient of the operator
+  */
+      template <typename StateType, typename... Args> void act(StateType const &st, StateType &target_st, Args &&... args) const {
+        if (reset_target_st(st, target_st, std::integral_constant<bool, UseMap>())) add_terms(st, target_st, std::forward<Args>(args)...);
+      }
+
+      /// Apply a callable object to the Fock states connected to a given Fock state by the monomials of the operator
+      /**
+   The callable must take two arguments, 1) a Fock state `f`, and 2) the matrix element `<f|M|fs>`
+   of a monomial `M` of the operator. Several monomials can give the same `f` : their matrix elements must be added.
+   No state is involved, so it can be called concurrently. Only for `ScalarType` being a number.
+
+   @tparam Lambda Type of the callable object
+   @param fs Initial Fock state
+   @param l Callable object
+  */
+      template <typename Lambda> void foreach_transition(fock_state_t fs, Lambda l) const {
+        foreach_term(fs, [&l](fock_state_t f, one_term_t const &M, bool sign_is_minus) { l(f, (sign_is_minus ? -M.coeff : M.coeff)); });
+      }
+
+      private:
+      // target_st += (*this)(st)
+      template <typename StateType, typename... Args> void add_terms(StateType const &st, StateType &target_st, Args &&... args) const {
+        auto const &hs = st.get_hilbert();
 
 #ifdef GCC_BUG_41933_WORKAROUND
         auto args_tuple = std::make_tuple(args...);
@@ -198,19 +262,14 @@ namespace triqs {
 
         using amplitude_t = typename StateType::value_type;
 
-        for (int i = 0; i < all_terms.size(); ++i) { // loop over monomials
-          auto M = all_terms[i];
+        // A single pass over the amplitudes of st (with a single prune of a map-based state), the monomials in the inner loop
 #ifdef GCC_BUG_41933_WORKAROUND
-          foreach (st, [M, &target_st, hs, args_tuple](int i, typename StateType::value_type amplitude) {
+        foreach (st, [this, &target_st, &hs, args_tuple](int i, amplitude_t amplitude) {
 #else
-          foreach (st, [M, &target_st, hs, args...](int i, typename StateType::value_type amplitude) {
+        foreach (st, [this, &target_st, &hs, args...](int i, amplitude_t amplitude) {
 #endif
-            fock_state_t f2 = hs.get_fock_state(i);
-            if ((f2 & M.d_mask) != M.d_mask) return;
-            f2 &= ~M.d_mask;
-            if (((f2 ^ M.dag_mask) & M.dag_mask) != M.dag_mask) return;
-            fock_state_t f3    = ~(~f2 & ~M.dag_mask);
-            auto sign_is_minus = parity_number_of_bits((f2 & M.d_count_mask) ^ (f3 & M.dag_count_mask));
+          if (amplitude == amplitude_t(0)) return;
+          foreach_term(hs.get_fock_state(i), [&](fock_state_t f3, one_term_t const &M, bool sign_is_minus) {
             // update state vector in target Hilbert space
             auto ind = target_st.get_hilbert().get_state_index(f3);
 #ifdef GCC_BUG_41933_WORKAROUND
@@ -218,10 +277,9 @@ namespace triqs {
 #else
             target_st(ind) += amplitude * apply_if_possible(M.coeff, args...) * (sign_is_minus ? -amplitude_t(1) : amplitude_t(1));
 #endif
-          })
-            ; // foreach
-        }
-        return target_st;
+          });
+        })
+          ; // foreach
       }
     };
   } // namespace hilbert_space
@@ -21,15 +21,105 @@
 
 #pragma once
 
-#include <set>
+#include <algorithm>
 #include <map>
+#include <numeric>
+#include <set>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include <triqs/utility/numeric_ops.hpp>
-#include <boost/pending/disjoint_sets.hpp>
+#include "./hilbert_space.hpp"
+#include "./state.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace triqs {
   namespace hilbert_space {
 
+    namespace detail {
+
+      /// Disjoint sets of [0, n) (union-find) : the representative of a set is its smallest element
+      class union_find {
+        std::vector<uint32_t> parent;
+
+        public:
+        union_find(uint32_t n = 0) : parent(n) { std::iota(parent.begin(), parent.end(), 0); }
+
+        /// Representative of the set of x, with path halving
+        uint32_t find(uint32_t x) {
+          while (parent[x] != x) x = parent[x] = parent[parent[x]];
+          return x;
+        }
+
+        /// Representative of the set of x, without modification (can be called concurrently)
+        uint32_t find(uint32_t x) const {
+          while (parent[x] != x) x = parent[x];
+          return x;
+        }
+
+        /// Union of the sets of x and y
+        void link(uint32_t x, uint32_t y) {
+          x = find(x);
+          y = find(y);
+          if (x < y)
+            parent[y] = x;
+          else if (y < x)
+            parent[x] = y;
+        }
+
+        /// Make all elements point directly to their representative
+        void compress() {
+          // parent[x] <= x : parent[parent[x]] is already a representative
+          for (uint32_t x = 0; x < parent.size(); ++x) parent[x] = parent[parent[x]];
+        }
+      };
+
+      // Detects imperative_operator::foreach_transition
+      struct ignore_transition {
+        template <typename T> void operator()(fock_state_t, T const &) const {}
+      };
+      template <typename Op, typename = void> struct has_foreach_transition : std::false_type {};
+      template <typename Op>
+      struct has_foreach_transition<Op, std::void_t<decltype(std::declval<Op const &>().foreach_transition(fock_state_t{}, ignore_transition{}))>>
+         : std::true_type {};
+
+      /// Minimal number of basis states for a parallel partition
+      constexpr uint32_t parallel_partition_threshold = 4096;
+
+      /// Number of links buffered by a thread before it adds them to the shared union-find
+      constexpr size_t partition_link_buffer_size = 1 << 14;
+
+      /**
+       * Non-vanishing matrix elements ((from-state, to-state), value), sorted by (from-state, to-state)
+       *
+       * A flat array. For the code written for the std::map of the previous versions, it provides find and count,
+       * and converts (deprecated) to this std::map.
+       */
+      template <typename Index, typename Amplitude> struct matrix_element_array : std::vector<std::pair<std::pair<Index, Index>, Amplitude>> {
+        using key_type    = std::pair<Index, Index>;
+        using mapped_type = Amplitude;
+        using base_t      = std::vector<std::pair<key_type, Amplitude>>;
+        using base_t::base_t;
+
+        /// The element of key k, or end(), by binary search
+        typename base_t::const_iterator find(key_type const &k) const {
+          auto it = std::lower_bound(this->begin(), this->end(), k, [](auto const &x, key_type const &y) { return x.first < y; });
+          return (it != this->end() and it->first == k ? it : this->end());
+        }
+
+        /// 1 if there is an element of key k, 0 otherwise
+        size_t count(key_type const &k) const { return find(k) != this->end(); }
+
+        [[deprecated("matrix_element_map_t is now a flat array sorted by (from-state, to-state) : iterate on it or use find")]] operator std::map<
+           key_type, Amplitude>() const {
+          return {this->begin(), this->end()};
+        }
+      };
+
+    } // namespace detail
+
     /// Implementation of the automatic partitioning algorithm
     /**
   Partitions a Hilbert space into a set of subspaces invariant under action of a given Hermitian operator (Hamiltonian).
@@ -37,8 +127,16 @@ namespace triqs {
   For a detailed description of the algorithm see
   `Computer Physics Communications 200, March 2016, 274-284 <http://dx.doi.org/10.1016/j.cpc.2015.10.023>`_ (section 4.2).
 
+  The subspaces are the sets of a union-find structure on the indices of the basis Fock states.
+  If the operators provide `foreach_transition` (as [[imperative_operator]] does), the connections
+  of a basis state are computed from its Fock state bitmask and the masks of the monomials of the operator,
+  without any state : the basis states are then processed in parallel (OpenMP) by ranges.
+  Each thread buffers a bounded number of links, which it adds to the union-find in a critical section.
+
   @tparam StateType Many-body state type, must model [[statevector_concept]]
-  @tparam OperatorType Imperative operator type, must provide `StateType operator()(StateType const&)`
+  @tparam OperatorType Imperative operator type, must provide `StateType operator()(StateType const&)`.
+                      If it also provides `void act(StateType const&, StateType &)` (as [[imperative_operator]] does),
+                      the temporary states are reused instead of being allocated for each basis state.
  */
     template <typename StateType, typename OperatorType> class space_partition {
 
@@ -53,8 +151,8 @@ namespace triqs {
       using amplitude_t = typename state_t::value_type;
       /// Connections between subspaces represented as a set of (from-index,to-index) pair
       using block_mapping_t = std::set<std::pair<index_t, index_t>>;
-      /// Non-zero matrix elements of an operator represented as a mapping (from-state,to-state) -> value
-      using matrix_element_map_t = std::map<std::pair<index_t, index_t>, typename state_t::value_type>;
+      /// Non-zero matrix elements of an operator represented as a flat array of ((from-state,to-state), value), sorted by (from-state,to-state)
+      using matrix_element_map_t = detail::matrix_element_array<index_t, amplitude_t>;
 
       /// Perform Phase I of the automatic partition algorithm
       /**
@@ -65,28 +163,33 @@ namespace triqs {
    @param store_matrix_elements Should we store the non-vanishing matrix elements of the Hamiltonian?
   */
       space_partition(state_t const &st, operator_t const &H, bool store_matrix_elements = true)
-         : tmp_state(make_zero_state(st)), subspaces(st.size()) {
-        auto size = tmp_state.size();
-
-        // Iteration over all initial basis states
-        for (index_t i = 0; i < size; ++i) {
-          tmp_state(i)        = amplitude_t(1);
-          state_t final_state = H(tmp_state);
-
-          // Iterate over non-zero final amplitudes
-          foreach (final_state, [&](index_t f, amplitude_t amplitude) {
-            using triqs::utility::is_zero;
-            if (is_zero(amplitude)) return;
-            auto i_subspace = subspaces.find_set(i);
-            auto f_subspace = subspaces.find_set(f);
-            if (i_subspace != f_subspace) subspaces.link(i_subspace, f_subspace);
-
-            if (store_matrix_elements) matrix_elements[std::make_pair(i, f)] = amplitude;
-          })
-            ;
-          tmp_state(i) = amplitude_t(0.);
-        }
+         : tmp_state(make_zero_state(st)), final_state(make_zero_state(st)), subspaces(st.size()) {
+
+        int n_ranges = get_n_ranges();
+        std::vector<matrix_element_map_t> range_elements(n_ranges);
+
+        // Iteration over all initial basis states, by ranges.
+        // The subspaces do not depend on the order of the links : the representative of a set is its smallest element.
+        foreach_range(n_ranges, [&](int r, index_t i_begin, index_t i_end) {
+          transition_list_t transitions;
+          std::vector<std::pair<index_t, index_t>> links;
+          auto flush_links = [&]() {
+#pragma omp critical(space_partition_link)
+            for (auto const &[i, f] : links) subspaces.link(i, f);
+            links.clear();
+          };
+          for (index_t i = i_begin; i < i_end; ++i) {
+            get_transitions(H, i, transitions, store_matrix_elements);
+            for (auto const &[f, amplitude] : transitions.list) {
+              if (f != i) links.emplace_back(i, f);
+              if (store_matrix_elements) range_elements[r].push_back({{i, f}, amplitude});
+            }
+            if (links.size() >= detail::partition_link_buffer_size) flush_links();
+          }
+          flush_links();
+        });
 
+        matrix_elements = concatenate(range_elements);
         _update_index();
       }
 
@@ -106,84 +209,82 @@ namespace triqs {
       std::pair<matrix_element_map_t, matrix_element_map_t> merge_subspaces(operator_t const &Cd, operator_t const &C,
                                                                             bool store_matrix_elements = true) {
 
-        matrix_element_map_t Cd_elements, C_elements;
-        std::multimap<index_t, index_t> Cd_connections, C_connections;
-
-        auto size = tmp_state.size();
-
-        // Fill connection multimaps
-        for (index_t i = 0; i < size; ++i) {
-          tmp_state(i)    = amplitude_t(1);
-          auto i_subspace = subspaces.find_set(i);
-
-          auto fill_conn = [this, i, i_subspace, store_matrix_elements](operator_t const &op, std::multimap<index_t, index_t> &conn,
-                                                                        matrix_element_map_t &elem) {
-            state_t final_state = op(tmp_state);
-            // Iterate over non-zero final amplitudes
-            foreach (final_state, [&](index_t f, amplitude_t amplitude) {
-              using triqs::utility::is_zero;
-              if (is_zero(amplitude)) return;
-              auto f_subspace = subspaces.find_set(f);
-              conn.insert({i_subspace, f_subspace});
-              if (store_matrix_elements) elem[{i, f}] = amplitude;
-            })
-              ;
+        using connections_t = std::vector<std::pair<index_t, index_t>>; // sorted (from-subspace,to-subspace)
+        int n_ranges        = get_n_ranges();
+        std::vector<connections_t> Cd_range_conn(n_ranges), C_range_conn(n_ranges);
+        std::vector<matrix_element_map_t> Cd_range_elements(n_ranges), C_range_elements(n_ranges);
+
+        // Fill the connections. The subspaces are not modified (the union-find is compressed) : read concurrently.
+        foreach_range(n_ranges, [&](int r, index_t i_begin, index_t i_end) {
+          transition_list_t transitions;
+          auto fill_conn = [&](operator_t const &op, index_t i, connections_t &conn, matrix_element_map_t &elem) {
+            auto i_subspace = subspaces_c().find(i);
+            get_transitions(op, i, transitions, store_matrix_elements);
+            for (auto const &[f, amplitude] : transitions.list) {
+              conn.emplace_back(i_subspace, subspaces_c().find(f));
+              if (store_matrix_elements) elem.push_back({{i, f}, amplitude});
+            }
           };
-
-          fill_conn(Cd, Cd_connections, Cd_elements);
-          fill_conn(C, C_connections, C_elements);
-
-          tmp_state(i) = amplitude_t(0.);
-        }
+          for (index_t i = i_begin; i < i_end; ++i) {
+            fill_conn(Cd, i, Cd_range_conn[r], Cd_range_elements[r]);
+            fill_conn(C, i, C_range_conn[r], C_range_elements[r]);
+          }
+        });
+
+        auto sorted_connections = [](std::vector<connections_t> &range_conn) {
+          auto conn = concatenate(range_conn);
+          std::sort(conn.begin(), conn.end());
+          conn.erase(std::unique(conn.begin(), conn.end()), conn.end());
+          return conn;
+        };
+        connections_t Cd_connections = sorted_connections(Cd_range_conn), C_connections = sorted_connections(C_range_conn);
+        std::vector<bool> Cd_visited(Cd_connections.size(), false), C_visited(C_connections.size(), false);
 
         // 'Zigzag' traversal algorithm
-        while (!Cd_connections.empty()) {
+        std::vector<std::pair<index_t, bool>> to_visit; // (subspace, direction of the connections to follow)
+        for (size_t k = 0; k < Cd_connections.size(); ++k) {
+          if (Cd_visited[k]) continue;
 
           // Take one C^+ - connection
           // C^+|lower_subspace> = |upper_subspace>
-          index_t lower_subspace, upper_subspace;
-          std::tie(lower_subspace, upper_subspace) = *std::begin(Cd_connections);
+          index_t lower_subspace = Cd_connections[k].first, upper_subspace = Cd_connections[k].second;
 
           // - Reveals all subspaces reachable from lower_subspace by application of
           //   a 'zigzag' product C^+ C C^+ C C^+ ... of any length.
-          // - Removes all visited connections from Cd_connections/C_connections.
+          // - Marks all visited connections of Cd_connections/C_connections.
           // - Merges lower_subspace with all subspaces generated from lower_subspace by application of (C C^+)^(2*n).
           // - Merges upper_subspace with all subspaces generated from upper_subspace by application of (C^+ C)^(2*n).
-          std::function<void(index_t, bool)> zigzag_traversal = [this, lower_subspace, upper_subspace, &Cd_connections, &C_connections,
-                                                                 &zigzag_traversal](
-                                                                   index_t i_subspace, // find all connections starting from i_subspace
-                                                                   bool upwards        // if true, C^+ connection, otherwise C connection
-                                                                ) {
-            std::multimap<index_t, index_t>::iterator it;
-            while ((it = (upwards ? Cd_connections : C_connections).find(i_subspace)) != (upwards ? Cd_connections : C_connections).end()) {
-
+          // Iterative, with to_visit : (i_subspace, upwards) = find all connections starting from i_subspace,
+          // C^+ connections if upwards, otherwise C connections.
+          to_visit.assign(1, {lower_subspace, true});
+          while (!to_visit.empty()) {
+            auto [i_subspace, upwards] = to_visit.back();
+            to_visit.pop_back();
+            auto &conn    = (upwards ? Cd_connections : C_connections);
+            auto &visited = (upwards ? Cd_visited : C_visited);
+            for (auto it = std::lower_bound(conn.begin(), conn.end(), std::make_pair(i_subspace, index_t(0)));
+                 it != conn.end() and it->first == i_subspace; ++it) {
+              auto n = it - conn.begin();
+              if (visited[n]) continue;
+              visited[n]      = true;
               auto f_subspace = it->second;
-              (upwards ? Cd_connections : C_connections).erase(it);
-
-              if (upwards)
-                subspaces.link(f_subspace, upper_subspace);
-              else
-                subspaces.link(f_subspace, lower_subspace);
-
-              // Recursively apply to all found f_subspace's with a 'flipped' direction
-              zigzag_traversal(f_subspace, !upwards);
+              subspaces.link(f_subspace, (upwards ? upper_subspace : lower_subspace));
+              // Continue from f_subspace with a 'flipped' direction
+              to_visit.emplace_back(f_subspace, !upwards);
             }
-          };
-
-          // Apply to all C^+ connections starting from lower_subspace
-          zigzag_traversal(lower_subspace, true);
+          }
         }
 
         _update_index();
 
-        return std::make_pair(Cd_elements, C_elements);
+        return std::make_pair(concatenate(Cd_range_elements), concatenate(C_range_elements));
       }
 
       /// Return the number of subspaces in the partition
       /**
    @return Number of invariant subspaces
   */
-      index_t n_subspaces() const { return representative_to_index.size(); }
+      index_t n_subspaces() const { return _n_subspaces; }
 
       /// Apply a callable object to all basis Fock states in a given space partition
       /**
@@ -203,7 +304,7 @@ namespace triqs {
    @param basis_state Index of a basis Fock state
    @return Index of the found invariant subspace
   */
-      index_t lookup_basis_state(index_t basis_state) { return representative_to_index[subspaces.find_set(basis_state)]; }
+      index_t lookup_basis_state(index_t basis_state) const { return representative_to_index[subspaces_c().find(basis_state)]; }
 
       /// Access to matrix elements of the Hamiltonian
       /**
@@ -219,51 +320,121 @@ namespace triqs {
   */
       block_mapping_t find_mappings(operator_t const &op, bool diagonal_only = false) {
 
+        int n_ranges = get_n_ranges();
+        std::vector<std::vector<std::pair<index_t, index_t>>> range_mapping(n_ranges);
+
+        // Iteration over all initial basis states, by ranges
+        foreach_range(n_ranges, [&](int r, index_t i_begin, index_t i_end) {
+          transition_list_t transitions;
+          for (index_t i = i_begin; i < i_end; ++i) {
+            auto i_subspace = subspaces_c().find(i);
+            get_transitions(op, i, transitions, false);
+            for (auto const &tr : transitions.list) {
+              auto f_subspace = subspaces_c().find(tr.first);
+              if ((!diagonal_only) || i_subspace == f_subspace)
+                range_mapping[r].emplace_back(representative_to_index[i_subspace], representative_to_index[f_subspace]);
+            }
+          }
+        });
+
         block_mapping_t mapping;
+        for (auto const &m : range_mapping) mapping.insert(m.begin(), m.end());
+        return mapping;
+      }
+
+      private:
+      static constexpr bool use_fock_bitmask = detail::has_foreach_transition<operator_t>::value;
+
+      // Transitions from a basis state : an accumulator of the amplitudes, and the list of the non-vanishing ones
+      struct transition_list_t {
+        detail::amplitude_table<amplitude_t> acc;
+        std::vector<std::pair<index_t, amplitude_t>> list;
+      };
+
+      detail::union_find const &subspaces_c() const { return subspaces; }
+
+      // Number of ranges of basis states processed in parallel
+      int get_n_ranges() const {
+#ifdef _OPENMP
+        if (use_fock_bitmask and tmp_state.size() >= detail::parallel_partition_threshold and omp_get_max_threads() > 1 and !omp_in_parallel())
+          return omp_get_max_threads();
+#endif
+        return 1;
+      }
 
-        // Iteration over all initial basis states
-        for (index_t i = 0; i < tmp_state.size(); ++i) {
-          state_t initial_state = tmp_state;
-          initial_state(i)      = amplitude_t(1);
-          auto i_subspace       = subspaces.find_set(i);
+      // Call f(r, i_begin, i_end) for the ranges r = 0, ..., n_ranges - 1 of basis states [i_begin, i_end[, in parallel
+      template <typename F> void foreach_range(int n_ranges, F &&f) const {
+        long size = tmp_state.size();
+#pragma omp parallel for schedule(static, 1) if (n_ranges > 1)
+        for (int r = 0; r < n_ranges; ++r) f(r, index_t(size * r / n_ranges), index_t(size * (r + 1) / n_ranges));
+      }
 
-          state_t final_state = op(initial_state);
+      // The ranges are consecutive : the concatenation of sorted results is sorted
+      template <typename V> static V concatenate(std::vector<V> &v) {
+        if (v.size() == 1) return std::move(v[0]);
+        size_t n = 0;
+        for (auto const &x : v) n += x.size();
+        V res;
+        res.reserve(n);
+        for (auto &x : v) {
+          res.insert(res.end(), x.begin(), x.end());
+          V{}.swap(x);
+        }
+        return res;
+      }
 
+      // Non-vanishing amplitudes (final basis state, amplitude) of op acting on the basis state i, sorted by final state if sorted = true
+      void get_transitions(operator_t const &op, index_t i, transition_list_t &tr, bool sorted) const {
+        using triqs::utility::is_zero;
+        tr.list.clear();
+        if constexpr (use_fock_bitmask) {
+          // Several monomials can lead to the same final state : add their amplitudes
+          auto const &hs = tmp_state.get_hilbert();
+          tr.acc.clear();
+          op.foreach_transition(hs.get_fock_state(i), [&tr, &hs](fock_state_t f, amplitude_t x) { tr.acc[hs.get_state_index(f)] += x; });
+          for (auto const &[f, amplitude] : tr.acc)
+            if (!is_zero(amplitude)) tr.list.emplace_back(f, amplitude);
+        } else {
+          tmp_state(i) = amplitude_t(1);
+          apply_to_tmp_state(op, 0);
+          tmp_state(i) = amplitude_t(0.);
           // Iterate over non-zero final amplitudes
-          foreach (final_state, [&](index_t f, amplitude_t amplitude) {
-            using triqs::utility::is_zero;
-            if (is_zero(amplitude)) return;
-            auto f_subspace = subspaces.find_set(f);
-            if ((!diagonal_only) || i_subspace == f_subspace)
-              mapping.insert(std::make_pair(representative_to_index[i_subspace], representative_to_index[f_subspace]));
+          foreach (final_state, [&tr](index_t f, amplitude_t amplitude) {
+            if (!is_zero(amplitude)) tr.list.emplace_back(f, amplitude);
           })
             ;
         }
+        if (sorted) std::sort(tr.list.begin(), tr.list.end(), [](auto const &a, auto const &b) { return a.first < b.first; });
+      }
 
-        return mapping;
+      // final_state = op(tmp_state), reusing the memory of final_state if op has an act method
+      template <typename Op>
+      auto apply_to_tmp_state(Op const &op, int) const -> decltype(op.act(std::declval<state_t const &>(), std::declval<state_t &>()), void()) {
+        op.act(tmp_state, final_state);
       }
+      template <typename Op> void apply_to_tmp_state(Op const &op, long) const { final_state = op(tmp_state); }
 
-      private:
       void _update_index() {
-        auto p = subspaces.parents();
-        subspaces.compress_sets(p.begin(), p.end());  // parents are representatives
-        subspaces.normalize_sets(p.begin(), p.end()); // the representative has the smallest index in the set
+        subspaces.compress(); // all elements point to their representative, the smallest index in the set
 
         // Update representative_to_index
-        representative_to_index.clear();
-        for (index_t n = 0; n < tmp_state.size(); ++n) {
-          representative_to_index.insert(std::make_pair(subspaces.find_set(n), representative_to_index.size()));
-        }
+        index_t size = tmp_state.size();
+        representative_to_index.assign(size, 0);
+        _n_subspaces = 0;
+        for (index_t n = 0; n < size; ++n)
+          if (subspaces_c().find(n) == n) representative_to_index[n] = _n_subspaces++;
       }
 
-      // Temporary zero state
-      mutable state_t tmp_state;
+      // Temporary states : a basis state and the result of an operator acting on it
+      mutable state_t tmp_state, final_state;
       // Subspaces
-      boost::disjoint_sets_with_storage<> subspaces;
+      detail::union_find subspaces;
       // Matrix elements of the Hamiltonian
       matrix_element_map_t matrix_elements;
-      // Map representative basis state to subspace index
-      std::map<index_t, index_t> representative_to_index;
+      // Map representative basis state to subspace index (only meaningful for the representatives)
+      std::vector<index_t> representative_to_index;
+      // Number of subspaces
+      index_t _n_subspaces = 0;
     };
   } // namespace hilbert_space
 } // namespace triqs
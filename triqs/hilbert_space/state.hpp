@@ -20,8 +20,10 @@
  ******************************************************************************/
 #pragma once
 #include <algorithm>
-#include <unordered_map>
 #include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
 #include <boost/operators.hpp>
 #include <triqs/utility/numeric_ops.hpp>
 #include <triqs/arrays.hpp>
@@ -63,10 +65,120 @@ namespace triqs {
       return {st.get_hilbert()};
     }
 
+    namespace detail {
+
+      /// Flat hash table index -> amplitude, used by the map-based state
+      /**
+  The (index, amplitude) entries are stored contiguously in insertion order,
+  and an open-addressing table (linear probing, power-of-2 capacity) holds their positions.
+  Unlike a node-based map, an insertion does not allocate (except when the table grows),
+  and `clear` keeps the memory, so that a state can be reused in a loop.
+  */
+      template <typename T> class amplitude_table {
+        public:
+        using entry_t = std::pair<std::size_t, T>;
+
+        private:
+        static constexpr uint32_t empty = ~uint32_t(0);
+        std::vector<entry_t> entries;
+        std::vector<uint32_t> slots; // position of the entry in entries, or empty
+        int shift = 0;               // 64 - log2(slots.size())
+
+        // Fibonacci hashing : the Fock state indices are far from random
+        std::size_t first_slot(std::size_t key) const { return (uint64_t(key) * 0x9E3779B97F4A7C15ull) >> shift; }
+
+        // Position of key in slots : either its entry or the empty slot where it should be inserted
+        std::size_t find_slot(std::size_t key) const {
+          std::size_t mask = slots.size() - 1;
+          for (auto s = first_slot(key);; s = (s + 1) & mask)
+            if (slots[s] == empty or entries[slots[s]].first == key) return s;
+        }
+
+        void index_all() {
+          for (uint32_t n = 0; n < entries.size(); ++n) slots[find_slot(entries[n].first)] = n;
+        }
+
+        // Mark all slots empty : O(number of entries) when the table is sparse
+        void unindex_all() {
+          if (4 * entries.size() >= slots.size()) {
+            std::fill(slots.begin(), slots.end(), empty);
+            return;
+          }
+          std::size_t mask = slots.size() - 1;
+          for (uint32_t n = 0; n < entries.size(); ++n) {
+            auto s = first_slot(entries[n].first);
+            while (slots[s] != n) s = (s + 1) & mask; // do not stop at the slots already emptied
+            slots[s] = empty;
+          }
+        }
+
+        void rehash(std::size_t n_slots) {
+          slots.assign(n_slots, empty);
+          shift = 64;
+          while (n_slots > 1) {
+            n_slots >>= 1;
+            --shift;
+          }
+          index_all();
+        }
+
+        public:
+        /// Make room for n entries without rehashing
+        void reserve(std::size_t n) {
+          entries.reserve(n);
+          std::size_t n_slots = 16;
+          while (n_slots < 2 * n) n_slots *= 2;
+          if (n_slots > slots.size()) rehash(n_slots);
+        }
+
+        /// Number of stored entries (including the vanishing ones)
+        std::size_t size() const { return entries.size(); }
+
+        /// Pointer to the value stored for key, or nullptr
+        T const *find(std::size_t key) const {
+          if (entries.empty()) return nullptr;
+          auto n = slots[find_slot(key)];
+          return (n == empty ? nullptr : &entries[n].second);
+        }
+
+        /// Value stored for key, inserted as 0 if absent
+        T &operator[](std::size_t key) {
+          if (2 * (entries.size() + 1) > slots.size()) rehash(std::max<std::size_t>(16, 2 * slots.size()));
+          auto s = find_slot(key);
+          if (slots[s] == empty) {
+            slots[s] = entries.size();
+            entries.emplace_back(key, T(0));
+          }
+          return entries[slots[s]].second;
+        }
+
+        /// Remove all entries, keeping the memory
+        void clear() {
+          unindex_all();
+          entries.clear();
+        }
+
+        /// Remove the entries for which pred(value) is true, keeping the order of the others
+        template <typename Pred> void remove_if(Pred pred) {
+          auto it = std::find_if(entries.begin(), entries.end(), [&pred](entry_t const &e) { return pred(e.second); });
+          if (it == entries.end()) return;
+          unindex_all();
+          entries.erase(std::remove_if(it, entries.end(), [&pred](entry_t const &e) { return pred(e.second); }), entries.end());
+          index_all();
+        }
+
+        auto begin() const { return entries.cbegin(); }
+        auto end() const { return entries.cend(); }
+        auto begin() { return entries.begin(); }
+        auto end() { return entries.end(); }
+      };
+    } // namespace detail
+
     /// State: implementation based on a map
     /**
   This specialization can work well on huge Hilbert spaces, as long as there are not
   too many non-vanishing amplitudes  in the state.
+  The amplitudes are stored in a flat open-addressing hash table, whose memory is kept by `clear`.
 
   @tparam HilbertSpace Hilbert space type, one of [[hilbert_space]] and [[sub_hilbert_space]]
   @tparam ScalarType Amplitude type, normally `double` or `std::complex<double>`
@@ -77,7 +189,7 @@ namespace triqs {
                                                   boost::multiplicative<state<HilbertSpace, ScalarType, true>, ScalarType> {
       // derivations implement the vector space operations over ScalarType from the compounds operators +=, *=, ....
       const HilbertSpace *hs_p;
-      using amplitude_t = std::unordered_map<std::size_t, ScalarType>;
+      using amplitude_t = detail::amplitude_table<ScalarType>;
       amplitude_t ampli;
 
       public:
@@ -112,9 +224,13 @@ namespace triqs {
       /// Access to individual amplitudes
       /**
    @param i index of the requested amplitude
-   @return Constant reference to the requested amplitude
+   @return Constant reference to the requested amplitude (0 if it is not stored)
   */
-      value_type const &operator()(int i) const { return ampli[i]; }
+      value_type const &operator()(int i) const {
+        static const value_type zero = value_type(0);
+        auto p                       = ampli.find(i);
+        return (p ? *p : zero);
+      }
 
       /// In-place addition of another state
       /**
@@ -122,10 +238,7 @@ namespace triqs {
    @return Reference to this state
   */
       state &operator+=(state const &s2) {
-        for (auto const &aa : s2.ampli) {
-          auto r = ampli.insert(aa);
-          if (!r.second) r.first->second += aa.second;
-        }
+        for (auto const &aa : s2.ampli) ampli[aa.first] += aa.second;
         prune();
         return *this;
       }
@@ -136,10 +249,7 @@ namespace triqs {
    @return Reference to this state
   */
       state &operator-=(state const &s2) {
-        for (auto const &aa : s2.ampli) {
-          auto r = ampli.insert({aa.first, -aa.second});
-          if (!r.second) r.first->second -= aa.second;
-        }
+        for (auto const &aa : s2.ampli) ampli[aa.first] -= aa.second;
         prune();
         return *this;
       }
@@ -172,7 +282,7 @@ namespace triqs {
         value_type res(0);
         for (auto const &a : s1.ampli) {
           using triqs::utility::conj;
-          if (s2.ampli.count(a.first) == 1) res += conj(a.second) * s2.ampli.at(a.first);
+          if (auto p = s2.ampli.find(a.first)) res += conj(a.second) * (*p);
         }
         return res;
       }
@@ -205,15 +315,19 @@ namespace triqs {
   */
       void set_hilbert(HilbertSpace const &new_hs) { hs_p = &new_hs; }
 
+      /// Set all amplitudes to 0, keeping the allocated memory
+      void clear() { ampli.clear(); }
+
+      /// Allocate memory for a given number of non-vanishing amplitudes
+      /**
+   @param n Expected number of non-vanishing amplitudes
+  */
+      void reserve(int n) { ampli.reserve(n); }
+
       private:
       void prune() {
-        for (auto it = ampli.begin(); it != ampli.end();) {
-          using triqs::utility::is_zero;
-          if (is_zero(it->second))
-            it = ampli.erase(it);
-          else
-            ++it;
-        }
+        using triqs::utility::is_zero;
+        ampli.remove_if([](value_type const &x) { return is_zero(x); });
       }
     };
 
@@ -348,6 +462,12 @@ namespace triqs {
    @param new_hs Constant reference to the new Hilbert space
   */
       void set_hilbert(HilbertSpace const &new_hs) { hs_p = &new_hs; }
+
+      /// Set all amplitudes to 0, resizing the storage to the dimension of the associated Hilbert space if needed
+      void clear() {
+        if (ampli.size() != hs_p->size()) ampli.resize(hs_p->size());
+        ampli() = 0;
+      }
     };
 
     // Print state
@@ -357,7 +477,7 @@ namespace triqs {
       auto const &hs         = s.get_hilbert();
 
       using value_type = typename state<HilbertSpace, ScalarType, BasedOnMap>::value_type;
-      foreach (s, [&os, hs, &something_written](int i, value_type ampl) {
+      foreach (s, [&os, &hs, &something_written](int i, value_type ampl) {
         using triqs::utility::is_zero;
         if (!is_zero(ampl)) {
           os << " +(" << ampl << ")"
@@ -219,6 +219,21 @@ namespace triqs {
 
         double operator()() { return DBL_EPSILON + eval() * (1 - 2 * DBL_EPSILON); }
 
+        // Write/read the state, e.g. to checkpoint a computation (same convention as the boost engines)
+        friend std::ostream &operator<<(std::ostream &out, RandMT const &R) {
+          out << R.seed_save << ' ' << R.initseed << ' ' << R.left << ' ' << (R.left > 0 ? R.next - R.state : 0); // next is unused if left <= 0
+          for (int j = 0; j <= N; ++j) out << ' ' << R.state[j];
+          return out;
+        }
+
+        friend std::istream &operator>>(std::istream &in, RandMT &R) {
+          long offset;
+          in >> R.seed_save >> R.initseed >> R.left >> offset;
+          for (int j = 0; j <= N; ++j) in >> R.state[j];
+          R.next = R.state + offset;
+          return in;
+        }
+
         double eval();
         // inline of this causes a BIG pb with g++ 4.1.2. WHY ?????
         //  inline double operator()() {
@@ -0,0 +1,239 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <triqs/utility/exceptions.hpp>
+#include <triqs/mpi/base.hpp>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "./impl_tools.hpp"
+
+namespace triqs {
+  namespace mc_tools {
+
+    /**
+     * A pool of threads running the accumulations of the async_measure's.
+     *
+     * Each async_measure has a queue of snapshots, processed in order, by at most one thread at a time :
+     * the result of a measure does not depend on the number of threads.
+     * With 0 thread, the snapshots are processed immediately by the caller.
+     */
+    class async_measure_pool {
+      public:
+      // A queue of work, in a ring buffer of fixed capacity, processed in order
+      struct queue {
+        size_t capacity, head = 0, count = 0; // the items [head, head + count[ (mod capacity) are pending
+        bool scheduled = false;               // in the ready list, or being processed by a thread
+        queue(size_t capacity) : capacity(capacity) {}
+        virtual ~queue() = default;
+        virtual void process(size_t i) = 0; // process the item i, called without the lock
+      };
+
+      explicit async_measure_pool(int n_threads = 1) {
+        if (n_threads < 0) TRIQS_RUNTIME_ERROR << "async_measure_pool : negative number of threads " << n_threads;
+        for (int i = 0; i < n_threads; ++i) workers.emplace_back([this] { worker_loop(); });
+      }
+
+      async_measure_pool(async_measure_pool const &) = delete;
+      async_measure_pool &operator=(async_measure_pool const &) = delete;
+
+      /// Finish all the pending work and join the threads
+      ~async_measure_pool() {
+        {
+          std::lock_guard<std::mutex> lock(mut);
+          stop = true;
+        }
+        work_cv.notify_all();
+        for (auto &w : workers) w.join();
+      }
+
+      /// Number of threads
+      int n_threads() const { return workers.size(); }
+
+      /**
+       * Add an item to the queue q : write(i) fills the slot i of the ring buffer.
+       * If the queue is full, waits for the threads to process an item (backpressure).
+       * Rethrows the errors of the threads.
+       */
+      template <typename F> void push(queue &q, F &&write) {
+        if (workers.empty()) { // synchronous
+          write(q.head);
+          q.process(q.head);
+          return;
+        }
+        std::unique_lock<std::mutex> lock(mut);
+        progress_cv.wait(lock, [&q] { return q.count < q.capacity; });
+        rethrow_error();
+        size_t i = (q.head + q.count) % q.capacity;
+        lock.unlock();
+        write(i); // no thread reads the slot i until count is increased
+        lock.lock();
+        ++q.count;
+        if (!q.scheduled) {
+          q.scheduled = true;
+          ready.push_back(&q);
+          lock.unlock();
+          work_cv.notify_one();
+        }
+      }
+
+      /// Wait until all the items of q are processed. Rethrows the errors of the threads.
+      void drain(queue &q) {
+        std::unique_lock<std::mutex> lock(mut);
+        progress_cv.wait(lock, [&q] { return !q.scheduled; });
+        rethrow_error();
+      }
+
+      /// Wait until all the items of all queues are processed. Rethrows the errors of the threads.
+      void drain_all() {
+        std::unique_lock<std::mutex> lock(mut);
+        progress_cv.wait(lock, [this] { return ready.empty() and n_busy == 0; });
+        rethrow_error();
+      }
+
+      private:
+      std::vector<std::thread> workers;
+      std::deque<queue *> ready; // the queues with pending items, not being processed
+      int n_busy = 0;            // number of threads processing a queue
+      bool stop  = false;
+      std::exception_ptr error;
+      std::mutex mut;
+      std::condition_variable work_cv, progress_cv;
+
+      void rethrow_error() {
+        if (error) std::rethrow_exception(std::exchange(error, nullptr));
+      }
+
+      // Take a ready queue and process its items in order, until it is empty
+      void worker_loop() {
+        std::unique_lock<std::mutex> lock(mut);
+        while (true) {
+          work_cv.wait(lock, [this] { return stop or !ready.empty(); });
+          if (ready.empty()) return; // stop, and nothing left to do
+          queue *q = ready.front();
+          ready.pop_front();
+          ++n_busy;
+          while (q->count > 0) {
+            lock.unlock();
+            try {
+              q->process(q->head);
+            } catch (...) {
+              lock.lock();
+              if (!error) error = std::current_exception();
+              lock.unlock();
+            }
+            lock.lock();
+            q->head = (q->head + 1) % q->capacity;
+            --q->count;
+            progress_cv.notify_all();
+          }
+          q->scheduled = false;
+          --n_busy;
+          progress_cv.notify_all();
+        }
+      }
+    };
+
+    //--------------------------------------------------------------------
+
+    /**
+     * An asynchronous measure : models the Measure concept, from a measure M with
+     *
+     *  - S snapshot() : copies the part of the configuration needed by the measure (called by the Markov chain).
+     *  - void accumulate(S const &s, MCSignType const &sign) : the accumulation for the snapshot s (called by a thread of the pool).
+     *  - void collect_results(mpi::communicator const &).
+     *
+     * accumulate(sign) only takes a snapshot and queues it in a ring buffer of the given capacity.
+     * The snapshot must not read the data modified by the accumulation : they run concurrently.
+     * collect_results and h5_write first wait for all the snapshots to be accumulated.
+     */
+    template <typename MCSignType, typename M> class async_measure {
+      using snapshot_t = std::decay_t<decltype(std::declval<M &>().snapshot())>;
+
+      struct impl_t : async_measure_pool::queue {
+        M m;
+        std::vector<std::pair<snapshot_t, MCSignType>> slots;
+        impl_t(M &&m, size_t capacity) : queue(capacity), m(std::move(m)), slots(capacity) {}
+        void process(size_t i) override { m.accumulate(slots[i].first, slots[i].second); }
+      };
+
+      std::shared_ptr<async_measure_pool> pool;
+      std::unique_ptr<impl_t> impl; // stable address, registered in the pool
+
+      public:
+      async_measure(std::shared_ptr<async_measure_pool> pool, M m, size_t capacity = 64) : pool(std::move(pool)) {
+        static_assert(std::is_default_constructible<snapshot_t>::value, "The snapshot of an async measure must be default constructible");
+        static_assert(has_collect_result<M>::value, " This measure has no collect_results method !");
+        if (capacity == 0) TRIQS_RUNTIME_ERROR << "async_measure : the capacity must be > 0";
+        impl = std::make_unique<impl_t>(std::move(m), capacity);
+      }
+
+      async_measure(async_measure const &) = delete;
+      async_measure(async_measure &&)      = default;
+      async_measure &operator=(async_measure const &) = delete;
+      async_measure &operator=(async_measure &&) = default;
+
+      ~async_measure() {
+        if (!impl) return;
+        try {
+          pool->drain(*impl); // a thread may still use impl
+        } catch (...) {} // the error is lost, as in any destructor
+      }
+
+      /// Queue a snapshot of the configuration
+      void accumulate(MCSignType const &sign) {
+        snapshot_t s = impl->m.snapshot();
+        pool->push(*impl, [this, &s, &sign](size_t i) {
+          impl->slots[i].first  = std::move(s);
+          impl->slots[i].second = sign;
+        });
+      }
+
+      /// Wait until all the snapshots are accumulated
+      void drain() const { pool->drain(*impl); }
+
+      /// Wait until all the snapshots are accumulated, then call collect_results of the measure
+      void collect_results(mpi::communicator const &c) {
+        drain();
+        impl->m.collect_results(c);
+      }
+
+      /// Access to the measure. Call drain before reading its results.
+      M &get() { return impl->m; }
+
+      // HDF5 interface, if the measure has one
+      friend void h5_write(h5::group g, std::string const &name, async_measure const &am) {
+        am.drain();
+        if (auto f = make_h5_write(&std::as_const(am.impl->m))) f(g, name);
+      }
+      friend void h5_read(h5::group g, std::string const &name, async_measure &am) {
+        am.drain();
+        if (auto f = make_h5_read(&am.impl->m)) f(g, name);
+      }
+    };
+
+  } // namespace mc_tools
+} // namespace triqs
@@ -26,9 +26,17 @@
 #include <triqs/utility/report_stream.hpp>
 #include <triqs/utility/signal_handler.hpp>
 #include <triqs/mpi/base.hpp>
+#include <triqs/statistics/statistics.hpp>
+#include <triqs/h5.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include "./mc_measure_aux_set.hpp"
 #include "./mc_measure_set.hpp"
 #include "./mc_move_set.hpp"
+#include "./mc_static_move_set.hpp"
+#include "./mc_static_measure_set.hpp"
+#include "./mc_async_measure.hpp"
 #include "./random_generator.hpp"
 
 namespace triqs::mc_tools {
@@ -89,9 +97,78 @@ namespace triqs::mc_tools {
    */
     template <typename MoveType> void add_move(MoveType &&m, std::string name, double proposition_probability = 1.0) {
       static_assert(!std::is_pointer<MoveType>::value, "add_move in mc_generic takes ONLY values !");
+      if (static_moves.cycle) TRIQS_RUNTIME_ERROR << "mc_generic : add_move can not be used with set_static_moves";
       AllMoves.add(std::forward<MoveType>(m), name, proposition_probability);
     }
 
+    /**
+   * Use a static_move_set for all the moves, instead of add_move.
+   *
+   * The Metropolis steps of a cycle are then compiled for these moves : there is no type erasure
+   * in the choice of the move and in the calls to attempt, accept and reject.
+   *
+   * @param ms   The moves, cf make_static_move_set. It must use the random generator of this object (get_rng()).
+   */
+    template <typename... Moves> void set_static_moves(static_move_set<MCSignType, Moves...> &&ms) {
+      if (AllMoves.size() > 0) TRIQS_RUNTIME_ERROR << "mc_generic : set_static_moves can not be used with add_move";
+      using ms_t                        = static_move_set<MCSignType, Moves...>;
+      auto p                            = std::make_shared<ms_t>(std::move(ms));
+      static_moves.cycle                = [p](mc_generic &mc, uint64_t length_cycle) { return mc.metropolis_cycle(*p, length_cycle); };
+      static_moves.collect_statistics   = [p](mpi::communicator const &c) { p->collect_statistics(c); };
+      static_moves.get_acceptance_rates = [p]() { return p->get_acceptance_rates(); };
+      static_moves.get_statistics       = [p]() { return p->get_statistics(); };
+      static_moves.fill_statistics      = [p](std::vector<mc_statistics::move_stat> &r) { p->fill_statistics(r); };
+      static_moves.h5_w                 = [p](h5::group g, std::string const &name) { h5_write(g, name, *p); };
+      static_moves.h5_r                 = [p](h5::group g, std::string const &name) { h5_read(g, name, *p); };
+    }
+
+    /**
+   * Adapt the proposition probabilities of the moves during the warmup.
+   *
+   * During the warmup, the acceptance rate and the time spent in each move are measured, and every tenth of the warmup
+   * the proposition probabilities are changed to propose more often the moves which give more accepted updates
+   * per second (cf move_set::adapt_proposition_probabilities). They are then kept fixed for the accumulation.
+   * The chosen probabilities are given by get_proposition_probabilities.
+   *
+   * Only for the moves registered with add_move. The proposition probabilities must not appear in the acceptance
+   * ratio of the moves : e.g. two moves which are the reverse of each other should be added together as a move_set.
+   *
+   * @param adapt          Adapt or not the probabilities
+   * @param min_fraction   Lower bound of the probability of each move, relative to the one given to add_move
+   */
+    void set_adaptive_move_probabilities(bool adapt, double min_fraction = 0.1) {
+      adapt_move_probabilities = adapt;
+      adapt_min_fraction       = min_fraction;
+    }
+
+    /**
+   * Choose the measure stride from the autocorrelation time of a cheap observable
+   *
+   * The observable f (e.g. the expansion order or the sign) is recorded after each cycle of the second half of the warmup.
+   * At the end of the warmup, its integrated autocorrelation time tau (in cycles) is estimated,
+   * and the measures of the accumulation are done every max(1, factor * tau) cycles (cf set_measure_stride).
+   * The chosen stride is reported and given by get_measure_stride.
+   *
+   * @param f          The observable, called after a cycle. An empty function disables the estimation
+   * @param factor     The stride in units of the autocorrelation time
+   */
+    void set_autocorrelation_observable(std::function<double()> f, double factor = 1) {
+      autocorr_observable = std::move(f);
+      autocorr_factor     = factor;
+    }
+
+    /// Measure every stride cycles in the accumulation (default 1). The number of cycles is unchanged
+    void set_measure_stride(uint64_t stride) {
+      if (stride == 0) TRIQS_RUNTIME_ERROR << "mc_generic : the measure stride must be > 0";
+      measure_stride = stride;
+    }
+
+    /// The number of cycles between two measures in the accumulation
+    uint64_t get_measure_stride() const { return measure_stride; }
+
+    /// The autocorrelation time (in cycles) of the observable of set_autocorrelation_observable, estimated in the last warmup. -1 if none
+    double get_autocorrelation_time() const { return autocorr_time; }
+
     /**
    * Register a measure
    *
@@ -107,6 +184,35 @@ namespace triqs::mc_tools {
       return AllMeasures.insert(std::forward<MeasureType>(m), name, enable_timer);
     }
 
+    /**
+   * Register an asynchronous measure, cf async_measure
+   *
+   * At each measure, only a snapshot of the configuration is taken : the accumulation runs on the threads
+   * of the measure pool (cf set_measure_threads), concurrently with the next cycles.
+   * The run returns when all the snapshots are accumulated.
+   *
+   * @param m                        The measure, with snapshot() and accumulate(snapshot, sign)
+   * @param name                     Name of the measure
+   * @param capacity                 Maximum number of snapshots waiting to be accumulated. When reached, the Markov chain waits.
+   *
+   */
+    template <typename MeasureType>
+    typename measure_set<MCSignType>::measure_ptr_t add_async_measure(MeasureType &&m, std::string name, size_t capacity = 64,
+                                                                      bool enable_timer = true) {
+      if (!measure_pool) measure_pool = std::make_shared<async_measure_pool>(n_measure_threads);
+      using am_t = async_measure<MCSignType, std::decay_t<MeasureType>>;
+      return add_measure(am_t(measure_pool, std::forward<MeasureType>(m), capacity), name, enable_timer);
+    }
+
+    /**
+   * Number of threads accumulating the asynchronous measures. Default : 1. With 0, they are accumulated synchronously.
+   * Must be called before add_async_measure.
+   */
+    void set_measure_threads(int n) {
+      if (measure_pool) TRIQS_RUNTIME_ERROR << "mc_generic : set_measure_threads must be called before add_async_measure";
+      n_measure_threads = n;
+    }
+
     /**
    * Register a common part for several measure [EXPERIMENTAL: API WILL CHANGE]
    */
@@ -214,29 +320,35 @@ namespace triqs::mc_tools {
       utility::timer timer;
       timer.start();
       if (n_cycles == 0) return 0;
+
+      // After load_checkpoint, continue the phase which was interrupted, or skip the warmup if it was finished
+      int NC = 0;
+      if (resume_phase > int(do_measure)) {
+        report << "Skipped : done before the checkpoint\n" << std::endl;
+        return 0;
+      }
+      bool resume  = (resume_phase == int(do_measure));
+      resume_phase = -1;
+      if (resume) {
+        if (resume_cycles >= n_cycles) return 0;
+        NC = resume_cycles;
+        report << "Resuming from the checkpoint at cycle " << NC << std::endl;
+      } else
+        nmeasures = 0;
+
       triqs::signal_handler::start();
       done_percent = 0;
-      nmeasures    = 0;
       bool stop_it = false, finished = false;
-      int NC                = 0;
-      double next_info_time = 0.1;
+      double next_info_time = 0.1, next_checkpoint_time = checkpoint_interval;
+      bool adapt            = (adapt_move_probabilities and !do_measure and !static_moves.cycle);
+      uint64_t adapt_period = std::max(n_cycles / 10, uint64_t(1));
+      bool record_autocorr  = (autocorr_observable and !do_measure);
+      std::vector<double> autocorr_series;
       for (; !stop_it; ++NC) { // do NOT reinit NC to 0
-        // Metropolis loop. Switch here for HeatBath, etc...
-        for (uint64_t k = 1; (k <= length_cycle); k++) {
-          if (triqs::signal_handler::received()) goto _final;
-          double r = AllMoves.attempt();
-          if (RandomGenerator() < std::min(1.0, r)) {
-            if (debug) std::cerr << " Move accepted " << std::endl;
-            sign *= AllMoves.accept();
-            if (debug) std::cerr << " New sign = " << sign << std::endl;
-          } else {
-            if (debug) std::cerr << " Move rejected " << std::endl;
-            AllMoves.reject();
-          }
-          ++config_id;
-        }
+        if (!(static_moves.cycle ? static_moves.cycle(*this, length_cycle) : metropolis_cycle(AllMoves, length_cycle))) goto _final;
         if (after_cycle_duty) { after_cycle_duty(); }
-        if (do_measure) {
+        if (record_autocorr and uint64_t(NC) >= n_cycles / 2) autocorr_series.push_back(autocorr_observable());
+        if (do_measure and (NC + 1) % measure_stride == 0) {
           nmeasures++;
           for (auto &x : AllMeasuresAux) x();
           AllMeasures.accumulate(sign);
@@ -252,9 +364,21 @@ namespace triqs::mc_tools {
         }
         finished = NC + 1 >= n_cycles;
         stop_it  = (stop_callback() || triqs::signal_handler::received() || finished);
+        // not when interrupted : a run restarted from the checkpoint adapts at the same cycles as an uninterrupted one
+        if (adapt and (finished or (NC + 1) % adapt_period == 0)) AllMoves.adapt_proposition_probabilities(adapt_min_fraction);
+        if (!checkpoint_filename.empty() and (stop_it or timer > next_checkpoint_time)) {
+          write_checkpoint(do_measure, NC + 1);
+          next_checkpoint_time = timer + checkpoint_interval;
+        }
       }
+      if (measure_pool) measure_pool->drain_all(); // the async measures are complete at the end of the run
       int status = (finished ? 0 : (triqs::signal_handler::received() ? 2 : 1));
       triqs::signal_handler::stop();
+      if (record_autocorr) choose_measure_stride(autocorr_series);
+      if (adapt) {
+        report(2) << "Adapted proposition probabilities of the moves :\n";
+        for (auto const &[name, p] : AllMoves.get_proposition_probabilities()) report(2) << "  " << name << " : " << p << "\n";
+      }
       current_cycle_number += NC;
       timer.stop();
       if (do_measure) {
@@ -271,16 +395,115 @@ namespace triqs::mc_tools {
       return status;
     }
 
+    // Set measure_stride from the autocorrelation time of the observable recorded in the warmup
+    void choose_measure_stride(std::vector<double> const &series) {
+      auto [min, max] = std::minmax_element(series.begin(), series.end());
+      if (series.size() < 100 or *min == *max) { // too few cycles, or no fluctuation
+        report << "Autocorrelation time not estimated : measure stride kept to " << measure_stride << std::endl;
+        return;
+      }
+      autocorr_time  = statistics::autocorrelation_time(series);
+      measure_stride = std::max(uint64_t(autocorr_factor * autocorr_time), uint64_t(1));
+      report << "Autocorrelation time : " << autocorr_time << " cycles. Measure stride : " << measure_stride << " cycles" << std::endl;
+    }
+
+    // The Metropolis steps of one cycle. Returns false if interrupted by a signal.
+    template <typename MoveSet> bool metropolis_cycle(MoveSet &moves, uint64_t length_cycle) {
+      // Metropolis loop. Switch here for HeatBath, etc...
+      for (uint64_t k = 1; (k <= length_cycle); k++) {
+        if (triqs::signal_handler::received()) return false;
+        double r = moves.attempt();
+        if (RandomGenerator() < std::min(1.0, r)) {
+          if (debug) std::cerr << " Move accepted " << std::endl;
+          sign *= moves.accept();
+          if (debug) std::cerr << " New sign = " << sign << std::endl;
+        } else {
+          if (debug) std::cerr << " Move rejected " << std::endl;
+          moves.reject();
+        }
+        ++config_id;
+      }
+      return true;
+    }
+
+    // Write the checkpoint in a temporary file, then rename it : the checkpoint file is always complete.
+    void write_checkpoint(bool in_accumulation, uint64_t cycles_done) {
+      std::string tmp = checkpoint_filename + ".tmp";
+      {
+        h5::file f(tmp, 'w');
+        h5::group top(f);
+        h5_write(top, "mc_generic", *this);
+        auto gr = top.create_group("run");
+        h5_write(gr, "phase", int(in_accumulation));
+        h5_write(gr, "cycles_done", cycles_done);
+        h5_write(gr, "measure_stride", measure_stride);
+        if (checkpoint_write_config) checkpoint_write_config(top.create_group("configuration"));
+      } // the file is closed here
+      if (std::rename(tmp.c_str(), checkpoint_filename.c_str()) != 0)
+        TRIQS_RUNTIME_ERROR << "mc_generic : can not rename " << tmp << " to " << checkpoint_filename;
+      report(3) << "Checkpoint written in " << checkpoint_filename << " at cycle " << cycles_done << std::endl;
+    }
+
     public:
+    /**
+     * Checkpoint the Monte Carlo in a file, to be able to restart it with load_checkpoint.
+     *
+     * The checkpoint is written every interval seconds (wall-clock, checked after each cycle), and when
+     * the run stops (end of the warmup or of the accumulation, stop_callback or signal).
+     * It contains the state of the moves and of the measures (with their h5_write), the random generator, the
+     * counters, the sign and the configuration, written by write_config.
+     * The file is written under another name, then renamed, so that it is never left incomplete.
+     * With several MPI processes, each one must use its own file.
+     *
+     * @param filename       Name of the checkpoint file
+     * @param interval       Time between two checkpoints, in seconds
+     * @param write_config   Writes the configuration in the group it is given [optional]
+     * @param read_config    Reads the configuration from the group it is given [optional]
+     */
+    void set_checkpoint(std::string filename, double interval, std::function<void(h5::group)> write_config = {},
+                        std::function<void(h5::group)> read_config = {}) {
+      checkpoint_filename     = std::move(filename);
+      checkpoint_interval     = interval;
+      checkpoint_write_config = std::move(write_config);
+      checkpoint_read_config  = std::move(read_config);
+    }
+
+    /**
+     * Restore the Monte Carlo from the checkpoint file given to set_checkpoint, if it exists.
+     *
+     * The next call to warmup and/or accumulate (with the same parameters) continues the interrupted run :
+     * the warmup is skipped if it was finished, and the interrupted phase resumes at the cycle of the checkpoint.
+     * For a checkpoint written between two cycles, the continued run is identical to an uninterrupted one.
+     * A signal interrupts the current cycle : it is then counted as done.
+     *
+     * @return true iif a checkpoint has been loaded
+     */
+    bool load_checkpoint() {
+      if (checkpoint_filename.empty()) TRIQS_RUNTIME_ERROR << "mc_generic : no checkpoint file, cf set_checkpoint";
+      if (!std::ifstream(checkpoint_filename)) return false;
+      h5::file f(checkpoint_filename, 'r');
+      h5::group top(f);
+      h5_read(top, "mc_generic", *this);
+      auto gr = top.open_group("run");
+      h5_read(gr, "phase", resume_phase);
+      h5_read(gr, "cycles_done", resume_cycles);
+      if (gr.has_key("measure_stride")) h5_read(gr, "measure_stride", measure_stride);
+      if (checkpoint_read_config) checkpoint_read_config(top.open_group("configuration"));
+      report << "Checkpoint loaded from " << checkpoint_filename << std::endl;
+      return true;
+    }
+
     /// Reduce the results of the measures, and reports some statistics
     void collect_results(mpi::communicator const &c) {
       report(3) << "[Rank " << c.rank() << "] Collect results: Waiting for all mpi-threads to finish accumulating...\n";
       AllMeasures.collect_results(c);
       AllMoves.collect_statistics(c);
+      if (static_moves.collect_statistics) static_moves.collect_statistics(c);
       uint64_t nmeasures_tot = mpi::reduce(nmeasures, c);
 
       report(3) << "[Rank " << c.rank() << "] Timings for all measures:\n" << AllMeasures.get_timings();
-      report(3) << "[Rank " << c.rank() << "] Acceptance rate for all moves:\n" << AllMoves.get_statistics();
+      report(3) << "[Rank " << c.rank() << "] Acceptance rate for all moves:\n"
+                << (static_moves.get_statistics ? static_moves.get_statistics() : AllMoves.get_statistics());
       report(3) << "[Rank " << c.rank() << "] Warmup lasted: " << get_warmup_time() << " seconds [" << get_warmup_time_HHMMSS() << "]\n";
       report(3) << "[Rank " << c.rank() << "] Simulation lasted: " << get_accumulation_time() << " seconds [" << get_accumulation_time_HHMMSS()
                 << "]\n";
@@ -293,7 +516,46 @@ namespace triqs::mc_tools {
    *
    * @return map : name_of_the_move -> acceptance rate of this move
    */
-    std::map<std::string, double> get_acceptance_rates() const { return AllMoves.get_acceptance_rates(); }
+    std::map<std::string, double> get_acceptance_rates() const {
+      return (static_moves.get_acceptance_rates ? static_moves.get_acceptance_rates() : AllMoves.get_acceptance_rates());
+    }
+
+    /**
+   * The proposition probabilities of the moves, normalized, e.g. after their adaptation in the warmup
+   *
+   * @return map : name_of_the_move -> proposition probability of this move
+   */
+    std::map<std::string, double> get_proposition_probabilities() const { return AllMoves.get_proposition_probabilities(); }
+
+    /**
+   * Time one attempt in p of each move added with add_move, with its accept or reject,
+   * for get_run_statistics and the adaptation of the proposition probabilities.
+   * 0 disables the timing. Default : 32.
+   */
+    void set_move_timing_period(uint64_t p) { AllMoves.set_timing_period(p); }
+
+    /**
+   * The statistics of the moves and measures and the times of the runs, reduced over the processes of c.
+   *
+   * Collective on c. The result can be written with h5_write, or as JSON with to_json.
+   * The moves of set_static_moves are not timed.
+   */
+    mc_statistics get_run_statistics(mpi::communicator const &c) const {
+      mc_statistics r;
+      if (static_moves.fill_statistics)
+        static_moves.fill_statistics(r.moves);
+      else
+        AllMoves.fill_statistics(r.moves);
+      AllMeasures.fill_statistics(r.measures);
+      r.n_cycles              = current_cycle_number;
+      r.n_measures            = nmeasures;
+      r.warmup_time           = get_warmup_time();
+      r.accumulation_time     = get_accumulation_time();
+      r.warmup_time_max       = r.warmup_time;
+      r.accumulation_time_max = r.accumulation_time;
+      r.all_reduce(c);
+      return r;
+    }
 
     /**
    *  The current percents done
@@ -352,34 +614,65 @@ namespace triqs::mc_tools {
     /// HDF5 interface
     friend void h5_write(h5::group g, std::string const &name, mc_generic const &mc) {
       auto gr = g.create_group(name);
-      h5_write(gr, "moves", mc.AllMoves);
+      if (mc.static_moves.h5_w)
+        mc.static_moves.h5_w(gr, "moves");
+      else
+        h5_write(gr, "moves", mc.AllMoves);
       h5_write(gr, "measures", mc.AllMeasures);
       h5_write(gr, "number_cycle_done", mc.current_cycle_number);
       h5_write(gr, "number_measure_done", mc.nmeasures);
       h5_write(gr, "sign", mc.sign);
+      h5_write(gr, "config_id", mc.config_id);
+      h5_write(gr, "rng", mc.RandomGenerator);
     }
 
     /// HDF5 interface
     friend void h5_read(h5::group g, std::string const &name, mc_generic &mc) {
       auto gr = g.open_group(name);
-      h5_read(gr, "moves", mc.AllMoves);
+      if (mc.static_moves.h5_r)
+        mc.static_moves.h5_r(gr, "moves");
+      else
+        h5_read(gr, "moves", mc.AllMoves);
       h5_read(gr, "measures", mc.AllMeasures);
       h5_read(gr, "number_cycle_done", mc.current_cycle_number);
       h5_read(gr, "number_measure_done", mc.nmeasures);
       h5_read(gr, "sign", mc.sign);
+      if (gr.has_key("config_id")) h5_read(gr, "config_id", mc.config_id); // not in older files
+      if (gr.has_key("rng")) h5_read(gr, "rng", mc.RandomGenerator);
     }
 
     private:
     random_generator RandomGenerator;
     move_set<MCSignType> AllMoves;
+    struct { // the static_move_set given to set_static_moves, if any, erased at the level of a cycle
+      std::function<bool(mc_generic &, uint64_t)> cycle;
+      std::function<void(mpi::communicator const &)> collect_statistics;
+      std::function<std::map<std::string, double>()> get_acceptance_rates;
+      std::function<std::string()> get_statistics;
+      std::function<void(std::vector<mc_statistics::move_stat> &)> fill_statistics;
+      std::function<void(h5::group, std::string const &)> h5_r, h5_w;
+    } static_moves;
     measure_set<MCSignType> AllMeasures;
     std::vector<measure_aux> AllMeasuresAux;
+    std::shared_ptr<async_measure_pool> measure_pool; // the threads of the async measures, if any
+    int n_measure_threads = 1;
+    std::function<double()> autocorr_observable;
+    double autocorr_factor  = 1;
+    double autocorr_time    = -1;
+    uint64_t measure_stride = 1;
     utility::report_stream report;
-    uint64_t nmeasures, current_cycle_number = 0;
+    uint64_t nmeasures = 0, current_cycle_number = 0;
     utility::timer timer_accumulation, timer_warmup;
     std::function<void()> after_cycle_duty;
+    bool adapt_move_probabilities = false;
+    double adapt_min_fraction     = 0.1;
     MCSignType sign       = 1;
     uint64_t done_percent = 0;
     uint64_t config_id    = 0;
+    std::string checkpoint_filename;
+    double checkpoint_interval = 0;
+    std::function<void(h5::group)> checkpoint_write_config, checkpoint_read_config;
+    int resume_phase       = -1; // after load_checkpoint : the phase of the checkpoint, 0 (warmup) or 1 (accumulation)
+    uint64_t resume_cycles = 0;  // and the number of cycles done in this phase
   };
 } // namespace triqs::mc_tools
@@ -26,6 +26,7 @@
 #include <functional>
 #include <map>
 #include "./impl_tools.hpp"
+#include "./mc_statistics.hpp"
 
 namespace triqs {
   namespace mc_tools {
@@ -153,6 +154,11 @@ namespace triqs {
         return s.str();
       }
 
+      /// Append the count and time of the measures on this process to r
+      void fill_statistics(std::vector<mc_statistics::measure_stat> &r) const {
+        for (auto &nmp : m_map) r.push_back({nmp.first, nmp.second.count(), nmp.second.duration()});
+      }
+
       // gather result for all measure, on communicator c
       void collect_results(mpi::communicator const &c) {
         for (auto &nmp : m_map) nmp.second.collect_results(c);
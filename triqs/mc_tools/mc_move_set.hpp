@@ -23,8 +23,10 @@
 #include <triqs/utility/exceptions.hpp>
 #include <triqs/mpi/base.hpp>
 #include <functional>
+#include <chrono>
 #include "./random_generator.hpp"
 #include "./impl_tools.hpp"
+#include "./mc_statistics.hpp"
 
 namespace triqs {
   namespace mc_tools {
@@ -50,6 +52,16 @@ namespace triqs {
       double acceptance_rate_;
       bool is_move_set_; // need to remember if the move was a move_set for printing details later.
 
+      // Sampled timing : one attempt in timing_period is timed, with the following accept or reject (0 : no timing)
+      using clock_t           = std::chrono::steady_clock;
+      uint64_t timing_period  = 32, n_since_timed = 0;
+      uint64_t n_timed        = 0, n_timed_accepted = 0;
+      double t_attempt        = 0, t_accept = 0, t_reject = 0; // time spent in the timed calls
+      bool timed              = false;
+      static double seconds_since(clock_t::time_point t0) { return std::chrono::duration<double>(clock_t::now() - t0).count(); }
+
+      friend class move_set<MCSignType>; // saves and restores the counters, cf its h5_write
+
 #ifdef TRIQS_MCTOOLS_DEBUG
       static constexpr bool debug = true;
 #else
@@ -86,18 +98,57 @@ namespace triqs {
 
       MCSignType attempt() {
         NProposed++;
-        return attempt_();
+        timed = (++n_since_timed == timing_period); // never for timing_period = 0
+        if (!timed) return attempt_();
+        n_since_timed = 0;
+        auto t0      = clock_t::now();
+        MCSignType r = attempt_();
+        t_attempt += seconds_since(t0);
+        ++n_timed;
+        return r;
       }
       MCSignType accept() {
         Naccepted++;
-        return accept_();
+        if (!timed) return accept_();
+        auto t0      = clock_t::now();
+        MCSignType r = accept_();
+        t_accept += seconds_since(t0);
+        ++n_timed_accepted;
+        return r;
+      }
+      void reject() {
+        if (!timed) return reject_();
+        auto t0 = clock_t::now();
+        reject_();
+        t_reject += seconds_since(t0);
       }
-      void reject() { reject_(); }
 
       double acceptance_rate() const { return acceptance_rate_; }
       uint64_t n_proposed_config() const { return NProposed; }
       uint64_t n_accepted_config() const { return Naccepted; }
 
+      /// Time one attempt in p, with its accept or reject (0 : no timing)
+      void set_timing_period(uint64_t p) {
+        timing_period = p;
+        n_since_timed = 0;
+      }
+
+      /// Estimated time spent in attempt, from the timed calls
+      double time_attempt() const { return (n_timed ? t_attempt / n_timed * NProposed : 0); }
+
+      /// Estimated time spent in accept, from the timed calls
+      double time_accept() const { return (n_timed_accepted ? t_accept / n_timed_accepted * Naccepted : 0); }
+
+      /// Estimated time spent in reject, from the timed calls
+      double time_reject() const {
+        uint64_t n_timed_rejected = n_timed - n_timed_accepted;
+        return (n_timed_rejected ? t_reject / n_timed_rejected * (NProposed - Naccepted) : 0);
+      }
+
+      /// Number of timed attempts, and total time spent in them (with their accept or reject)
+      uint64_t n_timed_attempts() const { return n_timed; }
+      double timed_duration() const { return t_attempt + t_accept + t_reject; }
+
       void collect_statistics(mpi::communicator const &c) {
         uint64_t nacc_tot  = mpi::reduce(Naccepted, c);
         uint64_t nprop_tot = mpi::reduce(NProposed, c);
@@ -129,6 +180,11 @@ namespace triqs {
       MCSignType try_sign_ratio;
       uint64_t debug_counter;
 
+      // Adaptation of the proposition probabilities, cf adapt_proposition_probabilities
+      std::vector<double> Proba_Moves_Init;                    // the probabilities given to add, normalized
+      std::vector<uint64_t> n_proposed0, n_accepted0, n_timed0; // the counters at the last adaptation
+      std::vector<double> timed_duration0;                     // and the time of the timed attempts
+
 #ifdef TRIQS_MCTOOLS_DEBUG
       static constexpr bool debug = true;
 #else
@@ -159,6 +215,83 @@ namespace triqs {
         Proba_Moves.push_back(proposition_probability);
         names_.push_back(name);
         normaliseProba(); // ready to run after each add !
+        Proba_Moves_Init = normalized_probabilities();
+        n_proposed0.push_back(0);
+        n_accepted0.push_back(0);
+        n_timed0.push_back(0);
+        timed_duration0.push_back(0);
+      }
+
+      /// Number of moves
+      size_t size() const { return move_vec.size(); }
+
+      /// The normalized proposition probabilities of the moves, in the order of add
+      std::vector<double> normalized_probabilities() const {
+        std::vector<double> r(Proba_Moves.begin() + 1, Proba_Moves.end()); // Proba_Moves[0] = 0
+        double acc = 0;
+        for (auto x : r) acc += x;
+        for (auto &x : r) x /= acc;
+        return r;
+      }
+
+      /// Proposition probability of all moves (normalized) as a map name:string -> probability:double
+      std::map<std::string, double> get_proposition_probabilities() const {
+        std::map<std::string, double> r;
+        auto p = normalized_probabilities();
+        for (unsigned int u = 0; u < move_vec.size(); ++u) r.insert({names_[u], p[u]});
+        return r;
+      }
+
+      /// Time one attempt in p of each move (also in the move sets it contains), with its accept or reject (0 : no timing)
+      void set_timing_period(uint64_t p) {
+        for (auto &m : move_vec) {
+          m.set_timing_period(p);
+          if (auto ms = m.as_move_set()) ms->set_timing_period(p);
+        }
+      }
+
+      /**
+   * Change the proposition probabilities to propose more often the moves which are accepted more often per unit of time.
+   *
+   * From the acceptance rate a and the time per attempt c of each move since the last call (or the start),
+   * the probability of a move is set to p0 * a / c (renormalized), with p0 its probability given to add,
+   * and at least min_fraction * p0. A move which has not been proposed keeps its probability.
+   * c is estimated from the timed attempts (cf set_timing_period). If a move has none, only the acceptance rates are used.
+   *
+   * NB : the proposition probabilities must not appear in the acceptance ratio of the moves, e.g. for two moves which are
+   * the reverse of each other, which should then be added together as a move_set.
+   */
+      void adapt_proposition_probabilities(double min_fraction) {
+        size_t n = move_vec.size();
+        std::vector<double> p = normalized_probabilities(), w(n), c(n, 1);
+        bool use_cost = true;
+        for (size_t u = 0; u < n; ++u) {
+          uint64_t dtimed = move_vec[u].n_timed_attempts() - n_timed0[u];
+          if (dtimed > 0) c[u] = (move_vec[u].timed_duration() - timed_duration0[u]) / dtimed;
+          if (move_vec[u].n_proposed_config() > n_proposed0[u] and (dtimed == 0 or c[u] <= 0)) use_cost = false;
+        }
+        double w_tot = 0, p_tot = 0;
+        for (size_t u = 0; u < n; ++u) {
+          uint64_t dprop = move_vec[u].n_proposed_config() - n_proposed0[u];
+          uint64_t dacc  = move_vec[u].n_accepted_config() - n_accepted0[u];
+          if (dprop == 0) continue; // w[u] = 0 : p[u] is kept
+          w[u] = Proba_Moves_Init[u] * (double(dacc) / dprop) / (use_cost ? c[u] : 1);
+          w_tot += w[u];
+          p_tot += p[u];
+        }
+        // the proposed moves share their total probability p_tot in proportion of w, with the lower bound
+        for (size_t u = 0; u < n; ++u) {
+          if (w_tot > 0 and move_vec[u].n_proposed_config() > n_proposed0[u])
+            p[u] = std::max(p_tot * w[u] / w_tot, min_fraction * Proba_Moves_Init[u]);
+          Proba_Moves[u + 1] = p[u];
+        }
+        normaliseProba();
+        for (size_t u = 0; u < n; ++u) {
+          n_proposed0[u]     = move_vec[u].n_proposed_config();
+          n_accepted0[u]     = move_vec[u].n_accepted_config();
+          n_timed0[u]        = move_vec[u].n_timed_attempts();
+          timed_duration0[u] = move_vec[u].timed_duration();
+        }
       }
 
       private:
@@ -256,6 +389,18 @@ namespace triqs {
         return r;
       }
 
+      /**
+       * Append the counters and estimated times of the moves on this process to r (a move set is followed by its moves).
+       * The moves are named by their path, prefix + name, e.g. "outer/inner" for the move inner of the move set outer.
+       */
+      void fill_statistics(std::vector<mc_statistics::move_stat> &r, std::string const &prefix = "") const {
+        for (unsigned int u = 0; u < move_vec.size(); ++u) {
+          auto const &m = move_vec[u];
+          r.push_back({prefix + names_[u], m.n_proposed_config(), m.n_accepted_config(), m.time_attempt(), m.time_accept(), m.time_reject()});
+          if (auto ms = m.as_move_set()) ms->fill_statistics(r, prefix + names_[u] + "/");
+        }
+      }
+
       /// Pretty printing of the acceptance probability of the moves.
       std::string get_statistics(std::string decal = "") const {
         std::ostringstream s;
@@ -286,14 +431,68 @@ namespace triqs {
 
       public:
       // HDF5 interface
+      // The proposition probabilities, the counters of the moves and of the adaptation are written in the subgroup
+      // "__move_set", so that a checkpoint restarts an adaptive warmup where it stopped.
       friend void h5_write(h5::group g, std::string const &name, move_set const &ms) {
         auto gr = g.create_group(name);
         for (size_t u = 0; u < ms.move_vec.size(); ++u) h5_write(gr, ms.names_[u], ms.move_vec[u]);
+        ms.write_counters(gr.create_group("__move_set"));
       }
 
       friend void h5_read(h5::group g, std::string const &name, move_set &ms) {
         auto gr = g.open_group(name);
         for (size_t u = 0; u < ms.move_vec.size(); ++u) h5_read(gr, ms.names_[u], ms.move_vec[u]);
+        if (gr.has_key("__move_set")) ms.read_counters(gr.open_group("__move_set")); // absent in older files
+      }
+
+      private:
+      void write_counters(h5::group gs) const {
+        // gather a member of all moves in a vector
+        auto collect = [this](auto f) {
+          std::vector<std::decay_t<decltype(f(move_vec[0]))>> r;
+          for (auto const &m : move_vec) r.push_back(f(m));
+          return r;
+        };
+        h5_write(gs, "proposition_probabilities", Proba_Moves);
+        h5_write(gs, "n_proposed", collect([](move<MCSignType> const &m) { return m.NProposed; }));
+        h5_write(gs, "n_accepted", collect([](move<MCSignType> const &m) { return m.Naccepted; }));
+        h5_write(gs, "n_since_timed", collect([](move<MCSignType> const &m) { return m.n_since_timed; }));
+        h5_write(gs, "n_timed", collect([](move<MCSignType> const &m) { return m.n_timed; }));
+        h5_write(gs, "n_timed_accepted", collect([](move<MCSignType> const &m) { return m.n_timed_accepted; }));
+        h5_write(gs, "t_attempt", collect([](move<MCSignType> const &m) { return m.t_attempt; }));
+        h5_write(gs, "t_accept", collect([](move<MCSignType> const &m) { return m.t_accept; }));
+        h5_write(gs, "t_reject", collect([](move<MCSignType> const &m) { return m.t_reject; }));
+        h5_write(gs, "n_proposed0", n_proposed0);
+        h5_write(gs, "n_accepted0", n_accepted0);
+        h5_write(gs, "n_timed0", n_timed0);
+        h5_write(gs, "timed_duration0", timed_duration0);
+      }
+
+      void read_counters(h5::group gs) {
+        size_t n = move_vec.size();
+        // read a vector and scatter it in a member of all moves
+        auto scatter = [&gs, n, this](std::string const &key, auto f) {
+          std::vector<std::decay_t<decltype(f(move_vec[0]))>> r;
+          h5_read(gs, key, r);
+          if (r.size() != n) TRIQS_RUNTIME_ERROR << "move_set h5_read : " << key << " has " << r.size() << " elements for " << n << " moves";
+          for (size_t u = 0; u < n; ++u) f(move_vec[u]) = r[u];
+        };
+        scatter("n_proposed", [](move<MCSignType> &m) -> auto & { return m.NProposed; });
+        scatter("n_accepted", [](move<MCSignType> &m) -> auto & { return m.Naccepted; });
+        scatter("n_since_timed", [](move<MCSignType> &m) -> auto & { return m.n_since_timed; });
+        scatter("n_timed", [](move<MCSignType> &m) -> auto & { return m.n_timed; });
+        scatter("n_timed_accepted", [](move<MCSignType> &m) -> auto & { return m.n_timed_accepted; });
+        scatter("t_attempt", [](move<MCSignType> &m) -> auto & { return m.t_attempt; });
+        scatter("t_accept", [](move<MCSignType> &m) -> auto & { return m.t_accept; });
+        scatter("t_reject", [](move<MCSignType> &m) -> auto & { return m.t_reject; });
+        h5_read(gs, "proposition_probabilities", Proba_Moves);
+        h5_read(gs, "n_proposed0", n_proposed0);
+        h5_read(gs, "n_accepted0", n_accepted0);
+        h5_read(gs, "n_timed0", n_timed0);
+        h5_read(gs, "timed_duration0", timed_duration0);
+        if (Proba_Moves.size() != n + 1 or n_proposed0.size() != n or n_accepted0.size() != n or n_timed0.size() != n or timed_duration0.size() != n)
+          TRIQS_RUNTIME_ERROR << "move_set h5_read : the moves do not match the ones of the file";
+        if (n > 0) normaliseProba();
       }
 
     }; // class move_set
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <triqs/mpi/base.hpp>
+#include <array>
+#include <tuple>
+#include <utility>
+#include "./impl_tools.hpp"
+
+namespace triqs {
+  namespace mc_tools {
+
+    /**
+     * A set of measures whose types are known at compile time.
+     *
+     * It models the Measure concept : registered with mc_generic::add_measure, all its measures are
+     * accumulated with a single call, instead of one type erased call per measure.
+     */
+    template <typename MCSignType, typename... Measures> class static_measure_set {
+      static constexpr size_t N = sizeof...(Measures);
+
+      std::tuple<Measures...> measures;
+      std::array<std::string, N> names;
+
+      template <typename F, size_t... Is> void for_each_impl(F &&f, std::index_sequence<Is...>) { (f(std::get<Is>(measures), names[Is]), ...); }
+      template <typename F, size_t... Is> void for_each_impl(F &&f, std::index_sequence<Is...>) const { (f(std::get<Is>(measures), names[Is]), ...); }
+      template <typename F> void for_each(F &&f) { for_each_impl(std::forward<F>(f), std::make_index_sequence<N>{}); }
+      template <typename F> void for_each(F &&f) const { for_each_impl(std::forward<F>(f), std::make_index_sequence<N>{}); }
+
+      public:
+      static_measure_set(std::array<std::string, N> names, Measures... m) : measures(std::move(m)...), names(std::move(names)) {
+        static_assert((has_accumulate<MCSignType, Measures>::value and ...), " A measure has no accumulate method !");
+        static_assert((has_collect_result<Measures>::value and ...), " A measure has no collect_results method !");
+      }
+
+      void accumulate(MCSignType const &sign) {
+        std::apply([&sign](auto &... m) { (m.accumulate(sign), ...); }, measures);
+      }
+
+      void collect_results(mpi::communicator const &c) {
+        std::apply([&c](auto &... m) { (m.collect_results(c), ...); }, measures);
+      }
+
+      /// Access to the measure number I
+      template <size_t I> auto &get() { return std::get<I>(measures); }
+
+      // HDF5 interface : the measures which have one
+      friend void h5_write(h5::group g, std::string const &name, static_measure_set const &ms) {
+        auto gr = g.create_group(name);
+        ms.for_each([&gr](auto const &m, std::string const &n) {
+          if (auto f = make_h5_write(&m)) f(gr, n);
+        });
+      }
+
+      friend void h5_read(h5::group g, std::string const &name, static_measure_set &ms) {
+        auto gr = g.open_group(name);
+        ms.for_each([&gr](auto &m, std::string const &n) {
+          if (auto f = make_h5_read(&m)) f(gr, n);
+        });
+      }
+    };
+
+    /// Make a static_measure_set. Cf constructor
+    template <typename MCSignType, typename... Measures>
+    static_measure_set<MCSignType, std::decay_t<Measures>...> make_static_measure_set(std::array<std::string, sizeof...(Measures)> names,
+                                                                                      Measures &&... m) {
+      return {std::move(names), std::forward<Measures>(m)...};
+    }
+
+  } // namespace mc_tools
+} // namespace triqs
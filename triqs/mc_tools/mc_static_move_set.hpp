@@ -0,0 +1,245 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <triqs/utility/exceptions.hpp>
+#include <triqs/mpi/base.hpp>
+#include <array>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "./random_generator.hpp"
+#include "./impl_tools.hpp"
+#include "./mc_statistics.hpp"
+
+namespace triqs {
+  namespace mc_tools {
+
+    /**
+     * Walker's alias table : draws an index in [0, n[ with given (unnormalized) weights,
+     * in constant time with a single random number.
+     */
+    class alias_table {
+      std::vector<double> prob;
+      std::vector<size_t> alias;
+
+      public:
+      alias_table() = default;
+
+      /// Precondition : weights >= 0, not all 0
+      explicit alias_table(std::vector<double> const &weights) : prob(weights.size(), 1), alias(weights.size()) {
+        size_t n  = weights.size();
+        double wt = 0;
+        for (auto w : weights) {
+          if (!(w >= 0)) TRIQS_RUNTIME_ERROR << "alias_table : negative weight " << w;
+          wt += w;
+        }
+        if (n == 0 or wt <= 0) TRIQS_RUNTIME_ERROR << "alias_table : no positive weight";
+
+        // Vose's construction : pair each bin with p < 1 with a bin with p >= 1 which fills it up to 1
+        std::vector<double> p(n);
+        std::vector<size_t> small, large;
+        for (size_t i = 0; i < n; ++i) {
+          p[i]     = weights[i] * n / wt;
+          alias[i] = i;
+          (p[i] < 1 ? small : large).push_back(i);
+        }
+        while (!small.empty() and !large.empty()) {
+          size_t s = small.back(), l = large.back();
+          small.pop_back();
+          large.pop_back();
+          prob[s]  = p[s];
+          alias[s] = l;
+          p[l] += p[s] - 1;
+          (p[l] < 1 ? small : large).push_back(l);
+        }
+        // the remaining bins are full (up to rounding errors), prob = 1
+      }
+
+      /// Number of indices
+      size_t size() const { return prob.size(); }
+
+      /// The index for a random number u in [0,1[
+      size_t operator()(double u) const {
+        double x = u * prob.size();
+        size_t i = std::min(size_t(x), prob.size() - 1), a = alias[i];
+        return (x - i < prob[i] ? i : a); // both loaded : a conditional move, not a branch
+      }
+    };
+
+    //--------------------------------------------------------------------
+
+    /**
+     * A set of moves whose types are known at compile time, with their proposition probabilities.
+     *
+     * It models the Move concept. Unlike move_set, there is no type erasure : the move is chosen with an
+     * alias_table and the calls to attempt, accept, reject are dispatched with a switch on the index of the move,
+     * and can be inlined. Use it with mc_generic::set_static_moves for cheap moves.
+     */
+    template <typename MCSignType, typename... Moves> class static_move_set {
+      static constexpr size_t N = sizeof...(Moves);
+      using seq_t               = std::make_index_sequence<N>;
+
+      std::tuple<Moves...> moves;
+      std::array<std::string, N> names;
+      alias_table select;
+      random_generator *rng;
+      size_t current            = 0;
+      MCSignType try_sign_ratio = 1;
+      std::array<uint64_t, N> n_proposed = {}, n_accepted = {};
+      std::array<double, N> acceptance_rates;
+
+      // Call f on the move number i
+      template <typename F, size_t... Is> void visit_impl(size_t i, F &&f, std::index_sequence<Is...>) {
+        (void)((i == Is ? (f(std::get<Is>(moves)), true) : false) || ...);
+      }
+      template <typename F> void visit(size_t i, F &&f) { visit_impl(i, std::forward<F>(f), seq_t{}); }
+
+      // Call f on all the moves, with their names
+      template <typename F, size_t... Is> void for_each_impl(F &&f, std::index_sequence<Is...>) { (f(std::get<Is>(moves), names[Is]), ...); }
+      template <typename F, size_t... Is> void for_each_impl(F &&f, std::index_sequence<Is...>) const { (f(std::get<Is>(moves), names[Is]), ...); }
+      template <typename F> void for_each(F &&f) { for_each_impl(std::forward<F>(f), seq_t{}); }
+      template <typename F> void for_each(F &&f) const { for_each_impl(std::forward<F>(f), seq_t{}); }
+
+      public:
+      /**
+       * @param rng                        The random generator, e.g. mc.get_rng()
+       * @param names                      The names of the moves
+       * @param proposition_probabilities  Probabilities that the moves are proposed (>=0, not normalized)
+       * @param m                          The moves
+       */
+      static_move_set(random_generator &rng, std::array<std::string, N> names, std::array<double, N> const &proposition_probabilities, Moves... m)
+         : moves(std::move(m)...), names(std::move(names)), select({proposition_probabilities.begin(), proposition_probabilities.end()}), rng(&rng) {
+        static_assert((has_attempt<MCSignType, Moves>::value and ...), "A move has no attempt method (or is has an incorrect signature) !");
+        static_assert((has_accept<MCSignType, Moves>::value and ...), "A move has no accept method (or is has an incorrect signature) !");
+        static_assert((has_reject<Moves>::value and ...), "A move has no reject method (or is has an incorrect signature) !");
+        acceptance_rates.fill(-1);
+      }
+
+      static_move_set(static_move_set const &) = delete;
+      static_move_set(static_move_set &&)      = default;
+      static_move_set &operator=(static_move_set const &) = delete;
+      static_move_set &operator=(static_move_set &&) = default;
+
+      private:
+      // Absolute value of the ratio returned by attempt, keeping its sign in try_sign_ratio (cf move_set)
+      double abs_ratio(MCSignType rate_ratio) {
+        if constexpr (std::is_floating_point<MCSignType>::value) {
+          if (std::isinf(rate_ratio)) {
+            try_sign_ratio = (std::signbit(rate_ratio) ? -1 : 1);
+            return 100; // > 1 for metropolis
+          }
+        }
+        double abs_rate_ratio = std::abs(rate_ratio);
+        if (!std::isfinite(abs_rate_ratio))
+          TRIQS_RUNTIME_ERROR << "Monte Carlo Error : the rate (" << rate_ratio << ") is not finite in move " << names[current];
+        try_sign_ratio = (abs_rate_ratio > 1.e-14 ? rate_ratio / abs_rate_ratio : 1); // keep the sign
+        return abs_rate_ratio;
+      }
+
+      public:
+      /// Picks up a move at random, calls its attempt and returns the absolute value of the ratio (cf move_set)
+      double attempt() {
+        current = select((*rng)());
+        ++n_proposed[current];
+        MCSignType rate_ratio = 1;
+        visit(current, [&rate_ratio](auto &m) { rate_ratio = m.attempt(); });
+        return abs_ratio(rate_ratio);
+      }
+
+      /// Accepts the move selected by attempt. Returns the sign (cf move_set)
+      MCSignType accept() {
+        ++n_accepted[current];
+        MCSignType accept_sign_ratio = 1;
+        visit(current, [&accept_sign_ratio](auto &m) { accept_sign_ratio = m.accept(); });
+        return try_sign_ratio * accept_sign_ratio;
+      }
+
+      /// Rejects the move selected by attempt
+      void reject() {
+        visit(current, [](auto &m) { m.reject(); });
+      }
+
+      /// Reduces the acceptance rates on c, and calls collect_statistics of the moves which have one
+      void collect_statistics(mpi::communicator c) {
+        for (size_t u = 0; u < N; ++u) {
+          uint64_t nacc_tot   = mpi::reduce(n_accepted[u], c);
+          uint64_t nprop_tot  = mpi::reduce(n_proposed[u], c);
+          acceptance_rates[u] = nacc_tot / static_cast<double>(nprop_tot);
+        }
+        for_each([&c](auto &m, auto const &) {
+          if (auto f = make_collect_statistics(&m)) f(c);
+        });
+      }
+
+      /// Acceptance rate of all moves as a map name:string -> acceptance_rate:double
+      std::map<std::string, double> get_acceptance_rates() const {
+        std::map<std::string, double> r;
+        for (size_t u = 0; u < N; ++u) r.insert({names[u], acceptance_rates[u]});
+        return r;
+      }
+
+      /// Pretty printing of the acceptance probability of the moves.
+      std::string get_statistics(std::string decal = "") const {
+        std::ostringstream s;
+        for (size_t u = 0; u < N; ++u) s << decal << "Move " << names[u] << ": " << acceptance_rates[u] << "\n";
+        return s.str();
+      }
+
+      /// Number of times each move has been proposed and accepted, on this process
+      std::array<uint64_t, N> const &get_n_proposed() const { return n_proposed; }
+      std::array<uint64_t, N> const &get_n_accepted() const { return n_accepted; }
+
+      /// Append the counters of the moves on this process to r. The moves are not timed : the times are 0.
+      void fill_statistics(std::vector<mc_statistics::move_stat> &r) const {
+        for (size_t u = 0; u < N; ++u) r.push_back({names[u], n_proposed[u], n_accepted[u]});
+      }
+
+      /// Access to the move number I
+      template <size_t I> auto &get() { return std::get<I>(moves); }
+
+      // HDF5 interface : the moves which have one
+      friend void h5_write(h5::group g, std::string const &name, static_move_set const &ms) {
+        auto gr = g.create_group(name);
+        ms.for_each([&gr](auto const &m, std::string const &n) {
+          if (auto f = make_h5_write(&m)) f(gr, n);
+        });
+      }
+
+      friend void h5_read(h5::group g, std::string const &name, static_move_set &ms) {
+        auto gr = g.open_group(name);
+        ms.for_each([&gr](auto &m, std::string const &n) {
+          if (auto f = make_h5_read(&m)) f(gr, n);
+        });
+      }
+    };
+
+    /// Make a static_move_set. Cf constructor
+    template <typename MCSignType, typename... Moves>
+    static_move_set<MCSignType, std::decay_t<Moves>...> make_static_move_set(random_generator &rng, std::array<std::string, sizeof...(Moves)> names,
+                                                                             std::array<double, sizeof...(Moves)> const &proposition_probabilities,
+                                                                             Moves &&... m) {
+      return {rng, std::move(names), proposition_probabilities, std::forward<Moves>(m)...};
+    }
+
+  } // namespace mc_tools
+} // namespace triqs
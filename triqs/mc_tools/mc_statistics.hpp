@@ -0,0 +1,175 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include <triqs/mpi/vector.hpp>
+#include <triqs/h5.hpp>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace triqs {
+  namespace mc_tools {
+
+    /**
+     * Statistics of a Monte Carlo run : counters and timings of the moves and the measures, and the times of the run.
+     *
+     * Obtained with mc_generic::get_run_statistics, which reduces them over the processes.
+     * The times of the moves are estimated from one attempt in timing_period (cf mc_generic::set_move_timing_period),
+     * with its accept or reject.
+     */
+    struct mc_statistics {
+
+      struct move_stat {
+        std::string name; // the path of the move, e.g. "outer/inner" for a move in the move set outer
+        uint64_t n_proposed = 0, n_accepted = 0;
+        double time_attempt = 0, time_accept = 0, time_reject = 0; // estimated time in seconds (0 if not timed)
+        double acceptance_rate() const { return (n_proposed ? n_accepted / double(n_proposed) : 0); }
+      };
+
+      struct measure_stat {
+        std::string name;
+        uint64_t count = 0;
+        double time    = 0; // in seconds (0 if the timer of the measure is disabled)
+      };
+
+      std::vector<move_stat> moves;       // flattened : the moves of a move set follow the move set itself
+      std::vector<measure_stat> measures; // in the order of the names
+      uint64_t n_cycles = 0, n_measures = 0;
+      double warmup_time = 0, accumulation_time = 0;         // sum over the processes
+      double warmup_time_max = 0, accumulation_time_max = 0; // max over the processes
+      int n_processes = 1;
+
+      /**
+       * Sum the counters and times over the processes of c (max for the *_max times), in place, on all processes.
+       * Collective. Precondition : the same moves and measures on all processes.
+       */
+      void all_reduce(mpi::communicator c) {
+        std::vector<uint64_t> n;
+        std::vector<double> t;
+        for (auto const &m : moves) {
+          n.insert(n.end(), {m.n_proposed, m.n_accepted});
+          t.insert(t.end(), {m.time_attempt, m.time_accept, m.time_reject});
+        }
+        for (auto const &m : measures) {
+          n.push_back(m.count);
+          t.push_back(m.time);
+        }
+        n.insert(n.end(), {n_cycles, n_measures});
+        t.insert(t.end(), {warmup_time, accumulation_time});
+        n = mpi::mpi_reduce(n, c, 0, true);
+        t = mpi::mpi_reduce(t, c, 0, true);
+        std::vector<double> tmax = mpi::mpi_reduce(std::vector<double>{warmup_time_max, accumulation_time_max}, c, 0, true, MPI_MAX);
+
+        auto pn = n.begin();
+        auto pt = t.begin();
+        for (auto &m : moves) {
+          m.n_proposed   = *pn++;
+          m.n_accepted   = *pn++;
+          m.time_attempt = *pt++;
+          m.time_accept  = *pt++;
+          m.time_reject  = *pt++;
+        }
+        for (auto &m : measures) {
+          m.count = *pn++;
+          m.time  = *pt++;
+        }
+        n_cycles              = *pn++;
+        n_measures            = *pn++;
+        warmup_time           = *pt++;
+        accumulation_time     = *pt++;
+        warmup_time_max       = tmax[0];
+        accumulation_time_max = tmax[1];
+        n_processes           = c.size();
+      }
+
+      /// A JSON document with all the statistics
+      std::string to_json() const {
+        std::ostringstream s;
+        s << std::setprecision(std::numeric_limits<double>::max_digits10);
+        s << "{\n  \"n_processes\": " << n_processes << ",\n  \"n_cycles\": " << n_cycles << ",\n  \"n_measures\": " << n_measures
+          << ",\n  \"warmup_time\": " << warmup_time << ",\n  \"warmup_time_max\": " << warmup_time_max << ",\n  \"accumulation_time\": "
+          << accumulation_time << ",\n  \"accumulation_time_max\": " << accumulation_time_max << ",\n  \"moves\": [";
+        for (size_t i = 0; i < moves.size(); ++i) {
+          auto const &m = moves[i];
+          s << (i ? "," : "") << "\n    {\"name\": " << json_string(m.name) << ", \"n_proposed\": " << m.n_proposed << ", \"n_accepted\": " << m.n_accepted
+            << ", \"acceptance_rate\": " << m.acceptance_rate() << ", \"time_attempt\": " << m.time_attempt << ", \"time_accept\": " << m.time_accept
+            << ", \"time_reject\": " << m.time_reject << "}";
+        }
+        s << (moves.empty() ? "" : "\n  ") << "],\n  \"measures\": [";
+        for (size_t i = 0; i < measures.size(); ++i) {
+          auto const &m = measures[i];
+          s << (i ? "," : "") << "\n    {\"name\": " << json_string(m.name) << ", \"count\": " << m.count << ", \"time\": " << m.time << "}";
+        }
+        s << (measures.empty() ? "" : "\n  ") << "]\n}\n";
+        return s.str();
+      }
+
+      // HDF5 interface
+      friend void h5_write(h5::group g, std::string const &name, mc_statistics const &st) {
+        auto gr = g.create_group(name);
+        h5_write(gr, "n_processes", st.n_processes);
+        h5_write(gr, "n_cycles", st.n_cycles);
+        h5_write(gr, "n_measures", st.n_measures);
+        h5_write(gr, "warmup_time", st.warmup_time);
+        h5_write(gr, "warmup_time_max", st.warmup_time_max);
+        h5_write(gr, "accumulation_time", st.accumulation_time);
+        h5_write(gr, "accumulation_time_max", st.accumulation_time_max);
+        // the moves of a move set in the subgroup of the move set (written before them), e.g. moves/outer/inner
+        auto gmo = gr.create_group("moves");
+        for (auto const &m : st.moves) {
+          auto gm = gmo.create_group(m.name);
+          h5_write(gm, "n_proposed", m.n_proposed);
+          h5_write(gm, "n_accepted", m.n_accepted);
+          h5_write(gm, "time_attempt", m.time_attempt);
+          h5_write(gm, "time_accept", m.time_accept);
+          h5_write(gm, "time_reject", m.time_reject);
+        }
+        auto gme = gr.create_group("measures");
+        for (auto const &m : st.measures) {
+          auto gm = gme.create_group(m.name);
+          h5_write(gm, "count", m.count);
+          h5_write(gm, "time", m.time);
+        }
+      }
+
+      private:
+      static std::string json_string(std::string const &x) {
+        std::string r = "\"";
+        for (char ch : x) {
+          if (ch == '"' or ch == '\\') {
+            r += '\\';
+            r += ch;
+          } else if (static_cast<unsigned char>(ch) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            r += buf;
+          } else
+            r += ch;
+        }
+        return r + "\"";
+      }
+    };
+
+  } // namespace mc_tools
+} // namespace triqs
@@ -20,6 +20,9 @@
  ******************************************************************************/
 #include "random_generator.hpp"
 #include "./MersenneRNG.hpp"
+#include "../h5/string.hpp"
+#include "../h5/vector.hpp"
+#include "../h5/scalar.hpp"
 //#include <boost/random/uniform_int.hpp>
 #include <boost/random/uniform_real.hpp>
 #include <boost/random/mersenne_twister.hpp>
@@ -27,6 +30,7 @@
 #include <boost/random/ranlux.hpp>
 #include <boost/random/variate_generator.hpp>
 #include <sstream>
+#include <memory>
 #include <boost/preprocessor/seq.hpp>
 #include <boost/preprocessor/control/if.hpp>
 
@@ -38,11 +42,32 @@
 namespace triqs {
   namespace mc_tools {
 
+    namespace {
+      // The engine is shared by the buffered function and the accessors of its state.
+      // NB : the copy constructor of random_generator is not implemented, so the engine is never shared between two generators.
+      template <typename G, typename Engine>
+      void set_generator(utility::buffered_function<double> &gen, std::function<std::string()> &get_state,
+                         std::function<void(std::string const &)> &set_state, std::shared_ptr<G> g, Engine &(*engine)(G &)) {
+        gen       = utility::buffered_function<double>([g]() { return (*g)(); });
+        get_state = [g, engine]() {
+          std::ostringstream out;
+          out << engine(*g) << ' '; // the separator prevents the reading from hitting the end of the string
+          return out.str();
+        };
+        set_state = [g, engine](std::string const &st) {
+          std::istringstream in(st);
+          in >> engine(*g);
+          if (!in) TRIQS_RUNTIME_ERROR << "random_generator : can not read the state of the engine";
+        };
+      }
+    } // namespace
+
     random_generator::random_generator(std::string const &RandomGeneratorName, uint32_t seed_) {
       _name = RandomGeneratorName;
 
       if (RandomGeneratorName == "") {
-        gen = utility::buffered_function<double>(mc_tools::RandomGenerators::RandMT(seed_));
+        using G = mc_tools::RandomGenerators::RandMT;
+        set_generator(gen, _get_engine_state, _set_engine_state, std::make_shared<G>(seed_), +[](G &x) -> G & { return x; });
         return;
       }
 
@@ -54,7 +79,9 @@ namespace triqs {
 // now boost random number generators
 #define DRNG(r, data, XX)                                                                                                                            \
   if (RandomGeneratorName == AS_STRING(XX)) {                                                                                                        \
-    gen = utility::buffered_function<double>(boost::variate_generator<boost::XX, boost::uniform_real<>>(boost::XX(seed_), dis));                     \
+    using G     = boost::variate_generator<boost::XX, boost::uniform_real<>>;                                                                        \
+    auto engine = +[](G &x) -> boost::XX & { return x.engine(); };                                                                                   \
+    set_generator(gen, _get_engine_state, _set_engine_state, std::make_shared<G>(boost::XX(seed_), dis), engine);                                    \
     return;                                                                                                                                          \
   }
 
@@ -65,6 +92,32 @@ namespace triqs {
 
     //---------------------------------------------
 
+    void h5_write(h5::group g, std::string const &name, random_generator const &r) {
+      auto gr = g.create_group(name);
+      h5_write(gr, "name", r._name);
+      h5_write(gr, "engine", r._get_engine_state());
+      auto [buffer, index] = r.gen.get_buffer();
+      h5_write(gr, "buffer", buffer);
+      h5_write(gr, "index", long(index));
+    }
+
+    void h5_read(h5::group g, std::string const &name, random_generator &r) {
+      auto gr = g.open_group(name);
+      std::string rng_name, state;
+      h5_read(gr, "name", rng_name);
+      if (rng_name != r._name) r = random_generator(rng_name, 0);
+      h5_read(gr, "engine", state);
+      r._set_engine_state(state);
+      std::vector<double> buffer;
+      long index;
+      h5_read(gr, "buffer", buffer);
+      h5_read(gr, "index", index);
+      if (buffer.empty() or index < 0 or index > long(buffer.size())) TRIQS_RUNTIME_ERROR << "random_generator : invalid buffer in " << name;
+      r.gen.set_buffer(std::move(buffer), index);
+    }
+
+    //---------------------------------------------
+
     std::string random_generator_names(std::string const &sep) {
 #define PR(r, sep, p, XX) BOOST_PP_IF(p, +sep +, ) std::string(AS_STRING(XX))
       return BOOST_PP_SEQ_FOR_EACH_I(PR, sep, RNG_LIST);
@@ -22,6 +22,7 @@
 #include <triqs/utility/first_include.hpp>
 #include "../utility/exceptions.hpp"
 #include "../utility/buffered_function.hpp"
+#include "../h5/group.hpp"
 #include "math.h"
 #include <string>
 #include <assert.h>
@@ -43,6 +44,8 @@ namespace triqs {
     class random_generator {
       utility::buffered_function<double> gen;
       std::string _name;
+      std::function<std::string()> _get_engine_state;            // the state of the engine, as written by its operator <<
+      std::function<void(std::string const &)> _set_engine_state; // and read back by its operator >>
 
       public:
       /** Constructor
@@ -82,6 +85,16 @@ namespace triqs {
         assert(b > a);
         return a + (b - a) * (gen());
       }
+
+      /**
+       * HDF5 interface : the name of the generator, the state of the engine and the content of the buffer.
+       *
+       * After h5_read, the generator produces exactly the same numbers as the one which was written.
+       */
+      friend void h5_write(h5::group g, std::string const &name, random_generator const &r);
+
+      /// HDF5 interface
+      friend void h5_read(h5::group g, std::string const &name, random_generator &r);
     };
   } // namespace mc_tools
 } // namespace triqs
@@ -88,6 +88,23 @@ namespace triqs {
         return c;
       }
 
+      /**
+       * Free the communicator, made by split or split_shared. It is then MPI_COMM_NULL. Collective.
+       *
+       * The communicator is a handle : the copies are not freed, and must not be used afterwards.
+       * Nothing is done for MPI_COMM_NULL, MPI_COMM_WORLD and MPI_COMM_SELF.
+       */
+      void free() {
+        if (_com != MPI_COMM_NULL and _com != MPI_COMM_WORLD and _com != MPI_COMM_SELF) MPI_Comm_free(&_com);
+      }
+
+      /// Split into communicators of the processes which can share memory, i.e. the processes of the same node
+      communicator split_shared(int key = 0) const {
+        communicator c;
+        MPI_Comm_split_type(_com, MPI_COMM_TYPE_SHARED, key, MPI_INFO_NULL, &c._com);
+        return c;
+      }
+
       void barrier() const { MPI_Barrier(_com); }
     };
 
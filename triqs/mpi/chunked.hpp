@@ -0,0 +1,135 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include "./base.hpp"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace triqs::mpi {
+
+  /*
+   * Collectives on buffers of any size
+   *
+   * MPI counts and displacements are int : a message of more than 2^31 elements
+   * (e.g. a vertex, or G(k, iw) on a large k mesh) would silently overflow.
+   * These functions take long counts and
+   *  - split the broadcasts and reductions in several calls of at most max_count elements,
+   *  - use point-to-point messages of at most max_count elements for the scatter and gather
+   *    when the displacements do not fit in an int.
+   * They are used by the mpi functions of std::vector and arrays.
+   */
+
+  /// Largest number of elements in a single MPI call. It can be lowered, e.g. to test the large messages.
+  inline long max_count = std::numeric_limits<int>::max();
+
+  namespace details {
+    constexpr int chunked_tag = 4321; // tag of the point-to-point messages
+
+    template <typename T> void send_n(T const *p, long n, int dest, communicator c) {
+      for (long k = 0; k < n; k += max_count)
+        MPI_Send((void *)(p + k), std::min(max_count, n - k), mpi_datatype<T>(), dest, chunked_tag, c.get());
+    }
+
+    template <typename T> void recv_n(T *p, long n, int source, communicator c) {
+      for (long k = 0; k < n; k += max_count)
+        MPI_Recv(p + k, std::min(max_count, n - k), mpi_datatype<T>(), source, chunked_tag, c.get(), MPI_STATUS_IGNORE);
+    }
+
+    inline std::vector<int> to_int(std::vector<long> const &v) { return {v.begin(), v.end()}; }
+  } // namespace details
+
+  /// Broadcast the n elements at p from root
+  template <typename T> void broadcast_n(T *p, long n, communicator c = {}, int root = 0) {
+    for (long k = 0; k < n; k += max_count) MPI_Bcast(p + k, std::min(max_count, n - k), mpi_datatype<T>(), root, c.get());
+  }
+
+  /**
+   * Reduce the n elements at in into out, on root (or on all nodes if all).
+   * If in == out, the reduction is done in place.
+   * out is not used on the nodes which do not receive the result.
+   */
+  template <typename T> void reduce_n(T const *in, T *out, long n, communicator c = {}, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
+    bool in_place = (in == out);
+    bool receive  = (all or c.rank() == root);
+    auto D        = mpi_datatype<T>();
+    for (long k = 0; k < n; k += max_count) {
+      int m      = std::min(max_count, n - k);
+      void *in_k = (void *)(in + k), *out_k = (receive ? out + k : nullptr);
+      if (!all)
+        MPI_Reduce((in_place and receive ? MPI_IN_PLACE : in_k), out_k, m, D, op, root, c.get());
+      else
+        MPI_Allreduce((in_place ? MPI_IN_PLACE : in_k), out_k, m, D, op, c.get());
+    }
+  }
+
+  /**
+   * Scatter from root : node r receives in recvbuf the counts[r] elements at sendbuf + displs[r].
+   * counts and displs must be the same on all nodes. displs has one more element, the total count.
+   */
+  template <typename T>
+  void scatterv_n(T const *sendbuf, std::vector<long> const &counts, std::vector<long> const &displs, T *recvbuf, communicator c = {}, int root = 0) {
+    long total = displs[c.size()], rank = c.rank();
+    if (total <= max_count) {
+      auto counts_i = details::to_int(counts), displs_i = details::to_int(displs);
+      MPI_Scatterv((void *)sendbuf, counts_i.data(), displs_i.data(), mpi_datatype<T>(), recvbuf, counts[rank], mpi_datatype<T>(), root, c.get());
+    } else if (rank == root) {
+      for (int r = 0; r < c.size(); ++r)
+        if (r != root) details::send_n(sendbuf + displs[r], counts[r], r, c);
+      std::copy(sendbuf + displs[root], sendbuf + displs[root] + counts[root], recvbuf);
+    } else
+      details::recv_n(recvbuf, counts[rank], root, c);
+  }
+
+  /**
+   * Gather on root (or on all nodes if all) : the sendcount elements of sendbuf on node r are received at recvbuf + displs[r].
+   * counts (counts[r] is sendcount on node r) and displs must be the same on all nodes, cf all_counts_and_displs.
+   */
+  template <typename T>
+  void gatherv_n(T const *sendbuf, long sendcount, T *recvbuf, std::vector<long> const &counts, std::vector<long> const &displs, communicator c = {},
+                 int root = 0, bool all = false) {
+    long total = displs[c.size()], rank = c.rank();
+    if (total <= max_count) {
+      auto counts_i = details::to_int(counts), displs_i = details::to_int(displs);
+      if (!all)
+        MPI_Gatherv((void *)sendbuf, sendcount, mpi_datatype<T>(), recvbuf, counts_i.data(), displs_i.data(), mpi_datatype<T>(), root, c.get());
+      else
+        MPI_Allgatherv((void *)sendbuf, sendcount, mpi_datatype<T>(), recvbuf, counts_i.data(), displs_i.data(), mpi_datatype<T>(), c.get());
+      return;
+    }
+    if (rank == root) {
+      for (int r = 0; r < c.size(); ++r)
+        if (r != root) details::recv_n(recvbuf + displs[r], counts[r], r, c);
+      std::copy(sendbuf, sendbuf + sendcount, recvbuf + displs[root]);
+    } else
+      details::send_n(sendbuf, sendcount, root, c);
+    if (all) broadcast_n(recvbuf, total, c, root);
+  }
+
+  /// The counts of all nodes, and the corresponding displacements (one more element, the total)
+  inline std::pair<std::vector<long>, std::vector<long>> all_counts_and_displs(long count, communicator c = {}) {
+    std::vector<long> counts(c.size()), displs(c.size() + 1, 0);
+    MPI_Allgather(&count, 1, mpi_datatype<long>(), counts.data(), 1, mpi_datatype<long>(), c.get());
+    for (int r = 0; r < c.size(); ++r) displs[r + 1] = displs[r] + counts[r];
+    return {counts, displs};
+  }
+
+} // namespace triqs::mpi
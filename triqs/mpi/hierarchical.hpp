@@ -0,0 +1,114 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include "./base.hpp"
+#include "./chunked.hpp"
+#include <utility>
+#include <vector>
+
+namespace triqs::mpi {
+
+  /**
+   * The processes of a communicator, grouped by node
+   *
+   *  - node : the processes of the same node as this one (e.g. c.split_shared()). Its rank 0 is the node leader.
+   *  - leaders : the leaders of all nodes (MPI_COMM_NULL on the other processes).
+   *
+   * Splitting a communicator is a costly collective : the topology is built once, e.g. at the start of the run,
+   * and reused for all the hierarchical reductions. It frees its communicators when destroyed.
+   */
+  class node_topology {
+    communicator _c, _node, _leaders = MPI_COMM_NULL;
+    std::vector<int> _node_leader; // [rank in c] -> rank of its node leader in leaders
+    std::vector<int> _node_rank;   // [rank in c] -> its rank in its node
+
+    public:
+    /// Group the processes of c by node, i.e. by shared memory
+    explicit node_topology(communicator c = {}) : node_topology(c, c.split_shared(c.rank())) {}
+
+    /// Group the processes of c by node_comm, any split of c (e.g. to emulate several nodes on one machine). Takes ownership of node_comm.
+    node_topology(communicator c, communicator node_comm) : _c(c), _node(node_comm), _node_leader(c.size()), _node_rank(c.size()) {
+      bool leader = (_node.rank() == 0);
+      _leaders    = c.split(leader ? 0 : MPI_UNDEFINED, c.rank());
+      int me[2]   = {(leader ? _leaders.rank() : 0), _node.rank()};
+      MPI_Bcast(me, 1, MPI_INT, 0, _node.get()); // the leader rank, known by the leader only
+      std::vector<int> all(2 * c.size());
+      MPI_Allgather(me, 2, MPI_INT, all.data(), 2, MPI_INT, c.get());
+      for (int r = 0; r < c.size(); ++r) {
+        _node_leader[r] = all[2 * r];
+        _node_rank[r]   = all[2 * r + 1];
+      }
+    }
+
+    node_topology(node_topology const &) = delete;
+    node_topology &operator=(node_topology const &) = delete;
+
+    ~node_topology() {
+      _node.free();
+      _leaders.free();
+    }
+
+    /// The communicator which has been split
+    communicator const &comm() const { return _c; }
+
+    /// The processes of this node
+    communicator const &node() const { return _node; }
+
+    /// The node leaders. Only valid on the leaders
+    communicator const &leaders() const { return _leaders; }
+
+    /// Is this process the leader of its node
+    bool is_leader() const { return _node_rank[_c.rank()] == 0; }
+
+    /// Rank in leaders() of the leader of the node of process r (rank in comm())
+    int node_leader_of(int r) const { return _node_leader[r]; }
+
+    /// Rank in its node of process r (rank in comm())
+    int node_rank_of(int r) const { return _node_rank[r]; }
+  };
+
+  /**
+   * Reduce in place the n elements at p on root (rank in t.comm()), or on all processes if all, in three steps :
+   *  1. reduction within each node, on the node leader,
+   *  2. reduction between the node leaders, on the leader of the node of root (on all leaders if all),
+   *  3. broadcast within each node (if all), or copy from the leader to root.
+   * Only one message per node goes through the network, instead of one per process.
+   * p is used as a buffer on all processes : it is only meaningful on root (or on all processes if all) on return.
+   */
+  template <typename T> void hierarchical_reduce_n(T *p, long n, node_topology const &t, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
+    reduce_n(p, p, n, t.node(), 0, false, op);
+    if (t.is_leader()) reduce_n(p, p, n, t.leaders(), t.node_leader_of(root), all, op);
+    if (all) {
+      broadcast_n(p, n, t.node(), 0);
+      return;
+    }
+    int root_in_node = t.node_rank_of(root);
+    if (root_in_node == 0 or t.node_leader_of(root) != t.node_leader_of(t.comm().rank())) return;
+    if (t.is_leader()) details::send_n(p, n, root_in_node, t.node());
+    if (t.comm().rank() == root) details::recv_n(p, n, 0, t.node());
+  }
+
+  /// Hierarchical all reduce in place, for any x for which mpi_hierarchical_reduce is defined
+  template <typename T> void mpi_hierarchical_all_reduce(T &&x, node_topology const &t, int root = 0, MPI_Op op = MPI_SUM) {
+    mpi_hierarchical_reduce(std::forward<T>(x), t, root, true, op);
+  }
+
+} // namespace triqs::mpi
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include "./base.hpp"
+#include "./chunked.hpp"
+#include "./hierarchical.hpp"
+#include "./request.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <type_traits>
+
+namespace triqs::mpi {
+
+  /*
+   * Packed reductions
+   *
+   * A collection of objects (e.g. the blocks of a block_gf) is reduced with a single collective
+   * instead of one per object : their data is copied into one contiguous buffer, reduced, and copied back.
+   *
+   * An object x can be packed if mpi_pack_data(x) (found by ADL) returns an iterable range of a basic type,
+   * e.g. the array itself for arrays, the data array for gf. Nested std::vector of such objects can also be packed.
+   * The data are packed and unpacked in the iteration order of the range : the objects which are packed
+   * and the ones in which the result is unpacked must have the same shapes.
+   */
+
+  namespace details {
+    template <typename X, typename Enable = void> struct has_mpi_pack_data : std::false_type {};
+    template <typename X> struct has_mpi_pack_data<X, std::void_t<decltype(mpi_pack_data(std::declval<X &>()))>> : std::true_type {};
+
+    template <typename X, bool = has_mpi_pack_data<X>::value> struct packed_value_impl { using type = void; };
+    template <typename X> struct packed_value_impl<X, true> {
+      using type = std::decay_t<decltype(*std::begin(mpi_pack_data(std::declval<X &>())))>;
+    };
+    template <typename X> struct packed_value_impl<std::vector<X>, false> : packed_value_impl<X> {};
+
+    // Number of elements of x in the buffer
+    template <typename X> size_t packed_size(X const &x) {
+      if constexpr (has_mpi_pack_data<X const>::value) {
+        return std::size(mpi_pack_data(x));
+      } else {
+        size_t n = 0;
+        for (auto const &y : x) n += packed_size(y);
+        return n;
+      }
+    }
+
+    template <typename R, typename Enable = void> struct has_data_start : std::false_type {};
+    template <typename R>
+    struct has_data_start<R, std::void_t<decltype(std::declval<R &>().data_start()), decltype(std::declval<R &>().indexmap().is_contiguous())>>
+       : std::true_type {};
+
+    // Pointer to the data of the range r if they are contiguous and stored in its iteration order (e.g. an array in C order), nullptr otherwise
+    template <typename T, typename R> T *contiguous_data(R &r) {
+      if constexpr (has_data_start<R>::value) {
+        using traversal_t = typename std::decay_t<decltype(r.indexmap())>::traversal_order_in_template;
+        if constexpr (std::is_void_v<traversal_t> and std::is_convertible_v<decltype(r.data_start()), T *>) {
+          if (r.indexmap().is_contiguous() and r.indexmap().memory_layout_is_c()) return r.data_start();
+        }
+      }
+      return nullptr;
+    }
+  } // namespace details
+
+  /// The basic type of the packed data of X (void if X can not be packed)
+  template <typename X> using packed_value_t = typename details::packed_value_impl<std::decay_t<X>>::type;
+
+  /// Can X be packed in a packed_reduce
+  template <typename X> constexpr bool is_packable_v = is_basic<packed_value_t<X>>::value;
+
+  // ------------------------------------------------------------
+
+  /**
+   * Buffer for the packed reduction of data of type T
+   *
+   * @code
+   *  packed_reduce<dcomplex> p;
+   *  for (auto const &g : v) p.pack(g); // copy all data in the buffer
+   *  if (p.reduce(c, root, all, op)) p.unpack(v);  // reduce them at once, and copy back the result
+   * @endcode
+   */
+  template <typename T> class packed_reduce {
+    static_assert(is_basic<T>::value, "packed_reduce : only for basic types");
+    std::vector<T> buffer;
+    size_t pos = 0;
+
+    // Copy the data of x into the buffer from position n, which is large enough. Returns the position after them.
+    template <typename X> size_t pack_at(X const &x, size_t n) {
+      if constexpr (details::has_mpi_pack_data<X const>::value) {
+        auto const &r = mpi_pack_data(x);
+        size_t s      = std::size(r);
+        if (s == 0) return n;
+        if (auto *p = details::contiguous_data<T const>(r))
+          std::memcpy(buffer.data() + n, p, s * sizeof(T));
+        else
+          std::copy(std::begin(r), std::end(r), buffer.begin() + n);
+        return n + s;
+      } else {
+        for (auto const &y : x) n = pack_at(y, n);
+        return n;
+      }
+    }
+
+    // Copy the elements of the buffer from pos into the data of x, which the buffer has been checked to contain
+    template <typename X> void unpack_from_pos(X &x) {
+      if constexpr (details::has_mpi_pack_data<X>::value) {
+        auto &&r = mpi_pack_data(x);
+        size_t s = std::size(r);
+        if (s == 0) return;
+        if (auto *p = details::contiguous_data<T>(r))
+          std::memcpy(p, buffer.data() + pos, s * sizeof(T));
+        else
+          std::copy_n(buffer.begin() + pos, s, std::begin(r));
+        pos += s;
+      } else {
+        for (auto &y : x) unpack_from_pos(y);
+      }
+    }
+
+    public:
+    /// Copy the data of x at the end of the buffer
+    template <typename X> void pack(X const &x) {
+      size_t n = buffer.size();
+      buffer.resize(n + details::packed_size(x));
+      pack_at(x, n);
+    }
+
+    /// Copy the next elements of the buffer into the data of x
+    template <typename X> void unpack(X &x) {
+      if (pos + details::packed_size(x) > buffer.size()) throw std::out_of_range("packed_reduce::unpack : the buffer is too small for the object");
+      unpack_from_pos(x);
+    }
+
+    // Start a non-blocking reduction of the buffer, cf request
+    std::vector<MPI_Request> start_ireduce(communicator c, int root, bool all, MPI_Op op) {
+      pos = 0;
+      return details::start_ireduce(buffer.data(), buffer.data(), buffer.size(), c, root, all, op);
+    }
+
+    /// Number of elements in the buffer
+    size_t size() const { return buffer.size(); }
+
+    /**
+     * Reduce the buffer over the nodes, with a single MPI_Reduce (or MPI_Allreduce if all)
+     *
+     * @return true iif the result is available on this node, i.e. it is the root or all is true
+     */
+    bool reduce(communicator c = {}, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
+      pos = 0;
+      reduce_n(buffer.data(), buffer.data(), buffer.size(), c, root, all, op);
+      return (all or c.rank() == root);
+    }
+
+    /// Same as reduce, with a hierarchical reduction (cf hierarchical_reduce_n). root is a rank in t.comm()
+    bool reduce(node_topology const &t, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
+      pos = 0;
+      hierarchical_reduce_n(buffer.data(), buffer.size(), t, root, all, op);
+      return (all or t.comm().rank() == root);
+    }
+  };
+
+  /// Reduce in place the data of x (e.g. a std::vector of gf), with a single collective
+  template <typename X> void mpi_reduce_in_place_packed(X &x, communicator c = {}, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
+    packed_reduce<packed_value_t<X>> p;
+    p.pack(x);
+    if (p.reduce(c, root, all, op)) p.unpack(x);
+  }
+
+  /// Hierarchical version of mpi_reduce_in_place_packed, cf hierarchical_reduce_n
+  template <typename X> void mpi_reduce_in_place_packed(X &x, node_topology const &t, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
+    packed_reduce<packed_value_t<X>> p;
+    p.pack(x);
+    if (p.reduce(t, root, all, op)) p.unpack(x);
+  }
+
+  /**
+   * Non-blocking version of mpi_reduce_in_place_packed.
+   * The result is copied back into x when the request is completed : x must not be used (nor destroyed) until then.
+   */
+  template <typename X> request mpi_ireduce_in_place_packed(X &x, communicator c = {}, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
+    auto p = std::make_shared<packed_reduce<packed_value_t<X>>>();
+    p->pack(x);
+    bool receive = (all or c.rank() == root);
+    return {p->start_ireduce(c, root, all, op), [p, &x, receive]() {
+              if (receive) p->unpack(x);
+            }};
+  }
+
+} // namespace triqs::mpi
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include "./base.hpp"
+#include "./chunked.hpp"
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace triqs::mpi {
+
+  /**
+   * Handle on a non-blocking collective operation, e.g. returned by mpi_ireduce
+   *
+   * The data involved in the operation must not be used (nor destroyed) until it is completed,
+   * i.e. until wait() returns or test() returns true.
+   * The destructor waits for the completion of the operation. It does not throw : an exception of the completion
+   * (e.g. of the copy back of a buffer) is rethrown by wait() or test(), and only reported on std::cerr by the destructor.
+   */
+  class request {
+    std::vector<MPI_Request> _reqs;
+    std::function<void()> _on_completion; // e.g. copy back a buffer, called once when completed
+    std::exception_ptr _error;            // thrown by _on_completion, rethrown by wait or test
+
+    void complete() noexcept {
+      if (!_on_completion) return;
+      try {
+        std::exchange(_on_completion, nullptr)();
+      } catch (...) { _error = std::current_exception(); }
+    }
+
+    void wait_noexcept() noexcept {
+      if (!_reqs.empty()) MPI_Waitall(_reqs.size(), _reqs.data(), MPI_STATUSES_IGNORE);
+      _reqs.clear();
+      complete();
+    }
+
+    void rethrow_error() {
+      if (_error) std::rethrow_exception(std::exchange(_error, nullptr));
+    }
+
+    public:
+    request() = default;
+
+    request(std::vector<MPI_Request> reqs, std::function<void()> on_completion = {})
+       : _reqs(std::move(reqs)), _on_completion(std::move(on_completion)) {}
+
+    request(request const &) = delete;
+    request(request &&x)
+       : _reqs(std::exchange(x._reqs, {})), _on_completion(std::exchange(x._on_completion, nullptr)), _error(std::exchange(x._error, nullptr)) {}
+
+    request &operator=(request const &) = delete;
+    request &operator=(request &&x) {
+      wait();
+      _reqs          = std::exchange(x._reqs, {});
+      _on_completion = std::exchange(x._on_completion, nullptr);
+      _error         = std::exchange(x._error, nullptr);
+      return *this;
+    }
+
+    ~request() {
+      wait_noexcept();
+      if (!_error) return;
+      try {
+        std::rethrow_exception(_error);
+      } catch (std::exception const &e) {
+        std::cerr << "mpi::request : error at the completion of the operation, lost in the destructor : " << e.what() << std::endl;
+      } catch (...) { std::cerr << "mpi::request : error at the completion of the operation, lost in the destructor" << std::endl; }
+    }
+
+    /// Block until the operation is completed. Rethrows an exception of the completion.
+    void wait() {
+      wait_noexcept();
+      rethrow_error();
+    }
+
+    /// Is the operation completed ? Does not block. Rethrows an exception of the completion.
+    bool test() {
+      if (!_reqs.empty()) {
+        int flag = 0;
+        MPI_Testall(_reqs.size(), _reqs.data(), &flag, MPI_STATUSES_IGNORE);
+        if (!flag) return false;
+        _reqs.clear();
+      }
+      complete();
+      rethrow_error();
+      return true;
+    }
+  };
+
+  namespace details {
+    // Start MPI_Ireduce (or MPI_Iallreduce if all) of n elements, in chunks of at most max_count elements. Cf reduce_n.
+    template <typename T>
+    std::vector<MPI_Request> start_ireduce(T const *in, T *out, long n, communicator c, int root, bool all, MPI_Op op) {
+      bool in_place = (in == out);
+      bool receive  = (all or c.rank() == root);
+      auto D        = mpi_datatype<T>();
+      std::vector<MPI_Request> reqs;
+      for (long k = 0; k < n; k += max_count) {
+        int m      = std::min(max_count, n - k);
+        void *in_k = (void *)(in + k), *out_k = (receive ? out + k : nullptr);
+        MPI_Request r;
+        if (!all)
+          MPI_Ireduce((in_place and receive ? MPI_IN_PLACE : in_k), out_k, m, D, op, root, c.get(), &r);
+        else
+          MPI_Iallreduce((in_place ? MPI_IN_PLACE : in_k), out_k, m, D, op, c.get(), &r);
+        reqs.push_back(r);
+      }
+      return reqs;
+    }
+  } // namespace details
+
+  /// Non-blocking version of reduce_n
+  template <typename T> request ireduce_n(T const *in, T *out, long n, communicator c = {}, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
+    return {details::start_ireduce(in, out, n, c, root, all, op)};
+  }
+
+  /// Non-blocking all reduce, for any x for which mpi_ireduce is defined
+  template <typename T> request mpi_iallreduce(T &&x, communicator c = {}, MPI_Op op = MPI_SUM) {
+    return mpi_ireduce(std::forward<T>(x), c, 0, true, op);
+  }
+
+} // namespace triqs::mpi
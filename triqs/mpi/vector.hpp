@@ -20,6 +20,8 @@
  ******************************************************************************/
 #pragma once
 #include "./base.hpp"
+#include "./chunked.hpp"
+#include "./packed.hpp"
 #include "../utility/view_tools.hpp"
 #include <vector>
 
@@ -32,7 +34,7 @@ namespace triqs::mpi {
     mpi_broadcast(s, c, root);
     if (c.rank() != root) v.resize(s);
     if constexpr (is_basic<T>::value) {
-      if (s != 0) MPI_Bcast(v.data(), v.size(), mpi_datatype<T>(), root, c.get());
+      broadcast_n(v.data(), s, c, root);
     } else {
       for (auto &x : v) mpi_broadcast(x, c, root);
     }
@@ -42,12 +44,11 @@ namespace triqs::mpi {
   template <typename T> void mpi_reduce_in_place(std::vector<T> &a, communicator c = {}, int root = 0, bool all = false, MPI_Op op = MPI_SUM) {
     if (a.size() == 0) return; // mpi behaviour not checked in that case.
     if constexpr (is_basic<T>::value) {
-      if (!all)
-        MPI_Reduce((c.rank() == root ? MPI_IN_PLACE : a.data()), a.data(), a.size(), mpi_datatype<T>(), op, root, c.get());
-      else
-        MPI_Allreduce(MPI_IN_PLACE, a.data(), a.size(), mpi_datatype<T>(), op, c.get());
+      reduce_n(a.data(), a.data(), a.size(), c, root, all, op);
+    } else if constexpr (is_packable_v<T>) {
+      mpi_reduce_in_place_packed(a, c, root, all, op); // all elements in one collective
     } else {
-      for (auto &x : a) mpi_reduce_in_place(a, c, root, all);
+      for (auto &x : a) mpi_reduce_in_place(x, c, root, all, op);
     }
   }
 
@@ -60,10 +61,12 @@ namespace triqs::mpi {
     if constexpr (is_basic<T>::value) {
       static_assert(std::is_same_v<Regular<T>, T>, "Internal error");
       std::vector<T> r(s);
-      if (!all)
-        MPI_Reduce((void *)a.data(), r.data(), s, mpi_datatype<T>(), op, root, c.get());
-      else
-        MPI_Allreduce((void *)a.data(), r.data(), s, mpi_datatype<T>(), op, c.get());
+      reduce_n(a.data(), r.data(), s, c, root, all, op);
+      return r;
+    } else if constexpr (is_packable_v<Regular<T>>) {
+      // e.g. vector of arrays, gf : all elements in one collective
+      std::vector<Regular<T>> r(a.begin(), a.end());
+      mpi_reduce_in_place_packed(r, c, root, all, op);
       return r;
     } else {
       std::vector<Regular<T>> r;
@@ -79,18 +82,17 @@ namespace triqs::mpi {
   template <typename T> std::vector<T> mpi_scatter(std::vector<T> const &a, communicator c = {}, int root = 0) {
 
     if constexpr (is_basic<T>::value) {
-      auto slow_size  = a.size();
-      auto sendcounts = std::vector<int>(c.size());
-      auto displs     = std::vector<int>(c.size() + 1, 0);
-      int recvcount   = slice_length(slow_size - 1, c.size(), c.rank());
-      std::vector<T> b(recvcount);
+      long slow_size  = a.size();
+      auto sendcounts = std::vector<long>(c.size());
+      auto displs     = std::vector<long>(c.size() + 1, 0);
+      std::vector<T> b(slice_length(slow_size - 1, c.size(), c.rank()));
 
       for (int r = 0; r < c.size(); ++r) {
         sendcounts[r] = slice_length(slow_size - 1, c.size(), r);
         displs[r + 1] = sendcounts[r] + displs[r];
       }
 
-      MPI_Scatterv((void *)a.data(), &sendcounts[0], &displs[0], mpi_datatype<T>(), (void *)b.data(), recvcount, mpi_datatype<T>(), root, c.get());
+      scatterv_n(a.data(), sendcounts, displs, b.data(), c, root);
       return b;
     }
 
@@ -108,25 +110,9 @@ namespace triqs::mpi {
   template <typename T> std::vector<T> mpi_gather(std::vector<T> const &a, communicator c = {}, int root = 0, bool all = false) {
 
     if constexpr (is_basic<T>::value) {
-      long size = mpi_reduce(a.size(), c, root, all);
-      std::vector<T> b((all || (c.rank() == root) ? size : 0));
-
-      auto recvcounts = std::vector<int>(c.size());
-      auto displs     = std::vector<int>(c.size() + 1, 0);
-      int sendcount   = a.size();
-      auto mpi_ty     = mpi::mpi_datatype<int>();
-      if (!all)
-        MPI_Gather(&sendcount, 1, mpi_ty, &recvcounts[0], 1, mpi_ty, root, c.get());
-      else
-        MPI_Allgather(&sendcount, 1, mpi_ty, &recvcounts[0], 1, mpi_ty, c.get());
-
-      for (int r = 0; r < c.size(); ++r) displs[r + 1] = recvcounts[r] + displs[r];
-
-      if (!all)
-        MPI_Gatherv((void *)a.data(), sendcount, mpi_datatype<T>(), (void *)b.data(), &recvcounts[0], &displs[0], mpi_datatype<T>(), root, c.get());
-      else
-        MPI_Allgatherv((void *)a.data(), sendcount, mpi_datatype<T>(), (void *)b.data(), &recvcounts[0], &displs[0], mpi_datatype<T>(), c.get());
-
+      auto [recvcounts, displs] = all_counts_and_displs(a.size(), c);
+      std::vector<T> b((all || (c.rank() == root) ? displs[c.size()] : 0));
+      gatherv_n(a.data(), a.size(), b.data(), recvcounts, displs, c, root, all);
       return b;
     }
 
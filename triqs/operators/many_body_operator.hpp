@@ -24,10 +24,14 @@
 #include <ostream>
 #include <cmath>
 #include <algorithm>
+#include <exception>
 #include <boost/operators.hpp>
 #include <triqs/utility/real_or_complex.hpp>
 #include <triqs/utility/numeric_ops.hpp>
 #include <triqs/h5.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace triqs {
   namespace operators {
@@ -37,6 +41,9 @@ namespace triqs {
     /// The generic class
     template <typename ScalarType> class many_body_operator_generic;
 
+    // The packed version, see packed_operator.hpp
+    template <typename ScalarType> class packed_operator_generic;
+
     /// The indices of the C, C^+ operators are a vector of int/string
     using indices_t = hilbert_space::fundamental_operator_set::indices_t;
 
@@ -77,6 +84,62 @@ namespace triqs {
     bool operator<(monomial_t const &m1, monomial_t const &m2);
     std::ostream &operator<<(std::ostream &os, monomial_t const &m);
 
+    //-----------------------------------------------------------------------------------------
+    namespace detail {
+
+      // Minimal number of pairs of monomials for a product to be computed in parallel
+      constexpr long parallel_product_threshold = 1 << 14;
+
+      // Move the terms of acc into res, adding the coefficients of the monomials present in both
+      template <typename Map> void merge_terms(Map &acc, Map &res) {
+        using triqs::utility::is_zero;
+        res.merge(acc); // transfer the nodes of new monomials, no allocation
+        for (auto &x : acc) {
+          auto it = res.find(x.first);
+          it->second += x.second;
+          if (is_zero(it->second)) res.erase(it);
+        }
+      }
+
+      /**
+    * Product of two maps of monomials a and b into res.
+    *
+    * make_worker() returns a callable w, and w(x, y, acc) accumulates the product of the terms x in a and y in b into the map acc.
+    * For a large product, a is cut into chunks processed by OpenMP threads, each with its own worker and accumulator.
+    * The accumulators are merged into res in the order of the chunks, so that the result does not depend on the scheduling.
+    */
+      template <typename Map, typename MakeWorker> void product_in_chunks(Map const &a, Map const &b, Map &res, MakeWorker make_worker) {
+#ifdef _OPENMP
+        if (long(a.size()) * long(b.size()) >= parallel_product_threshold and omp_get_max_threads() > 1 and !omp_in_parallel()) {
+          std::vector<typename Map::value_type const *> a_terms;
+          a_terms.reserve(a.size());
+          for (auto const &x : a) a_terms.push_back(&x);
+          std::vector<Map> acc(omp_get_max_threads());
+          // exceptions can not leave the parallel region : the first one is rethrown
+          std::exception_ptr error;
+#pragma omp parallel
+          {
+            long n_threads = omp_get_num_threads(), t = omp_get_thread_num(), n = a_terms.size();
+            try {
+              auto w = make_worker();
+              for (long i = (n * t) / n_threads; i < (n * (t + 1)) / n_threads; ++i)
+                for (auto const &y : b) w(*a_terms[i], y, acc[t]);
+            } catch (...) {
+#pragma omp critical
+              if (!error) error = std::current_exception();
+            }
+          }
+          if (error) std::rethrow_exception(error);
+          for (auto &x : acc) merge_terms(x, res);
+          return;
+        }
+#endif
+        auto w = make_worker();
+        for (auto const &x : a)
+          for (auto const &y : b) w(x, y, res);
+      }
+    } // namespace detail
+
     //-----------------------------------------------------------------------------------------
     /**
   * many_body_operator_generic is a general operator in second quantification
@@ -96,6 +159,9 @@ namespace triqs {
 
       monomials_map_t monomials;
 
+      // converts its normally ordered monomials directly
+      template <typename S> friend class packed_operator_generic;
+
       friend void h5_write(h5::group g, std::string const &name, many_body_operator const &op, hilbert_space::fundamental_operator_set const &fops);
       friend void h5_write(h5::group g, std::string const &name, many_body_operator_generic const &op) {
         h5_write(g, name, op, op.make_fundamental_operator_set());
@@ -251,17 +317,26 @@ namespace triqs {
 
       many_body_operator_generic &operator*=(many_body_operator_generic const &op) {
         monomials_map_t tmp_map; // product will be stored here
-        for (auto const &m : monomials)
-          for (auto const &op_m : op.monomials) {
-            // prepare an unnormalized product
-            monomial_t product_m;
-            product_m.reserve(m.first.size() + op_m.first.size());
-            for (auto const &op : m.first) product_m.push_back(op);
-            for (auto const &op : op_m.first) product_m.push_back(op);
-            // std::copy(m.first.begin(), m.first.end(), std::back_inserter(product_m));
-            // std::copy(op_m.first.begin(), op_m.first.end(), std::back_inserter(product_m));
-            normalize_and_insert(product_m, m.second * op_m.second, tmp_map);
-          }
+        detail::product_in_chunks(monomials, op.monomials, tmp_map, [] {
+          return [scratch = monomial_t{}](auto const &m, auto const &op_m, monomials_map_t &target) mutable {
+            int n = m.first.size() + op_m.first.size();
+            if (n <= max_stack_monomial_size) {
+              // the unnormalized product, as pointers to the C, C^+ of the factors
+              canonical_ops_t const *product_m[max_stack_monomial_size];
+              int k = 0;
+              for (auto const &op : m.first) product_m[k++] = &op;
+              for (auto const &op : op_m.first) product_m[k++] = &op;
+              normalize_and_insert(product_m, n, m.second * op_m.second, target, scratch);
+            } else {
+              // prepare an unnormalized product
+              monomial_t product_m;
+              product_m.reserve(n);
+              for (auto const &op : m.first) product_m.push_back(op);
+              for (auto const &op : op_m.first) product_m.push_back(op);
+              normalize_and_insert(product_m, m.second * op_m.second, target);
+            }
+          };
+        });
         std::swap(monomials, tmp_map);
         return *this;
       }
@@ -336,6 +411,47 @@ namespace triqs {
       template <class Archive> void serialize(Archive &ar, const unsigned int version) { ar &monomials; }
 
       private:
+      // Maximal size of a monomial normalized on the stack, without allocation
+      static constexpr int max_stack_monomial_size = 8;
+
+      // Normalize a monomial given as n pointers to its C, C^+ and insert into a map.
+      // Same algorithm as below, but the sort is done on a stack buffer of pointers,
+      // and the result is copied into scratch, so nothing is allocated unless the monomial is new in target.
+      static void normalize_and_insert(canonical_ops_t const *const *ops, int n, scalar_t coeff, monomials_map_t &target, monomial_t &scratch) {
+        canonical_ops_t const *m[max_stack_monomial_size];
+        std::copy(ops, ops + n, m);
+        bool is_swapped;
+        do {
+          is_swapped = false;
+          for (int k = 1; k < n; ++k) {
+            if (*m[k - 1] == *m[k]) return; // The monomial is effectively zero
+            if (*m[k - 1] > *m[k]) {
+              // Are we swapping C and C^+ with the same indices?
+              if (m[k - 1]->dagger != m[k]->dagger and m[k - 1]->indices == m[k]->indices) {
+                canonical_ops_t const *new_m[max_stack_monomial_size];
+                std::copy(m, m + k - 1, new_m);
+                std::copy(m + k + 1, m + n, new_m + k - 1);
+                normalize_and_insert(new_m, n - 2, coeff, target, scratch);
+              }
+              coeff = -coeff;
+              std::swap(m[k - 1], m[k]);
+              is_swapped = true;
+            }
+          }
+        } while (is_swapped);
+
+        // Insert the result
+        scratch.resize(n);
+        for (int k = 0; k < n; ++k) scratch[k] = *m[k];
+        auto it = target.find(scratch);
+        if (it == target.end())
+          target.insert({scratch, coeff});
+        else {
+          it->second += coeff;
+          erase_zero_monomial(target, it);
+        }
+      }
+
       // Normalize a monomial and insert into a map
       static void normalize_and_insert(monomial_t m, scalar_t coeff, monomials_map_t &target) {
         // The normalization is done by employing a simple bubble sort algorithms.
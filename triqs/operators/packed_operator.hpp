@@ -0,0 +1,358 @@
+/*******************************************************************************
+ *
+ * TRIQS: a Toolbox for Research in Interacting Quantum Systems
+ *
+ * Copyright (C) 2019 by I. Krivenko, O. Parcollet
+ *
+ * TRIQS is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * TRIQS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * TRIQS. If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#pragma once
+#include "./many_body_operator.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace triqs {
+  namespace operators {
+
+    using hilbert_space::fundamental_operator_set;
+
+    /// The generic class
+    template <typename ScalarType> class packed_operator_generic;
+
+    /// The user class
+    using packed_operator         = packed_operator_generic<real_or_complex>;
+    using packed_operator_real    = packed_operator_generic<double>;
+    using packed_operator_complex = packed_operator_generic<std::complex<double>>;
+
+    //-----------------------------------------------------------------------------------------
+
+    /**
+  * A monomial packed into a single 64-bit word.
+  *
+  * The C, C^+ operators are interned through a fundamental_operator_set: the operator with
+  * linear index n is encoded as one byte, n + 1 for C^+ and 255 - n for C (0 means: no operator).
+  * With this encoding the order of the bytes is the canonical order of canonical_ops_t
+  * (c+_1 < c+_2 < ... < c_2 < c_1), and x -> 256 - x flips C <-> C^+.
+  * Byte k of the word holds the k-th operator of the monomial.
+  */
+    struct packed_monomial_t {
+      std::uint64_t word = 0;
+
+      /// Maximal number of C, C^+ in a monomial
+      static constexpr int max_size = 8;
+
+      /// Maximal size of the fundamental_operator_set
+      static constexpr int max_fops_size = 127;
+
+      static std::uint8_t encode(bool dagger, int linear_index) { return dagger ? 1 + linear_index : 255 - linear_index; }
+      static bool is_dagger(std::uint8_t x) { return x < 128; }
+      static int linear_index(std::uint8_t x) { return is_dagger(x) ? x - 1 : 255 - x; }
+
+      /// Number of operators in the monomial
+      int size() const {
+        int n = 0;
+        for (auto w = word; w != 0; w >>= 8) ++n;
+        return n;
+      }
+
+      std::uint8_t operator[](int k) const { return (word >> (8 * k)) & 0xFF; }
+
+      /// Pack n bytes
+      static packed_monomial_t pack(std::uint8_t const *ops, int n) {
+        packed_monomial_t m;
+        for (int k = 0; k < n; ++k) m.word |= std::uint64_t(ops[k]) << (8 * k);
+        return m;
+      }
+
+      /// Unpack into ops, return the size
+      int unpack(std::uint8_t *ops) const {
+        int n = 0;
+        for (auto w = word; w != 0; w >>= 8) ops[n++] = w & 0xFF;
+        return n;
+      }
+
+      friend bool operator==(packed_monomial_t const &a, packed_monomial_t const &b) { return a.word == b.word; }
+      friend bool operator!=(packed_monomial_t const &a, packed_monomial_t const &b) { return a.word != b.word; }
+    };
+
+    // A mixing hash (splitmix64 finalizer): monomial words differ only in a few low bits
+    struct packed_monomial_hash {
+      std::size_t operator()(packed_monomial_t const &m) const {
+        std::uint64_t x = m.word;
+        x               = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x               = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+      }
+    };
+
+    //-----------------------------------------------------------------------------------------
+    /**
+  * packed_operator_generic is a general operator in second quantification,
+  * with the same algebra as many_body_operator_generic, but with a compact storage.
+  *
+  * The indices of the C, C^+ are interned through a fundamental_operator_set shared by all
+  * the operators of a computation (at most 127 elements), monomials are packed into one word
+  * (at most 8 operators) and stored in a hash map. Products and normal ordering work
+  * on the packed words, without any heap allocation per monomial, and large products
+  * are computed in parallel (OpenMP) like for many_body_operator_generic.
+  *
+  * It is meant to build large operators (e.g. Hamiltonians with a full U_ijkl tensor) fast,
+  * and convert them to a many_body_operator_generic at the end.
+  */
+    template <typename ScalarType>
+    class packed_operator_generic :
+       // implements vector space over ScalarType operators
+       boost::additive<packed_operator_generic<ScalarType>>,
+       boost::multipliable<packed_operator_generic<ScalarType>>,
+       boost::additive<packed_operator_generic<ScalarType>, ScalarType>,     // op+a a+op op-a
+       boost::multipliable<packed_operator_generic<ScalarType>, ScalarType>, // op*a a*op op/a
+       boost::dividable<packed_operator_generic<ScalarType>, ScalarType> {
+
+      public:
+      using scalar_t        = ScalarType;
+      using fops_ptr_t      = std::shared_ptr<fundamental_operator_set const>;
+      using monomials_map_t = std::unordered_map<packed_monomial_t, scalar_t, packed_monomial_hash>;
+
+      private:
+      fops_ptr_t fops;
+      monomials_map_t monomials;
+
+      static fops_ptr_t check_fops(fops_ptr_t f) {
+        if (f and f->size() > packed_monomial_t::max_fops_size)
+          TRIQS_RUNTIME_ERROR << "packed_operator : the fundamental_operator_set has " << f->size() << " elements, at most "
+                              << packed_monomial_t::max_fops_size << " are supported";
+        return f;
+      }
+
+      public:
+      /// Construct a zero operator. The fundamental_operator_set is taken from the first operator combined with this one.
+      packed_operator_generic() = default;
+
+      /// Construct a zero operator on a fundamental_operator_set
+      explicit packed_operator_generic(fops_ptr_t f) : fops(check_fops(std::move(f))) {}
+
+      /// Construct a constant operator
+      explicit packed_operator_generic(scalar_t const &x, fops_ptr_t f = {}) : fops(check_fops(std::move(f))) {
+        using triqs::utility::is_zero;
+        if (!is_zero(x)) monomials.insert({packed_monomial_t{}, x});
+      }
+
+      /// Construct from a many_body_operator_generic, all its C, C^+ must belong to the fundamental_operator_set
+      template <typename S> packed_operator_generic(many_body_operator_generic<S> const &op, fops_ptr_t f) : fops(check_fops(std::move(f))) {
+        static_assert(std::is_constructible<scalar_t, S>::value, "Construction is impossible");
+        std::uint8_t ops[packed_monomial_t::max_size];
+        monomials.reserve(op.get_monomials().size());
+        for (auto const &m : op.get_monomials()) {
+          if (m.first.size() > packed_monomial_t::max_size)
+            TRIQS_RUNTIME_ERROR << "packed_operator : monomial " << m.first << " has more than " << packed_monomial_t::max_size << " operators";
+          int n = 0;
+          for (auto const &c_cdag_op : m.first) ops[n++] = packed_monomial_t::encode(c_cdag_op.dagger, (*fops)[c_cdag_op.indices]);
+          monomials.insert({packed_monomial_t::pack(ops, n), scalar_t(m.second)});
+        }
+      }
+
+      // factory for c, cdag
+      static packed_operator_generic make_canonical(fops_ptr_t f, bool is_dag, indices_t const &indices) {
+        packed_operator_generic res(std::move(f));
+        std::uint8_t op = packed_monomial_t::encode(is_dag, (*res.fops)[indices]);
+        res.monomials.insert({packed_monomial_t::pack(&op, 1), scalar_t(1)});
+        return res;
+      }
+
+      /// The fundamental_operator_set interning the indices
+      fops_ptr_t const &get_fundamental_operator_set() const { return fops; }
+
+      // internal
+      monomials_map_t const &get_monomials() const { return monomials; }
+
+      /// Maximal number of C, C^+ in a monomial of the operator
+      int max_size() const {
+        int r = 0;
+        for (auto const &m : monomials) r = std::max(r, m.first.size());
+        return r;
+      }
+
+      /// Reserve space for n monomials
+      void reserve(std::size_t n) { monomials.reserve(n); }
+
+      /// Number of monomials
+      std::size_t size() const { return monomials.size(); }
+
+      // Is zero operator ?
+      bool is_zero() const { return monomials.empty(); }
+
+      /// Convert back to a many_body_operator_generic
+      many_body_operator_generic<scalar_t> to_many_body_operator() const {
+        many_body_operator_generic<scalar_t> res;
+        if (monomials.empty()) return res;
+        auto r_fops = fops ? fops->reverse_map() : std::vector<indices_t>{};
+        std::uint8_t ops[packed_monomial_t::max_size];
+        for (auto const &m : monomials) {
+          int n = m.first.unpack(ops);
+          monomial_t monomial;
+          monomial.reserve(n);
+          for (int k = 0; k < n; ++k) monomial.push_back({packed_monomial_t::is_dagger(ops[k]), r_fops[packed_monomial_t::linear_index(ops[k])]});
+          res.monomials.insert({std::move(monomial), m.second});
+        }
+        return res;
+      }
+
+      // Algebraic operations involving scalar_t constants
+      packed_operator_generic operator-() const {
+        auto res = *this;
+        for (auto &m : res.monomials) m.second = -m.second;
+        return res;
+      }
+
+      packed_operator_generic &operator+=(scalar_t alpha) {
+        using triqs::utility::is_zero;
+        if (!is_zero(alpha)) insert(packed_monomial_t{}, alpha, monomials);
+        return *this;
+      }
+
+      packed_operator_generic &operator-=(scalar_t alpha) { return operator+=(-alpha); }
+
+      friend packed_operator_generic operator-(scalar_t alpha, packed_operator_generic const &op) { return -op + alpha; }
+
+      packed_operator_generic &operator*=(scalar_t alpha) {
+        using triqs::utility::is_zero;
+        if (is_zero(alpha)) {
+          monomials.clear();
+        } else {
+          for (auto &m : monomials) m.second *= alpha;
+        }
+        return *this;
+      }
+
+      packed_operator_generic &operator/=(scalar_t alpha) { return operator*=(scalar_t(1) / alpha); }
+
+      // Algebraic operations
+      packed_operator_generic &operator+=(packed_operator_generic const &op) {
+        merge_fops(op);
+        for (auto const &m : op.monomials) insert(m.first, m.second, monomials);
+        return *this;
+      }
+
+      packed_operator_generic &operator-=(packed_operator_generic const &op) {
+        merge_fops(op);
+        for (auto const &m : op.monomials) insert(m.first, -m.second, monomials);
+        return *this;
+      }
+
+      packed_operator_generic &operator*=(packed_operator_generic const &op) {
+        merge_fops(op);
+        if (monomials.size() * op.monomials.size() > 0 and max_size() + op.max_size() > packed_monomial_t::max_size)
+          TRIQS_RUNTIME_ERROR << "packed_operator : product produces a monomial with more than " << packed_monomial_t::max_size << " operators";
+        monomials_map_t tmp_map; // product will be stored here
+        detail::product_in_chunks(monomials, op.monomials, tmp_map, [] {
+          return [](auto const &m, auto const &op_m, monomials_map_t &target) {
+            std::uint8_t product_m[packed_monomial_t::max_size];
+            int n1 = m.first.unpack(product_m);
+            int n  = n1 + op_m.first.unpack(product_m + n1);
+            normalize_and_insert(product_m, n, m.second * op_m.second, target);
+          };
+        });
+        std::swap(monomials, tmp_map);
+        return *this;
+      }
+
+      bool operator==(packed_operator_generic const &op) const { return (*this - op).is_zero(); }
+
+      // dagger. The Hermitian conjugate of a normally ordered monomial is normally ordered.
+      friend packed_operator_generic dagger(packed_operator_generic const &op) {
+        packed_operator_generic res(op.fops);
+        res.monomials.reserve(op.monomials.size());
+        using triqs::utility::conj;
+        std::uint8_t ops[packed_monomial_t::max_size], dag_ops[packed_monomial_t::max_size];
+        for (auto const &m : op.monomials) {
+          int n = m.first.unpack(ops);
+          for (int k = 0; k < n; ++k) dag_ops[k] = 256 - ops[n - 1 - k];
+          res.monomials.insert({packed_monomial_t::pack(dag_ops, n), conj(m.second)});
+        }
+        return res;
+      }
+
+      private:
+      // Operators combined together must share their fundamental_operator_set
+      void merge_fops(packed_operator_generic const &op) {
+        if (!op.fops or fops == op.fops) return;
+        if (!fops)
+          fops = op.fops;
+        else if (!(*fops == *op.fops))
+          TRIQS_RUNTIME_ERROR << "packed_operator : can not combine operators built on different fundamental_operator_sets";
+      }
+
+      // Insert a normally ordered monomial into a map
+      static void insert(packed_monomial_t m, scalar_t const &coeff, monomials_map_t &target) {
+        using triqs::utility::is_zero;
+        auto r = target.insert({m, coeff});
+        if (!r.second) {
+          r.first->second += coeff;
+          if (is_zero(r.first->second)) target.erase(r.first);
+        }
+      }
+
+      // Normalize a product of n C, C^+ and insert it into a map.
+      // Same bubble sort as many_body_operator_generic::normalize_and_insert, on bytes in a stack buffer.
+      static void normalize_and_insert(std::uint8_t const *ops_in, int n, scalar_t coeff, monomials_map_t &target) {
+        std::uint8_t m[packed_monomial_t::max_size];
+        std::copy(ops_in, ops_in + n, m);
+        bool is_swapped;
+        do {
+          is_swapped = false;
+          for (int k = 1; k < n; ++k) {
+            if (m[k - 1] == m[k]) return; // The monomial is effectively zero
+            if (m[k - 1] > m[k]) {
+              // Are we swapping C and C^+ with the same indices?
+              if (m[k - 1] + m[k] == 256) {
+                std::uint8_t new_m[packed_monomial_t::max_size];
+                std::copy(m, m + k - 1, new_m);
+                std::copy(m + k + 1, m + n, new_m + k - 1);
+                normalize_and_insert(new_m, n - 2, coeff, target);
+              }
+              coeff = -coeff;
+              std::swap(m[k - 1], m[k]);
+              is_swapped = true;
+            }
+          }
+        } while (is_swapped);
+        insert(packed_monomial_t::pack(m, n), coeff, target);
+      }
+
+      // Print via the many_body_operator_generic, which has ordered monomials
+      friend std::ostream &operator<<(std::ostream &os, packed_operator_generic const &op) { return os << op.to_many_body_operator(); }
+    };
+
+    // ---- factories --------------
+
+    // Free functions to make creation/annihilation operators on a fundamental_operator_set
+    template <typename scalar_t = real_or_complex, typename... IndexTypes>
+    packed_operator_generic<scalar_t> packed_c(std::shared_ptr<fundamental_operator_set const> fops, IndexTypes... indices) {
+      return packed_operator_generic<scalar_t>::make_canonical(std::move(fops), false, indices_t{indices...});
+    }
+
+    template <typename scalar_t = real_or_complex, typename... IndexTypes>
+    packed_operator_generic<scalar_t> packed_c_dag(std::shared_ptr<fundamental_operator_set const> fops, IndexTypes... indices) {
+      return packed_operator_generic<scalar_t>::make_canonical(std::move(fops), true, indices_t{indices...});
+    }
+
+    template <typename scalar_t = real_or_complex, typename... IndexTypes>
+    packed_operator_generic<scalar_t> packed_n(std::shared_ptr<fundamental_operator_set const> fops, IndexTypes... indices) {
+      return packed_c_dag<scalar_t>(fops, indices...) * packed_c<scalar_t>(fops, indices...);
+    }
+  } // namespace operators
+} // namespace triqs
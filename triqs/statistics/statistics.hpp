@@ -297,21 +297,21 @@ namespace triqs {
     // -------------   empirical average and variance --------------------------
 
     template <typename TimeSeries> typename TimeSeries::value_type empirical_average(TimeSeries const &t) {
-      auto si = t.size();
+      long si = t.size();
       if (si == 0) return typename TimeSeries::value_type{};
       auto sum = t[0];
-      for (int i = 1; i < si; ++i) sum += t[i];
+      for (long i = 1; i < si; ++i) sum += t[i];
       return sum / t.size();
     }
 
     ///
     template <typename TimeSeries> typename TimeSeries::value_type empirical_variance(TimeSeries const &t) {
-      auto si = t.size();
+      long si = t.size();
       if (si == 0) return typename TimeSeries::value_type{};
 
       auto avg           = empirical_average(t);
       decltype(avg) sum2 = (t[0] - avg) * (t[0] - avg); // also valid if t[0] is an array e.g., i.e. no trivial contructor...
-      for (int i = 1; i < si; ++i) sum2 += (t[i] - avg) * (t[i] - avg);
+      for (long i = 1; i < si; ++i) sum2 += (t[i] - avg) * (t[i] - avg);
       return sum2 / t.size();
     }
 
@@ -392,7 +392,8 @@ namespace triqs {
       auto normalized_autocorr = make_normalized_autocorrelation(make_immutable_time_series(a)); // is a N*dim_f matrix...
       double t_int             = normalized_autocorr[0];                                         // in principle, a vector dim_f
       double coeff_tau         = 6;                                                              // if exponential decay -> 0.25 % precision
-      for (int l_max = 1; l_max < coeff_tau * t_int; l_max++) t_int += normalized_autocorr[l_max];
+      long size                = normalized_autocorr.size();
+      for (long l_max = 1; l_max < coeff_tau * t_int and l_max < size; l_max++) t_int += normalized_autocorr[l_max];
       return int(t_int);
     }
 
@@ -22,6 +22,7 @@
 #include "./first_include.hpp"
 #include <vector>
 #include <functional>
+#include <utility>
 
 namespace triqs {
   namespace utility {
@@ -65,6 +66,15 @@ namespace triqs {
         return buffer[index];
       }
 
+      /// The buffer and the index of the next element, e.g. to save the state of the generator
+      std::pair<std::vector<R>, size_t> get_buffer() const { return {buffer, index}; }
+
+      /// Restore a buffer and an index obtained with get_buffer. The buffer must not be empty.
+      void set_buffer(std::vector<R> buf, size_t idx) {
+        buffer = std::move(buf);
+        index  = idx;
+      }
+
       private:
       size_t index;
       std::vector<R> buffer;